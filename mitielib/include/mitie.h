@@ -61,6 +61,66 @@ extern "C"
               it by calling mitie_free() on the pointer to the string.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_mapped_document mitie_mapped_document;
+
+    MITIE_EXPORT mitie_mapped_document* mitie_open_mapped_document (
+        const char* filename
+    );
+    /*!
+        requires
+            - filename == a valid pointer to a NULL terminated C string
+        ensures
+            - Opens the given file and returns a handle that gives direct access to its
+              contents via mitie_mapped_document_text() and mitie_mapped_document_length().
+              Unlike mitie_load_entire_file(), the contents are not copied.  Regular files
+              are memory mapped with a hint to the operating system that they will be
+              read sequentially, so even very large files can be processed without
+              loading them into memory.  Other kinds of files (e.g. pipes) can't be
+              mapped and are read into memory instead.
+            - The contents can be given directly to mitie_tokenize_spans(),
+              mitie_extract_entities_from_spans(), mitie_categorize_text_from_spans(), and
+              mitie_process_mapped_document().
+            - The returned object MUST BE FREED by a call to mitie_free().  Doing so
+              invalidates the pointer returned by mitie_mapped_document_text().
+            - If the file can't be opened, or its length doesn't fit in an unsigned long,
+              then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT const char* mitie_mapped_document_text (
+        const mitie_mapped_document* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns a pointer to the contents of the file.  Note that the contents are
+              NOT NULL terminated, use mitie_mapped_document_length() to find where they
+              end.  The memory is owned by doc so do not free it.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_mapped_document_length (
+        const mitie_mapped_document* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns the number of bytes in the file.
+    !*/
+
+    MITIE_EXPORT int mitie_mapped_document_is_memory_mapped (
+        const mitie_mapped_document* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns 1 if the file is memory mapped and 0 if it was read into memory
+              instead.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     MITIE_EXPORT char** mitie_tokenize (
@@ -117,6 +177,41 @@ extern "C"
               them by calling mitie_free().
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    MITIE_EXPORT unsigned long mitie_tokenize_spans (
+        const char* text,
+        unsigned long text_length,
+        unsigned long* spans,
+        unsigned long max_tokens
+    );
+    /*!
+        requires
+            - text == a pointer to at least text_length bytes.  The text does not need to
+              be NULL terminated.
+            - if (max_tokens != 0) then
+                - spans == a pointer to an array of at least 2*max_tokens unsigned longs.
+        ensures
+            - Tokenizes text exactly like mitie_tokenize() but instead of copying the
+              tokens out it only records where each token is in text.  No memory is
+              allocated by this function.
+            - returns the number of tokens in text, regardless of max_tokens.
+            - The locations of the first min(max_tokens, returned value) tokens are stored
+              into spans.  In particular, the i-th token is composed of the bytes
+              text[spans[2*i]] through text[spans[2*i+1]-1].  Moreover, spans[2*i] is the
+              same offset that mitie_tokenize_with_offsets() reports for that token.
+            - You can find out how big of an array you need by calling
+              mitie_tokenize_spans(text, text_length, NULL, 0), allocating an array of
+              twice the returned number of unsigned longs, and then calling this function
+              again.
+            - There is one case where the bytes in a span are not identical to the token
+              mitie_tokenize() would output.  When a UTF-8 ’ character is split off the end
+              of a word (e.g. It’s becomes It and ’s) mitie_tokenize() replaces the ’ with
+              an ASCII ' character.  The *_from_spans() routines below know about this and
+              perform the same replacement, so they see exactly the tokens mitie_tokenize()
+              would produce.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     MITIE_EXPORT mitie_named_entity_extractor* mitie_load_named_entity_extractor (
@@ -256,6 +351,28 @@ extern "C"
             - If the object can't be created then this function returns NULL
     !*/
 
+    MITIE_EXPORT mitie_named_entity_detections* mitie_extract_entities_from_spans (
+        const mitie_named_entity_extractor* ner,
+        const char* text,
+        const unsigned long* spans,
+        unsigned long num_tokens
+    );
+    /*!
+        requires
+            - ner != NULL
+            - spans == an array of 2*num_tokens token locations in text, as output by
+              mitie_tokenize_spans().  It may also be any contiguous sub-range of the
+              spans for text (e.g. one sentence) as long as it doesn't begin in the
+              middle of a word.
+        ensures
+            - This function is identical to mitie_extract_entities() except that it takes
+              the tokens as locations within text rather than as an array of C strings.
+              That is, it runs NER on the tokens text[spans[2*i]] through
+              text[spans[2*i+1]-1] for all i < num_tokens.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL
+    !*/
+
     MITIE_EXPORT unsigned long mitie_ner_get_num_detections (
         const mitie_named_entity_detections* dets
     );
@@ -578,6 +695,390 @@ extern "C"
                 - *score == the confidence the categorizer has about its prediction.
     !*/
 
+    MITIE_EXPORT int mitie_categorize_text_from_spans (
+        const mitie_text_categorizer* tcat,
+        const char* text,
+        const unsigned long* spans,
+        unsigned long num_tokens,
+        char** text_tag,
+        double* text_score
+    );
+    /*!
+        requires
+            - tcat != NULL
+            - spans == an array of 2*num_tokens token locations in text, as output by
+              mitie_tokenize_spans().
+            - text_tag != NULL
+            - text_score != NULL
+        ensures
+            - This function is identical to mitie_categorize_text() except that it takes
+              the tokens as locations within text rather than as an array of C strings.
+            - returns 0 upon success and a non-zero value on failure.
+            - text_tag MUST BE FREED by a call to mitie_free().
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_document_pipeline mitie_document_pipeline;
+    typedef struct mitie_document_analysis mitie_document_analysis;
+
+    MITIE_EXPORT mitie_document_pipeline* mitie_create_document_pipeline (
+        const mitie_named_entity_extractor* ner
+    );
+    /*!
+        requires
+            - ner != NULL
+        ensures
+            - Creates a document pipeline that runs ner on each document it is given.  You can add relation detectors and text categorizers to the pipeline
+              with mitie_document_pipeline_add_binary_relation_detector() and
+              mitie_document_pipeline_add_text_categorizer().  Then a single call to
+              mitie_process_document() tokenizes a document and runs all these models on
+              it.  This is faster than calling each model separately because the word
+              features for each token are computed only once and shared by all the models.
+            - The pipeline does not copy ner, or any of the models added to it, but only
+              refers to them.  So you must not free any of them until after you have
+              freed the pipeline.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT int mitie_document_pipeline_add_binary_relation_detector (
+        mitie_document_pipeline* pipeline,
+        const mitie_binary_relation_detector* detector
+    );
+    /*!
+        requires
+            - pipeline != NULL
+            - detector != NULL
+        ensures
+            - Adds detector to the pipeline.  The detector is given the index
+              mitie_document_pipeline_num_binary_relation_detectors(pipeline)-1.
+            - returns 0 upon success and a non-zero value on failure.  Failure happens if
+              detector was not trained with the NER used to create the pipeline.
+            - detector MUST NOT BE FREED until after pipeline is freed.
+    !*/
+
+    MITIE_EXPORT int mitie_document_pipeline_add_text_categorizer (
+        mitie_document_pipeline* pipeline,
+        const mitie_text_categorizer* tcat
+    );
+    /*!
+        requires
+            - pipeline != NULL
+            - tcat != NULL
+        ensures
+            - Adds tcat to the pipeline.  The categorizer is given the index
+              mitie_document_pipeline_num_text_categorizers(pipeline)-1.
+            - returns 0 upon success and a non-zero value on failure.
+            - tcat MUST NOT BE FREED until after pipeline is freed.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_pipeline_num_binary_relation_detectors (
+        const mitie_document_pipeline* pipeline
+    );
+    /*!
+        requires
+            - pipeline != NULL
+        ensures
+            - returns the number of relation detectors added to the pipeline.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_pipeline_num_text_categorizers (
+        const mitie_document_pipeline* pipeline
+    );
+    /*!
+        requires
+            - pipeline != NULL
+        ensures
+            - returns the number of text categorizers added to the pipeline.
+    !*/
+
+    MITIE_EXPORT void mitie_document_pipeline_set_sentence_splitting (
+        mitie_document_pipeline* pipeline,
+        int enabled
+    );
+    /*!
+        requires
+            - pipeline != NULL
+        ensures
+            - if (enabled != 0) then
+                - mitie_process_document() will first break the text into sentences
+                  and then run the named entity extractor and relation detectors on each
+                  sentence separately.  Relations are therefore only reported between
+                  entities in the same sentence.  Text categorizers still see the whole
+                  document.
+            - else
+                - mitie_process_document() treats the whole text as one sentence.  This
+                  is the default.
+    !*/
+
+    MITIE_EXPORT mitie_document_analysis* mitie_process_document (
+        const mitie_document_pipeline* pipeline,
+        const char* text
+    );
+    /*!
+        requires
+            - pipeline != NULL
+            - text == a valid pointer to a NULL terminated C string
+        ensures
+            - Tokenizes text exactly as mitie_tokenize_with_offsets() would, then finds all
+              the named entities in it, runs each relation detector on every pair of
+              adjacent entities (in both argument orders), and runs each text categorizer
+              on the whole document.  All the results are returned in one object which
+              you can query with the mitie_document_*() routines below.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If something prevents this function from succeeding then a NULL is returned.
+    !*/
+
+    MITIE_EXPORT mitie_document_analysis* mitie_process_mapped_document (
+        const mitie_document_pipeline* pipeline,
+        const mitie_mapped_document* doc
+    );
+    /*!
+        requires
+            - pipeline != NULL
+            - doc != NULL
+        ensures
+            - This function is identical to mitie_process_document() except that it
+              processes the contents of doc in place.  The token offsets are byte offsets
+              into the file.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_num_tokens (
+        const mitie_document_analysis* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns the number of tokens in the document.
+    !*/
+
+    MITIE_EXPORT const char* mitie_document_get_token (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_tokens(doc)
+        ensures
+            - returns the idx-th token as a NULL terminated C string.  The string is owned
+              by doc, so do not free it.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_token_offset (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_tokens(doc)
+        ensures
+            - returns the character offset into the original text of the first character
+              of the idx-th token.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_num_sentences (
+        const mitie_document_analysis* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns the number of sentences in the document.  If sentence splitting was
+              not enabled then this is 1, or 0 for a document without any tokens.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_sentence_position (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_sentences(doc)
+        ensures
+            - returns the index of the first token in the idx-th sentence.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_sentence_length (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_sentences(doc)
+        ensures
+            - returns the number of tokens in the idx-th sentence.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_num_entities (
+        const mitie_document_analysis* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns the number of named entities found in the document.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_entity_position (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_entities(doc)
+        ensures
+            - returns the token index of the first token in the idx-th entity.  Entities
+              are listed in the order they appear in the document.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_entity_length (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_entities(doc)
+        ensures
+            - returns the number of tokens in the idx-th entity.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_entity_tag (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_entities(doc)
+        ensures
+            - returns the tag ID of the idx-th entity.  It has the same meaning as the
+              output of mitie_ner_get_detection_tag().  So you can get the text name of
+              the tag by passing it to mitie_get_named_entity_tagstr() along with the
+              named entity extractor used to create the pipeline.
+    !*/
+
+    MITIE_EXPORT double mitie_document_get_entity_score (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_entities(doc)
+        ensures
+            - returns the confidence score of the idx-th entity.  It has the same meaning
+              as the output of mitie_ner_get_detection_score().
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_num_relations (
+        const mitie_document_analysis* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns the number of binary relations found in the document.  A relation
+              is reported only if its detector gave it a score > 0.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_relation_arg1 (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_relations(doc)
+        ensures
+            - returns the entity index (i.e. a value < mitie_document_num_entities(doc))
+              of the first argument of the idx-th relation.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_relation_arg2 (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_relations(doc)
+        ensures
+            - returns the entity index of the second argument of the idx-th relation.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_get_relation_detector (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_relations(doc)
+        ensures
+            - returns the index of the relation detector, within the pipeline that
+              created doc, which found the idx-th relation.  You can get the type of the
+              relation by calling mitie_binary_relation_detector_name_string() on that
+              detector.
+    !*/
+
+    MITIE_EXPORT double mitie_document_get_relation_score (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_relations(doc)
+        ensures
+            - returns the score the relation detector gave the idx-th relation.  This
+              value is always > 0.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_num_categories (
+        const mitie_document_analysis* doc
+    );
+    /*!
+        requires
+            - doc != NULL
+        ensures
+            - returns the number of text categorizers that were run on the document.
+              This is equal to the number of text categorizers in the pipeline that
+              created doc.
+    !*/
+
+    MITIE_EXPORT const char* mitie_document_get_category_tag (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_categories(doc)
+        ensures
+            - returns the category predicted by the idx-th text categorizer of the
+              pipeline.  The string is owned by doc, so do not free it.
+    !*/
+
+    MITIE_EXPORT double mitie_document_get_category_score (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - doc != NULL
+            - idx < mitie_document_num_categories(doc)
+        ensures
+            - returns the confidence the idx-th text categorizer has in its prediction.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 //                                      TRAINING ROUTINES
@@ -672,6 +1173,167 @@ extern "C"
     !*/
 
 // ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_training_options mitie_training_options;
+
+    typedef struct
+    {
+        /*!
+            This is the progress report given to a mitie_training_progress_callback.
+            Training happens in phases that run one after another.  They are named
+            "segmenter parameter search", "segmenter training" (these two only happen
+            when training a named entity extractor), "classifier parameter search", and
+            "classifier training".  The parameter searches cross-validate a model for
+            each parameter setting they try and take up nearly all the training time.
+        !*/
+
+        /* The name of the current phase. */
+        const char* phase;
+        /* 0 when a phase begins.  After that, the number of parameter settings the
+           search has evaluated, or 1 once a training phase is done. */
+        unsigned long iteration;
+        /* The cross-validation score of the parameters that were just evaluated, or the
+           score of a finished model on its training data.  Higher is better.
+           best_objective is the largest objective seen so far in this phase. */
+        double objective;
+        double best_objective;
+        /* Seconds since training started. */
+        double elapsed_seconds;
+        /* An estimate of the seconds left in this phase, or -1 if there isn't one. */
+        double eta_seconds;
+        /* The number of bytes of RAM the process is using, or 0 if unknown. */
+        unsigned long long memory_usage;
+    } mitie_training_progress;
+
+    typedef void (*mitie_training_progress_callback)(
+        const mitie_training_progress* progress,
+        void* context
+    );
+    /*!
+        This is the type of function that receives progress reports from the trainers.
+        context is the pointer given to mitie_training_options_set_progress_callback().
+        progress and the strings in it are only valid until the callback returns.  The
+        callback may be called from a thread other than the one that started training,
+        but never from two threads at once.
+    !*/
+
+    MITIE_EXPORT mitie_training_options* mitie_create_training_options (
+    );
+    /*!
+        ensures
+            - Creates an object that holds limits on how long training runs and an
+              optional progress callback.  Give it to a trainer with
+              mitie_ner_trainer_set_training_options(),
+              mitie_binary_relation_trainer_set_training_options(), or
+              mitie_text_categorizer_trainer_set_training_options().
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - returns NULL if the object could not be created.
+            - Initially there are no limits and no progress callback.  That is, all the
+              getters below return 0.
+    !*/
+
+    MITIE_EXPORT void mitie_training_options_set_max_wall_time (
+        mitie_training_options* options,
+        double seconds
+    );
+    /*!
+        requires
+            - options != NULL
+            - seconds >= 0
+        ensures
+            - mitie_training_options_get_max_wall_time(options) == seconds
+    !*/
+
+    MITIE_EXPORT double mitie_training_options_get_max_wall_time (
+        const mitie_training_options* options
+    );
+    /*!
+        requires
+            - options != NULL
+        ensures
+            - returns the number of seconds training may spend on parameter searches, or
+              0 if there is no limit.  When the time is up the trainer stops searching
+              and uses the best parameters found so far.  The final models are still
+              trained after that, so training takes longer than this by the time that
+              takes.
+    !*/
+
+    MITIE_EXPORT void mitie_training_options_set_max_search_evaluations (
+        mitie_training_options* options,
+        unsigned long num
+    );
+    /*!
+        requires
+            - options != NULL
+        ensures
+            - mitie_training_options_get_max_search_evaluations(options) == num
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_training_options_get_max_search_evaluations (
+        const mitie_training_options* options
+    );
+    /*!
+        requires
+            - options != NULL
+        ensures
+            - returns the maximum number of parameter settings each parameter search may
+              evaluate, or 0 if the trainers use their built in limits.
+    !*/
+
+    MITIE_EXPORT void mitie_training_options_set_early_stopping (
+        mitie_training_options* options,
+        unsigned long patience,
+        double tolerance
+    );
+    /*!
+        requires
+            - options != NULL
+            - tolerance >= 0
+        ensures
+            - mitie_training_options_get_early_stopping_patience(options) == patience
+            - mitie_training_options_get_early_stopping_tolerance(options) == tolerance
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_training_options_get_early_stopping_patience (
+        const mitie_training_options* options
+    );
+    /*!
+        requires
+            - options != NULL
+        ensures
+            - returns the number of evaluations in a row a parameter search may make
+              without improving its best cross-validation score by more than
+              mitie_training_options_get_early_stopping_tolerance(options) before it
+              stops, or 0 if the searches don't stop early.
+    !*/
+
+    MITIE_EXPORT double mitie_training_options_get_early_stopping_tolerance (
+        const mitie_training_options* options
+    );
+    /*!
+        requires
+            - options != NULL
+        ensures
+            - returns the amount a cross-validation score must improve on the best one
+              so far to count as an improvement for early stopping.
+    !*/
+
+    MITIE_EXPORT void mitie_training_options_set_progress_callback (
+        mitie_training_options* options,
+        mitie_training_progress_callback callback,
+        void* context
+    );
+    /*!
+        requires
+            - options != NULL
+        ensures
+            - Makes trainers given these options call callback(progress, context) at the
+              start of each phase, after each parameter evaluation in a search, and at
+              the end of each training phase.
+            - If callback is NULL then progress isn't reported.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     typedef struct mitie_ner_trainer mitie_ner_trainer;
@@ -856,6 +1518,20 @@ extern "C"
               the number of available CPU cores for maximum training speed.
     !*/
 
+    MITIE_EXPORT void mitie_ner_trainer_set_training_options (
+        mitie_ner_trainer* trainer,
+        const mitie_training_options* options
+    );
+    /*!
+        requires
+            - trainer != NULL
+            - options != NULL
+        ensures
+            - Makes mitie_train_named_entity_extractor() use the limits and progress callback
+              in options.  The trainer keeps a copy, so later changes to options don't
+              affect it.
+    !*/
+
     MITIE_EXPORT mitie_named_entity_extractor* mitie_train_named_entity_extractor (
         const mitie_ner_trainer* trainer
     );
@@ -1043,6 +1719,20 @@ extern "C"
               to the number of available CPU cores for maximum training speed.
     !*/
 
+    MITIE_EXPORT void mitie_binary_relation_trainer_set_training_options (
+        mitie_binary_relation_trainer* trainer,
+        const mitie_training_options* options
+    );
+    /*!
+        requires
+            - trainer != NULL
+            - options != NULL
+        ensures
+            - Makes mitie_train_binary_relation_detector() use the limits and progress callback
+              in options.  The trainer keeps a copy, so later changes to options don't
+              affect it.
+    !*/
+
     MITIE_EXPORT mitie_binary_relation_detector* mitie_train_binary_relation_detector (
         const mitie_binary_relation_trainer* trainer
     );
@@ -1139,6 +1829,20 @@ extern "C"
               the number of available CPU cores for maximum training speed.
     !*/
 
+    MITIE_EXPORT void mitie_text_categorizer_trainer_set_training_options (
+        mitie_text_categorizer_trainer* trainer,
+        const mitie_training_options* options
+    );
+    /*!
+        requires
+            - trainer != NULL
+            - options != NULL
+        ensures
+            - Makes mitie_train_text_categorizer() use the limits and progress callback
+              in options.  The trainer keeps a copy, so later changes to options don't
+              affect it.
+    !*/
+
     MITIE_EXPORT int mitie_add_text_categorizer_labeled_text (
         mitie_text_categorizer_trainer* trainer,
         const char** tokens,
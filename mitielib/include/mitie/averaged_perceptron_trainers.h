@@ -0,0 +1,702 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_AVERAGED_PERCEPTRON_TRaINERS_H_
+#define MIT_LL_MITIE_AVERAGED_PERCEPTRON_TRaINERS_H_
+
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <dlib/svm.h>
+#include <dlib/svm_threaded.h>
+#include <dlib/rand.h>
+#include <dlib/threads.h>
+#include <mitie/float_sample.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class averaged_weights
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a weight vector along with the average of all the values it
+                    has taken, one per training example seen.  The average is kept
+                    lazily, as in Hal Daume's thesis, so an update costs the same as
+                    an update to w alone.
+
+                CONVENTION
+                    - get_average() == w - u/c
+                    - c == 1 + the number of calls to next_example()
+            !*/
+        public:
+            averaged_weights (
+                const dlib::matrix<double,0,1>& start
+            ) : w(start), u(dlib::zeros_matrix(start)), c(1) {}
+
+            template <typename sparse_vector_type>
+            double dot (
+                const sparse_vector_type& x,
+                unsigned long offset = 0
+            ) const
+            {
+                double temp = 0;
+                for (unsigned long i = 0; i < x.size(); ++i)
+                    temp += w(offset+x[i].first)*x[i].second;
+                return temp;
+            }
+
+            double dot (
+                const float_sample& x,
+                unsigned long offset = 0
+            ) const
+            {
+                double temp = dot(x.sparse, offset);
+                offset += x.dense_offset;
+                for (unsigned long i = 0; i < x.dense.size(); ++i)
+                    temp += w(offset+i)*x.dense[i];
+                return temp;
+            }
+
+            void add (
+                unsigned long idx,
+                double val
+            )
+            {
+                w(idx) += val;
+                u(idx) += c*val;
+            }
+
+            template <typename sparse_vector_type>
+            void add (
+                const sparse_vector_type& x,
+                double scale,
+                unsigned long offset = 0
+            )
+            {
+                for (unsigned long i = 0; i < x.size(); ++i)
+                    add(offset+x[i].first, scale*x[i].second);
+            }
+
+            void add (
+                const float_sample& x,
+                double scale,
+                unsigned long offset = 0
+            )
+            {
+                add(x.sparse, scale, offset);
+                offset += x.dense_offset;
+                for (unsigned long i = 0; i < x.dense.size(); ++i)
+                    add(offset+i, scale*x.dense[i]);
+            }
+
+            void clip_to_nonnegative (
+                unsigned long idx
+            )
+            {
+                if (w(idx) < 0)
+                    add(idx, -w(idx));
+            }
+
+            void next_example (
+            ) { c += 1; }
+
+            const dlib::matrix<double,0,1>& get_weights (
+            ) const { return w; }
+
+            dlib::matrix<double,0,1> get_average (
+            ) const { return w - u/c; }
+
+        private:
+            dlib::matrix<double,0,1> w;
+            dlib::matrix<double,0,1> u;
+            double c;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        template <typename learner_type>
+        class parameter_mixing_epoch
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the function object given to parallel_for() to run one
+                    epoch of the perceptron over each shard of the training data.
+            !*/
+        public:
+            parameter_mixing_epoch (
+                const learner_type& learner_,
+                const std::vector<std::vector<unsigned long> >& shards_,
+                const dlib::matrix<double,0,1>& w_
+            ) : learner(learner_), shards(shards_), w(w_), ends(shards_.size()), averages(shards_.size()),
+                mistakes(shards_.size(), 0) {}
+
+            void run_shard (
+                long s
+            )
+            {
+                averaged_weights aw(w);
+                mistakes[s] = learner.run_epoch(shards[s], aw);
+                ends[s] = aw.get_weights();
+                averages[s] = aw.get_average();
+            }
+
+            const learner_type& learner;
+            const std::vector<std::vector<unsigned long> >& shards;
+            const dlib::matrix<double,0,1>& w;
+            std::vector<dlib::matrix<double,0,1> > ends;
+            std::vector<dlib::matrix<double,0,1> > averages;
+            std::vector<unsigned long> mistakes;
+        };
+
+        template <typename learner_type>
+        unsigned long parameter_mixing_step (
+            const learner_type& learner,
+            const std::vector<std::vector<unsigned long> >& shards,
+            const unsigned long num_threads,
+            dlib::matrix<double,0,1>& w,
+            dlib::matrix<double,0,1>& avg
+        )
+        /*!
+            requires
+                - learner.run_epoch(idx, aw) runs one pass of an averaged perceptron over
+                  the samples listed in idx, updating aw, and returns the number of
+                  samples it got wrong.  It must be safe to call from several threads
+                  at once.
+                - shards.size() > 0
+                - avg.size() == w.size()
+            ensures
+                - Runs one pass of the perceptron over each shard, in parallel with
+                  num_threads threads, starting each from the weights w.  Then sets #w
+                  to the average of the weights the shards ended up with and adds each
+                  shard's averaged perceptron weights to avg.
+                - returns the number of samples the shards got wrong.
+        !*/
+        {
+            parameter_mixing_epoch<learner_type> runner(learner, shards, w);
+            dlib::parallel_for(num_threads, 0, shards.size(), runner, &parameter_mixing_epoch<learner_type>::run_shard);
+
+            unsigned long mistakes = 0;
+            w = 0;
+            for (unsigned long s = 0; s < shards.size(); ++s)
+            {
+                w += runner.ends[s];
+                avg += runner.averages[s];
+                mistakes += runner.mistakes[s];
+            }
+            w /= shards.size();
+            return mistakes;
+        }
+
+        template <typename learner_type>
+        dlib::matrix<double,0,1> train_with_parameter_mixing (
+            const learner_type& learner,
+            const unsigned long num_samples,
+            const dlib::matrix<double,0,1>& initial_w,
+            const unsigned long num_epochs,
+            const unsigned long num_threads,
+            const bool verbose
+        )
+        /*!
+            requires
+                - learner.run_epoch(idx, aw) runs one pass of an averaged perceptron over
+                  the samples listed in idx, updating aw, and returns the number of
+                  samples it got wrong.  It must be safe to call from several threads
+                  at once.
+            ensures
+                - Trains, starting from the weights initial_w, with iterative parameter
+                  mixing as described in the paper:
+                      Distributed Training Strategies for the Structured Perceptron
+                      by Ryan McDonald, Keith Hall, and Gideon Mann
+                  Each epoch the samples are shuffled and split into num_threads shards
+                  and each shard runs one epoch of the perceptron, in parallel, starting
+                  from the current weights.  The current weights are then set to the
+                  average of the weights the shards ended up with.
+                - returns the average over all epochs and shards of the averaged
+                  perceptron weights.  When num_threads == 1 this is just the ordinary
+                  averaged perceptron.
+        !*/
+        {
+            dlib::matrix<double,0,1> w = initial_w;
+            dlib::matrix<double,0,1> avg = dlib::zeros_matrix(initial_w);
+            if (num_samples == 0 || num_epochs == 0)
+                return w;
+
+            std::vector<unsigned long> order(num_samples);
+            for (unsigned long i = 0; i < order.size(); ++i)
+                order[i] = i;
+            const unsigned long num_shards = std::max<unsigned long>(1, std::min(num_threads, num_samples));
+
+            dlib::rand rnd;
+            for (unsigned long epoch = 0; epoch < num_epochs; ++epoch)
+            {
+                for (unsigned long i = order.size()-1; i > 0; --i)
+                    std::swap(order[i], order[rnd.get_random_64bit_number()%(i+1)]);
+
+                std::vector<std::vector<unsigned long> > shards(num_shards);
+                for (unsigned long i = 0; i < order.size(); ++i)
+                    shards[i%num_shards].push_back(order[i]);
+
+                const unsigned long mistakes = parameter_mixing_step(learner, shards, num_threads, w, avg);
+
+                if (verbose)
+                    std::cout << "epoch " << epoch+1 << " of " << num_epochs << ", training errors: "
+                              << mistakes << " of " << num_samples << std::endl;
+            }
+
+            return avg/(num_epochs*num_shards);
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        template <typename problem_type>
+        class segmenter_perceptron_learner
+        {
+        public:
+            segmenter_perceptron_learner (
+                const problem_type& prob_,
+                unsigned long num_nonnegative_
+            ) : prob(prob_), num_nonnegative(num_nonnegative_) {}
+
+            unsigned long run_epoch (
+                const std::vector<unsigned long>& idx,
+                averaged_weights& aw
+            ) const
+            {
+                typename problem_type::feature_vector_type psi_true, psi_pred;
+                unsigned long mistakes = 0;
+                for (unsigned long i = 0; i < idx.size(); ++i)
+                {
+                    // All the label losses are positive, so the loss is 0 only when the
+                    // predicted labeling is the truth.
+                    double loss;
+                    prob.separation_oracle(idx[i], aw.get_weights(), loss, psi_pred);
+                    if (loss != 0)
+                    {
+                        ++mistakes;
+                        prob.get_truth_joint_feature_vector(idx[i], psi_true);
+                        aw.add(psi_true, 1);
+                        aw.add(psi_pred, -1);
+                        for (unsigned long j = 0; j < psi_pred.size(); ++j)
+                        {
+                            if (psi_pred[j].first < num_nonnegative)
+                                aw.clip_to_nonnegative(psi_pred[j].first);
+                        }
+                    }
+                    aw.next_example();
+                }
+                return mistakes;
+            }
+
+        private:
+            const problem_type& prob;
+            const unsigned long num_nonnegative;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        template <typename sample_type, typename label_type>
+        class multiclass_perceptron_learner
+        {
+            /*!
+                CONVENTION
+                    - The weight vector holds num_labels blocks of dims+1 weights, the
+                      last of which is the bias.  This is the same layout
+                      dlib::multiclass_svm_problem uses.
+            !*/
+        public:
+            multiclass_perceptron_learner (
+                const std::vector<sample_type>& samples_,
+                const std::vector<unsigned long>& label_idx_,
+                unsigned long num_labels_,
+                long dims_
+            ) : samples(samples_), label_idx(label_idx_), num_labels(num_labels_), dims(dims_) {}
+
+            unsigned long run_epoch (
+                const std::vector<unsigned long>& idx,
+                averaged_weights& aw
+            ) const
+            {
+                unsigned long mistakes = 0;
+                for (unsigned long i = 0; i < idx.size(); ++i)
+                {
+                    const sample_type& x = samples[idx[i]];
+                    const unsigned long truth = label_idx[idx[i]];
+                    unsigned long best = 0;
+                    double best_score = 0;
+                    for (unsigned long k = 0; k < num_labels; ++k)
+                    {
+                        const double score = aw.dot(x, k*(dims+1)) + aw.get_weights()(k*(dims+1)+dims);
+                        if (k == 0 || score > best_score)
+                        {
+                            best = k;
+                            best_score = score;
+                        }
+                    }
+
+                    if (best != truth)
+                    {
+                        ++mistakes;
+                        aw.add(x, 1, truth*(dims+1));
+                        aw.add(truth*(dims+1)+dims, 1);
+                        aw.add(x, -1, best*(dims+1));
+                        aw.add(best*(dims+1)+dims, -1);
+                    }
+                    aw.next_example();
+                }
+                return mistakes;
+            }
+
+        private:
+            const std::vector<sample_type>& samples;
+            const std::vector<unsigned long>& label_idx;
+            const unsigned long num_labels;
+            const long dims;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename feature_extractor
+        >
+    class averaged_perceptron_segmentation_trainer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object trains the same kind of sequence_segmenter as
+                dlib::structural_sequence_segmentation_trainer, but with an averaged
+                structured perceptron rather than a structural SVM.  It makes a fixed
+                number of passes over the data, so it takes a predictable and usually
+                much shorter time, at the cost of a somewhat less accurate segmenter.
+
+                The perceptron uses loss augmented decoding.  That is, it updates
+                whenever the labeling that maximizes the score plus the loss isn't the
+                true labeling, which pushes the segmenter to separate the truth from
+                other labelings by a margin proportional to their loss.  So, just as
+                with the structural SVM, raising the loss per missed segment makes the
+                segmenter favor recall.
+
+                Training uses iterative parameter mixing over get_num_threads() threads.
+        !*/
+
+    public:
+        typedef typename feature_extractor::sequence_type sample_sequence_type;
+        typedef std::vector<std::pair<unsigned long, unsigned long> > segmented_sequence_type;
+        typedef dlib::sequence_segmenter<feature_extractor> trained_function_type;
+
+        averaged_perceptron_segmentation_trainer (
+        ) : num_epochs(10), num_threads(4), loss_per_missed_segment(1), loss_per_false_alarm(1), verbose(false) {}
+
+        explicit averaged_perceptron_segmentation_trainer (
+            const feature_extractor& fe_
+        ) : fe(fe_), num_epochs(10), num_threads(4), loss_per_missed_segment(1), loss_per_false_alarm(1), verbose(false) {}
+        /*!
+            ensures
+                - #get_feature_extractor() == fe_
+                - #get_num_epochs() == 10
+                - #get_num_threads() == 4
+                - #get_loss_per_missed_segment() == 1
+                - #get_loss_per_false_alarm() == 1
+                - This object is not verbose
+        !*/
+
+        const feature_extractor& get_feature_extractor (
+        ) const { return fe; }
+
+        const dlib::matrix<double,0,1>& get_initial_weights (
+        ) const { return initial_weights; }
+
+        void set_initial_weights (
+            const dlib::matrix<double,0,1>& w
+        ) { initial_weights = w; }
+        /*!
+            ensures
+                - #get_initial_weights() == w
+                - if (w.size() != 0) then
+                    - train() starts from the segmenter with weights w rather than from
+                      all zero weights.  So to continue training an existing segmenter,
+                      give it that segmenter's get_weights().  w must have the same size
+                      as the weights of the segmenters this object trains.
+        !*/
+
+        unsigned long get_num_epochs (
+        ) const { return num_epochs; }
+
+        void set_num_epochs (
+            unsigned long num
+        ) { num_epochs = num; }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+
+        void set_num_threads (
+            unsigned long num
+        ) { num_threads = num; }
+
+        double get_loss_per_missed_segment (
+        ) const { return loss_per_missed_segment; }
+
+        void set_loss_per_missed_segment (
+            double loss
+        )
+        {
+            DLIB_CASSERT(loss > 0, "Invalid inputs were given to this function");
+            loss_per_missed_segment = loss;
+        }
+
+        double get_loss_per_false_alarm (
+        ) const { return loss_per_false_alarm; }
+
+        void set_loss_per_false_alarm (
+            double loss
+        )
+        {
+            DLIB_CASSERT(loss > 0, "Invalid inputs were given to this function");
+            loss_per_false_alarm = loss;
+        }
+
+        void be_verbose (
+        ) { verbose = true; }
+
+        void be_quiet (
+        ) { verbose = false; }
+
+        const trained_function_type train (
+            const std::vector<sample_sequence_type>& x,
+            const std::vector<segmented_sequence_type>& y
+        ) const
+        {
+            using namespace dlib;
+            DLIB_ASSERT(is_sequence_segmentation_problem(x,y) == true,
+                        "\t sequence_segmenter averaged_perceptron_segmentation_trainer::train(x,y)"
+                        << "\n\t invalid inputs were given to this function"
+                        << "\n\t x.size(): " << x.size()
+                        << "\n\t is_sequence_segmentation_problem(x,y): " << is_sequence_segmentation_problem(x,y)
+                        << "\n\t this: " << this
+            );
+
+            // This is the same labeling structural_sequence_segmentation_trainer uses.
+            std::vector<std::vector<unsigned long> > labels(y.size());
+            for (unsigned long i = 0; i < labels.size(); ++i)
+            {
+                labels[i].resize(x[i].size(), impl_ss::OUTSIDE);
+                for (unsigned long j = 0; j < y[i].size(); ++j)
+                {
+                    const unsigned long begin = y[i][j].first;
+                    const unsigned long end = y[i][j].second;
+                    if (begin == end)
+                        continue;
+
+                    if (feature_extractor::use_BIO_model)
+                    {
+                        labels[i][begin] = impl_ss::BEGIN;
+                        for (unsigned long k = begin+1; k < end; ++k)
+                            labels[i][k] = impl_ss::INSIDE;
+                    }
+                    else if (begin+1 == end)
+                    {
+                        labels[i][begin] = impl_ss::UNIT;
+                    }
+                    else
+                    {
+                        labels[i][begin] = impl_ss::BEGIN;
+                        for (unsigned long k = begin+1; k+1 < end; ++k)
+                            labels[i][k] = impl_ss::INSIDE;
+                        labels[i][end-1] = impl_ss::LAST;
+                    }
+                }
+            }
+
+            // The structural SVM problem object knows how to compute the joint feature
+            // vectors and do loss augmented decoding, which is all the perceptron needs.
+            typedef impl_ss::feature_extractor<feature_extractor> ss_feature_extractor;
+            typedef structural_svm_sequence_labeling_problem<ss_feature_extractor> problem_type;
+            const ss_feature_extractor ssfe(fe);
+            problem_type prob(x, labels, ssfe, 1);
+            prob.set_loss(impl_ss::BEGIN, loss_per_missed_segment);
+            prob.set_loss(impl_ss::INSIDE, loss_per_missed_segment);
+            if (!feature_extractor::use_BIO_model)
+            {
+                prob.set_loss(impl_ss::LAST, loss_per_missed_segment);
+                prob.set_loss(impl_ss::UNIT, loss_per_missed_segment);
+            }
+            prob.set_loss(impl_ss::OUTSIDE, loss_per_false_alarm);
+
+            typedef structural_svm_problem<matrix<double,0,1>, typename problem_type::feature_vector_type> base_problem_type;
+            const base_problem_type& base_prob = prob;
+            matrix<double,0,1> initial_w = zeros_matrix<double>(base_prob.get_num_dimensions(),1);
+            if (initial_weights.size() != 0)
+            {
+                DLIB_CASSERT(initial_weights.size() == initial_w.size(),
+                    "The initial weights given to averaged_perceptron_segmentation_trainer have the wrong size."
+                    << "\n\t initial_weights.size(): " << initial_weights.size()
+                    << "\n\t expected size:          " << initial_w.size()
+                );
+                initial_w = initial_weights;
+            }
+            impl::segmenter_perceptron_learner<base_problem_type> learner(base_prob, num_nonnegative_weights(ssfe));
+            const matrix<double,0,1> weights = impl::train_with_parameter_mixing(learner, x.size(), initial_w,
+                                                                                 num_epochs, num_threads, verbose);
+            return trained_function_type(weights, fe);
+        }
+
+    private:
+        feature_extractor fe;
+        dlib::matrix<double,0,1> initial_weights;
+        unsigned long num_epochs;
+        unsigned long num_threads;
+        double loss_per_missed_segment;
+        double loss_per_false_alarm;
+        bool verbose;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename sample_type,
+        typename label_type = unsigned long
+        >
+    class averaged_perceptron_multiclass_trainer
+    {
+        /*!
+            REQUIREMENTS ON sample_type
+                sample_type must be a sparse vector type, as defined in
+                dlib/svm/sparse_vector_abstract.h, in the form of a std::vector of
+                (index, value) pairs.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object trains the same kind of multiclass linear classifier as
+                dlib::svm_multiclass_linear_trainer, but with an averaged perceptron
+                rather than a multiclass SVM.  It makes a fixed number of passes over
+                the data.  Training uses iterative parameter mixing over
+                get_num_threads() threads.
+        !*/
+
+    public:
+        typedef dlib::sparse_linear_kernel<sample_type> kernel_type;
+        typedef dlib::multiclass_linear_decision_function<kernel_type, label_type> trained_function_type;
+
+        averaged_perceptron_multiclass_trainer (
+        ) : has_initial(false), num_epochs(10), num_threads(4), verbose(false) {}
+        /*!
+            ensures
+                - #has_initial_classifier() == false
+                - #get_num_epochs() == 10
+                - #get_num_threads() == 4
+                - This object is not verbose
+        !*/
+
+        bool has_initial_classifier (
+        ) const { return has_initial; }
+
+        const trained_function_type& get_initial_classifier (
+        ) const { return initial_df; }
+
+        void set_initial_classifier (
+            const trained_function_type& df
+        )
+        /*!
+            ensures
+                - #has_initial_classifier() == true
+                - #get_initial_classifier() == df
+                - train() starts from df rather than from all zero weights.  The
+                  classifiers it trains predict all of df's labels as well as any new
+                  labels found in the training data.
+        !*/
+        {
+            initial_df = df;
+            has_initial = true;
+        }
+
+        unsigned long get_num_epochs (
+        ) const { return num_epochs; }
+
+        void set_num_epochs (
+            unsigned long num
+        ) { num_epochs = num; }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+
+        void set_num_threads (
+            unsigned long num
+        ) { num_threads = num; }
+
+        void be_verbose (
+        ) { verbose = true; }
+
+        void be_quiet (
+        ) { verbose = false; }
+
+        const trained_function_type train (
+            const std::vector<sample_type>& samples,
+            const std::vector<label_type>& labels
+        ) const
+        {
+            using namespace dlib;
+            DLIB_ASSERT(is_learning_problem(samples,labels),
+                "\t trained_function_type averaged_perceptron_multiclass_trainer::train(samples,labels)"
+                << "\n\t invalid inputs were given to this function"
+                << "\n\t samples.size():     " << samples.size()
+                << "\n\t labels.size():      " << labels.size()
+                );
+
+            trained_function_type df;
+            df.labels = labels;
+            long dims = max_index_plus_one(samples);
+            if (has_initial)
+            {
+                df.labels.insert(df.labels.end(), initial_df.labels.begin(), initial_df.labels.end());
+                dims = std::max<long>(dims, initial_df.weights.nc());
+            }
+            df.labels = select_all_distinct_labels(df.labels);
+
+            std::vector<unsigned long> label_idx(labels.size());
+            for (unsigned long i = 0; i < labels.size(); ++i)
+                label_idx[i] = std::lower_bound(df.labels.begin(), df.labels.end(), labels[i]) - df.labels.begin();
+
+            matrix<double,0,1> initial_w = zeros_matrix<double>(df.labels.size()*(dims+1),1);
+            if (has_initial)
+            {
+                // copy each row of the initial classifier to wherever its label ended
+                // up, remembering that the perceptron adds the bias rather than
+                // subtracting it.
+                for (unsigned long i = 0; i < initial_df.labels.size(); ++i)
+                {
+                    const long r = std::lower_bound(df.labels.begin(), df.labels.end(), initial_df.labels[i]) - df.labels.begin();
+                    for (long c = 0; c < initial_df.weights.nc(); ++c)
+                        initial_w(r*(dims+1) + c) = initial_df.weights(i,c);
+                    initial_w(r*(dims+1) + dims) = -initial_df.b(i);
+                }
+            }
+
+            impl::multiclass_perceptron_learner<sample_type,label_type> learner(samples, label_idx, df.labels.size(), dims);
+            const matrix<double,0,1> weights = impl::train_with_parameter_mixing(learner, samples.size(), initial_w,
+                                                                                 num_epochs, num_threads, verbose);
+
+            // multiclass_linear_decision_function subtracts b, so negate the bias.
+            df.weights = colm(reshape(weights, df.labels.size(), dims+1), range(0,dims-1));
+            df.b       = -colm(reshape(weights, df.labels.size(), dims+1), dims);
+            return df;
+        }
+
+    private:
+        trained_function_type initial_df;
+        bool has_initial;
+        unsigned long num_epochs;
+        unsigned long num_threads;
+        bool verbose;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_AVERAGED_PERCEPTRON_TRaINERS_H_
+
@@ -50,6 +50,24 @@ namespace mitie
                   are interpreted as half open ranges in tokens.
     !*/
 
+    binary_relation extract_binary_relation (
+        const std::vector<std::string>& tokens,
+        const std::vector<dlib::matrix<float,0,1> >& token_feats,
+        const std::pair<unsigned long, unsigned long>& rel_arg1,
+        const std::pair<unsigned long, unsigned long>& rel_arg2,
+        const total_word_feature_extractor& tfe
+    );
+    /*!
+        requires
+            - token_feats == sentence_to_feats(tfe, tokens)
+            - rel_arg1.first < rel_arg1.second <= tokens.size()
+            - rel_arg2.first < rel_arg2.second <= tokens.size()
+        ensures
+            - returns extract_binary_relation(tokens, rel_arg1, rel_arg2, tfe).  However,
+              this version uses the precomputed word vectors in token_feats instead of
+              asking tfe for them again.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     struct binary_relation_detector 
@@ -6,6 +6,7 @@
 
 #include <mitie/binary_relation_detector.h>
 #include <mitie/named_entity_extractor.h>
+#include <mitie/training_options.h>
 #include <mitie.h>
 
 namespace mitie
@@ -26,6 +27,9 @@ namespace mitie
             ensures
                 - #get_beta() == 0.1
                 - #num_threads() == 4
+                - #get_parallel_search() == false
+                - #get_training_options() == a default initialized training_options
+                  object, i.e. training isn't limited and progress isn't reported.
                 - A copy of the given ner object is used during the training process.
                   Therefore, ner should be trained for the same language as the data we are
                   going to use to train a binary relation detector. (e.g. Don't use a ner
@@ -171,6 +175,48 @@ namespace mitie
                 - #get_beta() == new_beta
         !*/
 
+        bool get_parallel_search (
+        ) const;
+        /*!
+            ensures
+                - returns true if train() picks the detector's two C parameters with a
+                  parallel search and false if it uses the default BOBYQA search.  BOBYQA
+                  only ever evaluates one pair of C values at a time.  The parallel search
+                  instead evaluates a grid of C values around the best pair found so
+                  far, several at once, while keeping within the get_num_threads() thread
+                  budget.  So on a machine with more cores than there are
+                  cross-validation folds it finishes much sooner.  It also prints how
+                  long the search took compared to running the same evaluations serially.
+                  If get_num_threads() is too small to evaluate more than one pair at a
+                  time, the parallel search would only be slower, so train() uses BOBYQA
+                  anyway.
+        !*/
+
+        void set_parallel_search (
+            bool enabled
+        );
+        /*!
+            ensures
+                - #get_parallel_search() == enabled
+        !*/
+
+        const training_options& get_training_options (
+        ) const;
+        /*!
+            ensures
+                - returns the limits on how long train() spends searching for the
+                  detector's C parameters, and the callback it reports its progress to.
+                  See training_options for details.
+        !*/
+
+        void set_training_options (
+            const training_options& options
+        );
+        /*!
+            ensures
+                - #get_training_options() == options
+        !*/
+
         binary_relation_detector train (
         ) const;
         /*!
@@ -195,6 +241,8 @@ namespace mitie
         total_word_feature_extractor tfe;
         double beta;
         unsigned long num_threads;
+        bool parallel_search;
+        training_options options;
         std::string relation_name;
         typedef std::pair<unsigned long, unsigned long> range;
         std::vector<std::vector<std::string> > pos_sentences;
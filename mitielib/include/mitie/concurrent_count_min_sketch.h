@@ -0,0 +1,307 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_CONCURRENT_CoUNT_MIN_SKETCH_H_
+#define MIT_LL_CONCURRENT_CoUNT_MIN_SKETCH_H_
+
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <dlib/uintn.h>
+#include <dlib/assert.h>
+#include <dlib/threads.h>
+#include <dlib/smart_pointers.h>
+#include <dlib/serialize.h>
+#include <dlib/byte_orderer.h>
+#include <dlib/general_hash/murmur_hash3.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class concurrent_count_min_sketch : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a count-min sketch, like the count_min_sketch object, that can be
+                updated by many threads at once.  It has the same increment() and
+                get_count() interface but differs from count_min_sketch in the following
+                ways:
+                    - All the table positions for an item are derived from one 128 bit
+                      murmur hash of the item, rather than hashing the whole item once
+                      per table.  Half the hash picks a block and the other half picks a
+                      cell in each table within that block.
+                    - The tables are interleaved in blocks of 4 adjacent cache lines.
+                      Each block holds a small slice of all get_num_hashes() tables and
+                      all of an item's counters are in the block it hashes to.  So
+                      updating or reading an item touches one small region of memory
+                      instead of get_num_hashes() unrelated cache lines.
+                    - It uses conservative update.  That is, increment() only raises the
+                      counters for an item that are below its new estimated count rather
+                      than adding to all of them.  This gives the same guarantee that
+                      get_count() never underestimates, but the overestimates are much
+                      smaller.  It also means it's not possible to merge two sketches
+                      by adding them, so there is no absorb() function.
+                    - The counters are 32 bits and saturate at 0xFFFFFFFF instead of
+                      overflowing.  So it uses half the RAM of a count_min_sketch with the
+                      same table size.
+
+            THREAD SAFETY
+                It is safe for any number of threads to call increment() and get_count()
+                at the same time.  The blocks are guarded by a set of striped mutexes, so
+                threads only contend when they touch blocks sharing a stripe, which for
+                a large sketch is rare.  Since an item lives in one block, each call
+                takes exactly one lock.
+        !*/
+
+    public:
+
+        explicit concurrent_count_min_sketch (
+            unsigned long hash_table_size = 1000000
+        )
+        /*!
+            requires
+                - hash_table_size > 0
+            ensures
+                - #get_hash_table_size() == hash_table_size, rounded up to a multiple of 8.
+                - #get_num_hashes() == 8
+                - #get_total_count() == 0
+                - for all valid X:
+                    - #get_count(X) == 0
+        !*/
+        {
+            DLIB_CASSERT(hash_table_size > 0, "Invalid inputs were given to this function");
+
+            // Each block holds cells_per_row cells of every table.
+            allocate((hash_table_size + cells_per_row-1)/cells_per_row);
+            stripes.reset(new stripe[num_stripes]);
+            set_counts_to_zero();
+        }
+
+        void set_counts_to_zero (
+        )
+        /*!
+            requires
+                - No other thread is using this object.
+            ensures
+                - #get_total_count() == 0
+                - for all valid X:
+                    - #get_count(X) == 0
+        !*/
+        {
+            for (unsigned long i = 0; i < num_blocks*cells_per_block; ++i)
+                cells[i] = 0;
+            for (unsigned long i = 0; i < num_stripes; ++i)
+                stripes[i].total_count = 0;
+        }
+
+        dlib::uint64 get_total_count(
+        ) const
+        /*!
+            ensures
+                - returns the total of all values added into this object via the
+                  increment() member function.
+        !*/
+        {
+            dlib::uint64 total = 0;
+            for (unsigned long i = 0; i < num_stripes; ++i)
+            {
+                dlib::auto_mutex lock(stripes[i].m);
+                total += stripes[i].total_count;
+            }
+            return total;
+        }
+
+        unsigned int get_num_hashes (
+        ) const { return num_hashes; }
+
+        unsigned long get_hash_table_size (
+        ) const { return num_blocks*cells_per_row; }
+
+        dlib::uint64 increment (
+            const std::string& item,
+            unsigned long amount = 1
+        )
+        /*!
+            ensures
+                - increments the count for item.  Note that the count min sketch data
+                  structure maintains only approximate counts.  But the idea is that it
+                  attempts to perform the following:
+                    - #get_count(item) == get_count(item) + amount
+                - #total_count() == total_count() + amount
+                - returns #get_count(item).  That is, the estimate of item's count just
+                  after it was incremented.
+        !*/
+        {
+            unsigned long idx[num_hashes];
+            const unsigned long block = get_cells(item, idx);
+            dlib::uint32* c = cells + block*cells_per_block;
+
+            stripe& s = stripes[block%num_stripes];
+            dlib::auto_mutex lock(s.m);
+            s.total_count += amount;
+
+            dlib::uint32 val = std::numeric_limits<dlib::uint32>::max();
+            for (unsigned long r = 0; r < num_hashes; ++r)
+                val = std::min(val, c[idx[r]]);
+
+            // saturate rather than wrap around
+            const dlib::uint32 max_val = std::numeric_limits<dlib::uint32>::max();
+            val = (amount > max_val - val) ? max_val : val + amount;
+
+            for (unsigned long r = 0; r < num_hashes; ++r)
+            {
+                if (c[idx[r]] < val)
+                    c[idx[r]] = val;
+            }
+            return val;
+        }
+
+        dlib::uint64 get_count (
+            const std::string& item
+        ) const
+        /*!
+            ensures
+                - returns the current count for the given item.  Note that this count is
+                  approximate, however, it is always at least as large as the actual count
+                  for this item (unless the count is so large the counters saturated).
+        !*/
+        {
+            unsigned long idx[num_hashes];
+            const unsigned long block = get_cells(item, idx);
+            const dlib::uint32* c = cells + block*cells_per_block;
+
+            dlib::auto_mutex lock(stripes[block%num_stripes].m);
+            dlib::uint32 val = std::numeric_limits<dlib::uint32>::max();
+            for (unsigned long r = 0; r < num_hashes; ++r)
+                val = std::min(val, c[idx[r]]);
+            return val;
+        }
+
+        friend void serialize (const concurrent_count_min_sketch& item, std::ostream& out)
+        /*!
+            requires
+                - No other thread is using item.
+            ensures
+                - serializes item to the given output stream
+        !*/
+        {
+            int version = 1;
+            dlib::serialize(version, out);
+            dlib::serialize(item.num_blocks, out);
+            const unsigned long num_cells = item.num_blocks*cells_per_block;
+            dlib::byte_orderer bo;
+            if (bo.host_is_big_endian())
+            {
+                for (unsigned long i = 0; i < num_cells; ++i)
+                    bo.host_to_little(item.cells[i]);
+            }
+
+            out.write((char*)item.cells, num_cells*sizeof(dlib::uint32));
+
+            // swap back to normal if necessary
+            if (bo.host_is_big_endian())
+            {
+                for (unsigned long i = 0; i < num_cells; ++i)
+                    bo.little_to_host(item.cells[i]);
+            }
+            dlib::serialize(item.get_total_count(), out);
+        }
+
+        friend void deserialize (concurrent_count_min_sketch& item, std::istream& in)
+        /*!
+            requires
+                - No other thread is using item.
+            ensures
+                - deserializes item from the given input stream
+        !*/
+        {
+            int version = 0;
+            dlib::deserialize(version, in);
+            if (version != 1)
+                throw dlib::serialization_error("Wrong version found while deserializing a mitie::concurrent_count_min_sketch object.");
+
+            unsigned long num_blocks;
+            dlib::deserialize(num_blocks, in);
+            if (num_blocks != item.num_blocks)
+                item.allocate(num_blocks);
+
+            const unsigned long num_cells = item.num_blocks*cells_per_block;
+            in.read((char*)item.cells, num_cells*sizeof(dlib::uint32));
+            if (!in)
+                throw dlib::serialization_error("Error while deserializing a mitie::concurrent_count_min_sketch object.");
+            dlib::byte_orderer bo;
+            if (bo.host_is_big_endian())
+            {
+                for (unsigned long i = 0; i < num_cells; ++i)
+                    bo.little_to_host(item.cells[i]);
+            }
+
+            for (unsigned long i = 0; i < num_stripes; ++i)
+                item.stripes[i].total_count = 0;
+            dlib::deserialize(item.stripes[0].total_count, in);
+        }
+
+    private:
+
+        // A block is 8 rows (one per table) of 8 uint32 counters, which is 256 bytes.
+        const static unsigned long num_hashes = 8;
+        const static unsigned long cells_per_row = 8;
+        const static unsigned long cells_per_block = num_hashes*cells_per_row;
+        const static unsigned long num_stripes = 4096;
+
+        void allocate (
+            unsigned long num_blocks_
+        )
+        {
+            num_blocks = num_blocks_;
+            // Allocate a little extra so we can align the start of the cells to a cache
+            // line.
+            mem.reset(new dlib::uint32[num_blocks*cells_per_block + 16]);
+            const unsigned long misalign = reinterpret_cast<size_t>(mem.get())%64;
+            cells = mem.get() + (misalign == 0 ? 0 : (64 - misalign)/sizeof(dlib::uint32));
+        }
+
+        unsigned long get_cells (
+            const std::string& item,
+            unsigned long (&idx)[num_hashes]
+        ) const
+        /*!
+            ensures
+                - returns the block item belongs to and stores the positions of its cells
+                  within that block into idx.  idx[r] is in the r-th row of the block.
+        !*/
+        {
+            const std::pair<dlib::uint64,dlib::uint64> h = dlib::murmur_hash3_128bit(item.data(), item.size());
+            // Each row uses its own 3 bits of the hash so the rows are independent.
+            dlib::uint64 bits = h.second;
+            for (unsigned long r = 0; r < num_hashes; ++r)
+            {
+                idx[r] = r*cells_per_row + bits%cells_per_row;
+                bits /= cells_per_row;
+            }
+            return h.first%num_blocks;
+        }
+
+        struct stripe
+        {
+            dlib::mutex m;
+            dlib::uint64 total_count;
+            // keep each mutex on its own cache line so threads working on different
+            // stripes don't fight over the same line.
+            char padding[64];
+        };
+
+        unsigned long num_blocks;
+        dlib::scoped_ptr<dlib::uint32[]> mem;
+        dlib::uint32* cells;
+        dlib::scoped_ptr<stripe[]> stripes;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_CONCURRENT_CoUNT_MIN_SKETCH_H_
+
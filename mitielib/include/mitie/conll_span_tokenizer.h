@@ -0,0 +1,472 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_CONLL_SPaN_TOKENIZER_H_
+#define MIT_LL_MITIE_CONLL_SPaN_TOKENIZER_H_
+
+#include <string>
+#include <cstring>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct token_span
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object identifies one token inside a text buffer.  The token is made
+                out of the bytes text[begin] through text[end-1].
+
+                The conll_tokenizer replaces the UTF-8 ’ character at the front of a token
+                with a plain ASCII ' character.  When that happens utf8_apostrophe is set
+                to true.  In this case the 3 byte ’ is still included in [begin, end) but
+                the token text is "'" followed by the bytes text[begin+3] through
+                text[end-1].
+        !*/
+
+        token_span() : begin(0), end(0), utf8_apostrophe(false) {}
+
+        unsigned long begin;
+        unsigned long end;
+        bool utf8_apostrophe;
+
+        unsigned long size (
+        ) const { return utf8_apostrophe ? end-begin-2 : end-begin; }
+        /*!
+            ensures
+                - returns the number of bytes in the token text.
+        !*/
+    };
+
+    inline void assign_token (
+        std::string& token,
+        const char* text,
+        const token_span& span
+    )
+    /*!
+        requires
+            - span was produced by a conll_span_tokenizer reading from text.
+        ensures
+            - #token == the text of the token identified by span.  That is, the same string
+              the conll_tokenizer would have produced for this token.
+    !*/
+    {
+        if (span.utf8_apostrophe)
+        {
+            token.assign(1, '\'');
+            token.append(text + span.begin + 3, text + span.end);
+        }
+        else
+        {
+            token.assign(text + span.begin, text + span.end);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class conll_span_tokenizer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a version of the conll_tokenizer that reads directly from an in
+                memory buffer rather than from a std::istream.  Rather than building a
+                std::string for each token it outputs token_span objects that point into
+                the buffer, so tokenizing text does not allocate any memory.
+
+                The tokens produced are exactly the same as the ones produced by running
+                the conll_tokenizer over an istream containing the same bytes, including
+                the token offsets and the special handling of UTF-8 quotes, apostrophes,
+                and non-breaking spaces.
+
+            CONVENTION
+                - text[pos] is the next byte that has not yet been looked at.
+                - if (has_next) then
+                    - next is the token we should return on the next call.
+                - next.begin <= next.end <= pos
+        !*/
+
+    public:
+
+        conll_span_tokenizer (
+        ) : text(0), length(0), pos(0), has_next(false) {}
+        /*!
+            ensures
+                - any attempts to get a token will return false.  I.e. this will look like a
+                  tokenizer that has run out of tokens.
+        !*/
+
+        conll_span_tokenizer (
+            const char* text_,
+            unsigned long length_
+        ) : text(text_), length(length_), pos(0), has_next(false) {}
+        /*!
+            requires
+                - text_ points to an array of at least length_ bytes.
+            ensures
+                - This object will read tokens from text_[0] through text_[length_-1].
+                  Note that it holds a pointer to the buffer so the buffer should continue
+                  to exist for the lifetime of this conll_span_tokenizer.
+        !*/
+
+        explicit conll_span_tokenizer (
+            const char* text_
+        ) : text(text_), length(std::strlen(text_)), pos(0), has_next(false) {}
+        /*!
+            requires
+                - text_ == a NULL terminated C string
+            ensures
+                - This object will read tokens from text_.  Note that it holds a pointer to
+                  the string so it should continue to exist for the lifetime of this
+                  conll_span_tokenizer.
+        !*/
+
+        bool operator() (
+            token_span& span
+        )
+        /*!
+            ensures
+                - reads the next token from the buffer and stores its location in #span.
+                - if (there is not a next token) then
+                    - returns false
+                - else
+                    - #span.begin is the byte offset the conll_tokenizer would report for
+                      this token.
+                    - returns true
+        !*/
+        {
+            bool maybe_split;
+            if (has_next)
+            {
+                span = next;
+                has_next = false;
+                maybe_split = true;
+            }
+            else
+            {
+                if (!next_raw_token(span, maybe_split))
+                    return false;
+            }
+
+            // Tokens that don't have any 0xE2 bytes in them can't contain any of the
+            // UTF-8 quote characters, so there is nothing more to do with them.
+            if (!maybe_split)
+                return true;
+
+            const unsigned long size = span.size();
+            const unsigned long skip = span.utf8_apostrophe ? 2 : 0;
+
+            // check if the token starts with a unicode double quote, if so, break it into
+            // two tokens.
+            if (size >= 4 &&
+                byte_at(span,0) == 0xE2 &&
+                byte_at(span,1) == 0x80 &&
+                byte_at(span,2) == 0x9C)
+            {
+                next.begin = span.begin + skip + 3;
+                next.end = span.end;
+                next.utf8_apostrophe = false;
+                has_next = true;
+                span.end = next.begin;
+                return true;
+            }
+            else if (size >= 4 &&  // check if it ends with a unicode double code and break if so.
+                byte_at(span,size-3) == 0xE2 &&
+                byte_at(span,size-2) == 0x80 &&
+                byte_at(span,size-1) == 0x9D)
+            {
+                next.begin = span.end-3;
+                next.end = span.end;
+                next.utf8_apostrophe = false;
+                has_next = true;
+                span.end = next.begin;
+                return true;
+            }
+            else
+            {
+                // Check if token has a UTF-8 ’ character in it and if so then split it into
+                // two tokens based on that.
+                for (unsigned long i = 1; i+2 < size; ++i)
+                {
+                    if (byte_at(span,i)   == 0xE2 &&
+                        byte_at(span,i+1) == 0x80 &&
+                        byte_at(span,i+2) == 0x99)
+                    {
+                        next.begin = span.begin + skip + i;
+                        next.end = span.end;
+                        next.utf8_apostrophe = true;
+                        has_next = true;
+                        span.end = next.begin;
+                        return true;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        bool operator() (
+            std::string& token,
+            unsigned long& token_offset
+        )
+        /*!
+            ensures
+                - This function has the same interface as conll_tokenizer::operator().
+                  That is, it reads the next token, stores it into #token and its offset
+                  into #token_offset, and returns true.  Returns false if there are no more
+                  tokens.
+        !*/
+        {
+            token_span span;
+            if (!(*this)(span))
+            {
+                token.clear();
+                return false;
+            }
+            assign_token(token, text, span);
+            token_offset = span.begin;
+            return true;
+        }
+
+        bool operator() (
+            std::string& token
+        )
+        {
+            unsigned long ignored;
+            return (*this)(token, ignored);
+        }
+
+    private:
+
+        enum char_class
+        {
+            WORD = 0,
+            SPACE,
+            PUNCT,
+            APOSTROPHE,
+            MAYBE_NBSP,  // 0xC2, the first byte of a UTF-8 non-breaking space
+            UTF8_QUOTE   // 0xE2, the first byte of the UTF-8 quote characters
+        };
+
+        static unsigned char char_type (
+            unsigned char ch
+        )
+        {
+            // This table maps each byte value to its char_class.
+            static const unsigned char table[256] = {
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                1, 2, 2, 0, 0, 0, 0, 3, 2, 2, 0, 0, 2, 0, 2, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 2,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+            };
+            return table[ch];
+        }
+
+        unsigned char byte_at (
+            const token_span& span,
+            unsigned long i
+        ) const
+        /*!
+            ensures
+                - returns the i-th byte of the token text identified by span.
+        !*/
+        {
+            if (span.utf8_apostrophe)
+                return (i == 0) ? '\'' : (unsigned char)text[span.begin+2+i];
+            else
+                return (unsigned char)text[span.begin+i];
+        }
+
+        bool is_nbsp (
+            unsigned long i
+        ) const { return i+1 < length && (unsigned char)text[i+1] == 0xA0; }
+        /*!
+            requires
+                - text[i] == 0xC2
+            ensures
+                - returns true if text[i] is the start of a UTF-8 non-breaking space.
+        !*/
+
+        static bool is_upper (char ch) { return 'A' <= ch && ch <= 'Z'; }
+        static bool is_lower (char ch) { return 'a' <= ch && ch <= 'z'; }
+        static bool is_digit (char ch) { return '0' <= ch && ch <= '9'; }
+
+        bool next_raw_token (
+            token_span& span,
+            bool& has_utf8_quote_byte
+        )
+        /*!
+            ensures
+                - finds the next token in the same way as conll_tokenizer::get_next_token()
+                  and stores its location into #span.
+                - #has_utf8_quote_byte == true if the token contains an 0xE2 byte.
+                - returns false if there are no more tokens.
+        !*/
+        {
+            // skip over any whitespace
+            while (pos < length)
+            {
+                const unsigned char type = char_type(text[pos]);
+                if (type == SPACE)
+                    ++pos;
+                else if (type == MAYBE_NBSP && is_nbsp(pos))
+                    pos += 2;
+                else
+                    break;
+            }
+
+            if (pos >= length)
+                return false;
+
+            span.begin = pos;
+            span.utf8_apostrophe = false;
+            has_utf8_quote_byte = false;
+
+            // Punctuation characters at the start of a token are always tokens by
+            // themselves.  Anything else starts a token that we keep accumulating.
+            unsigned char type = char_type(text[pos]);
+            ++pos;
+            if (type == PUNCT)
+            {
+                span.end = pos;
+                return true;
+            }
+            has_utf8_quote_byte = (type == UTF8_QUOTE);
+
+            while (pos < length)
+            {
+                type = char_type(text[pos]);
+
+                if (type == WORD)
+                {
+                    ++pos;
+                }
+                else if (type == UTF8_QUOTE)
+                {
+                    has_utf8_quote_byte = true;
+                    ++pos;
+                }
+                else if (type == SPACE || type == APOSTROPHE)
+                {
+                    break;
+                }
+                else if (type == MAYBE_NBSP)
+                {
+                    if (is_nbsp(pos))
+                        break;
+                    ++pos;
+                }
+                else // type == PUNCT
+                {
+                    const char ch = text[pos];
+                    const unsigned long size = pos - span.begin;
+                    const char last = text[pos-1];
+                    if (ch == '.' && (size == 1 || last == '.' || (size >= 2 && text[pos-2] == '.')))
+                    {
+                        ++pos;
+                    }
+                    // catch stuff like Jr.  or St.
+                    else if (ch == '.' && size == 2 && is_upper(text[span.begin]) && is_lower(last))
+                    {
+                        // but drop the trailing .
+                        span.end = pos;
+                        ++pos;
+                        return true;
+                    }
+                    // if this is a number followed by a comma or period then just keep
+                    // accumulating the token.
+                    else if ((ch == ',' || ch == '.') && is_digit(last))
+                    {
+                        ++pos;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+            }
+
+            span.end = pos;
+            return true;
+        }
+
+        const char* text;
+        unsigned long length;
+        unsigned long pos;
+        token_span next;
+        bool has_next;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    inline bool is_split_utf8_apostrophe (
+        const char* text,
+        unsigned long prev_begin,
+        unsigned long prev_end,
+        unsigned long begin,
+        unsigned long end
+    )
+    /*!
+        requires
+            - [begin, end) is the byte range of a token_span output by a
+              conll_span_tokenizer reading from text.
+            - [prev_begin, prev_end) is the byte range of the token_span output just
+              before it, or prev_begin == prev_end if it was the first token.
+        ensures
+            - returns the utf8_apostrophe field of the token_span with the byte range
+              [begin, end).  So this function lets you recover a complete token_span from
+              only its begin and end offsets.
+    !*/
+    {
+        // Only a token that starts with a UTF-8 ’ can have the flag set.
+        if (end - begin < 3 ||
+            (unsigned char)text[begin]   != 0xE2 ||
+            (unsigned char)text[begin+1] != 0x80 ||
+            (unsigned char)text[begin+2] != 0x99)
+            return false;
+
+        // A ’ only gets converted into ' when the tokenizer splits it off the end of
+        // the previous token, so the previous token has to end exactly where this one
+        // begins.  The only other ways to get two touching tokens are when the previous
+        // token is a single punctuation character or a UTF-8 “ split off the front of
+        // this token.  In those cases the ’ is left alone.
+        if (prev_begin == prev_end || prev_end != begin)
+            return false;
+        if (prev_end - prev_begin == 1)
+        {
+            switch (text[prev_begin])
+            {
+                case '[': case ']': case '.': case '(': case ')': case '!':
+                case ',': case '"': case ':': case '|': case '?':
+                    return false;
+            }
+        }
+        else if (prev_end - prev_begin == 3 &&
+            (unsigned char)text[prev_begin]   == 0xE2 &&
+            (unsigned char)text[prev_begin+1] == 0x80 &&
+            (unsigned char)text[prev_begin+2] == 0x9C)
+        {
+            return false;
+        }
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_CONLL_SPaN_TOKENIZER_H_
+
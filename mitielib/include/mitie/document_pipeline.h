@@ -0,0 +1,285 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_DOCUMENT_PIpELINE_H_
+#define MIT_LL_MITIE_DOCUMENT_PIpELINE_H_
+
+#include <mitie/named_entity_extractor.h>
+#include <mitie/binary_relation_detector.h>
+#include <mitie/text_categorizer.h>
+#include <vector>
+#include <string>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct relation_mention
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object records one binary relation found by a document_pipeline.
+                arg1 and arg2 are indices into the entity arrays of the document_analysis
+                that contains this object, while detector is the index of the
+                binary_relation_detector (in the order given to the pipeline) which
+                produced score.
+        !*/
+
+        relation_mention() : detector(0), arg1(0), arg2(0), score(0) {}
+
+        unsigned long detector;
+        unsigned long arg1;
+        unsigned long arg2;
+        double score;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    struct document_analysis
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a simple container for everything a document_pipeline outputs
+                for one document.  You can reuse the same document_analysis object for
+                many documents, in which case the memory held by its vectors is recycled
+                rather than reallocated each time.
+
+                Entities are represented exactly as in named_entity_extractor::predict().
+                That is, entity_ranges[i] is a half open range of tokens,
+                entity_tags[i] indexes into the NER tag name strings, and entity_scores[i]
+                is the classifier confidence.  category_tags[i] and category_scores[i] hold
+                the output of the i-th text_categorizer.  sentences[i] is the half open
+                range of tokens that make up the i-th sentence.
+        !*/
+
+        std::vector<std::string> tokens;
+        std::vector<unsigned long> token_offsets;
+        std::vector<std::pair<unsigned long, unsigned long> > sentences;
+
+        std::vector<std::pair<unsigned long, unsigned long> > entity_ranges;
+        std::vector<unsigned long> entity_tags;
+        std::vector<double> entity_scores;
+
+        std::vector<relation_mention> relations;
+
+        std::vector<std::string> category_tags;
+        std::vector<double> category_scores;
+
+        void clear (
+        );
+        /*!
+            ensures
+                - all the vectors in *this are cleared (their capacity is left alone).
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class document_pipeline
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object bundles a named_entity_extractor, any number of
+                binary_relation_detectors, and any number of text_categorizers into a
+                single tool that takes raw text and runs all of them.
+
+                The point of doing this in one object, rather than calling each model
+                separately, is that the expensive intermediate results are computed only
+                once per document.  In particular, the text is tokenized once and the
+                total_word_feature_extractor word vectors for each token are computed
+                once and then shared by the NER, every relation detector, and every
+                text_categorizer that was trained with the same feature extractor.
+
+                Relation detectors are run on each pair of adjacent entities, in both
+                argument orders, and any relation with a score > 0 is reported.
+
+                Optionally, raw text can first be broken into sentences with a
+                sentence_splitter.  The NER and relation detectors are then run on each
+                sentence separately, which keeps the cost of processing very large
+                documents linear in their size and means no relation is reported between
+                entities in different sentences.  The text_categorizers always see the
+                whole document.
+
+                The pipeline does not copy the models given to it.  It only holds
+                references to them, so building a pipeline costs essentially no extra
+                RAM no matter how big the models are.  This means every model given to
+                a pipeline must outlive it and must not be modified while the pipeline
+                is in use.
+
+            THREAD SAFETY
+                The total_word_feature_extractor inside the NER uses mutable internal
+                scratch space.  Therefore, it is unsafe for two threads to touch the same
+                instance of this object, or of any of the models it references, at a
+                time without mutex locking it first.
+        !*/
+
+    public:
+
+        explicit document_pipeline (
+            const named_entity_extractor& ner
+        );
+        /*!
+            requires
+                - ner will outlive *this.
+            ensures
+                - #get_named_entity_extractor() is a reference to ner
+                - #num_binary_relation_detectors() == 0
+                - #num_text_categorizers() == 0
+                - #get_sentence_splitting() == false
+        !*/
+
+        const named_entity_extractor& get_named_entity_extractor (
+        ) const { return *ner; }
+
+        void set_sentence_splitting (
+            bool enabled
+        ) { split_sentences = enabled; }
+        /*!
+            ensures
+                - #get_sentence_splitting() == enabled
+        !*/
+
+        bool get_sentence_splitting (
+        ) const { return split_sentences; }
+        /*!
+            ensures
+                - returns true if process(text,result) splits text into sentences before
+                  running the NER and relation detectors.
+        !*/
+
+        void add_binary_relation_detector (
+            const binary_relation_detector& detector
+        );
+        /*!
+            requires
+                - detector will outlive *this.
+            ensures
+                - Adds a reference to detector to this pipeline.  It is given the index
+                  num_binary_relation_detectors()-1.
+                - throws dlib::error if detector was trained with a different
+                  total_word_feature_extractor than the one inside
+                  get_named_entity_extractor().
+        !*/
+
+        unsigned long num_binary_relation_detectors (
+        ) const { return detectors.size(); }
+
+        const binary_relation_detector& get_binary_relation_detector (
+            unsigned long idx
+        ) const { return *detectors[idx]; }
+        /*!
+            requires
+                - idx < num_binary_relation_detectors()
+        !*/
+
+        void add_text_categorizer (
+            const text_categorizer& categorizer
+        );
+        /*!
+            requires
+                - categorizer will outlive *this.
+            ensures
+                - Adds a reference to categorizer to this pipeline.  It is given the index
+                  num_text_categorizers()-1.
+                - If categorizer was trained using the same total_word_feature_extractor
+                  as get_named_entity_extractor() then it reuses the word vectors computed
+                  for the NER.  Otherwise it is run on its own just as if
+                  categorizer.predict() had been called directly.
+        !*/
+
+        unsigned long num_text_categorizers (
+        ) const { return categorizers.size(); }
+
+        const text_categorizer& get_text_categorizer (
+            unsigned long idx
+        ) const { return *categorizers[idx]; }
+        /*!
+            requires
+                - idx < num_text_categorizers()
+        !*/
+
+        void process (
+            const std::string& text,
+            document_analysis& result
+        ) const;
+        /*!
+            ensures
+                - Tokenizes text with the conll_span_tokenizer and then runs every model in
+                  this pipeline on the resulting tokens.
+                - #result.tokens == the tokens in text.
+                - #result.token_offsets[i] == the byte offset of #result.tokens[i] in text.
+                - if (get_sentence_splitting()) then
+                    - #result.sentences == the sentences found by a sentence_splitter.
+                - else
+                    - #result.sentences contains a single range covering all the tokens
+                      (or is empty if there are no tokens).
+                - #result contains the entities, relations, and categories found in text.
+        !*/
+
+        void process (
+            const char* text,
+            unsigned long length,
+            document_analysis& result
+        ) const;
+        /*!
+            requires
+                - text points to an array of at least length bytes.
+            ensures
+                - This function is identical to process(std::string(text,length),result)
+                  except that it works directly on the given buffer rather than a copy of
+                  it.  So you can, for example, process the contents of a mapped_file
+                  without ever loading it into a std::string.
+        !*/
+
+        void process (
+            const std::vector<std::string>& tokens,
+            document_analysis& result
+        ) const;
+        /*!
+            ensures
+                - Runs every model in this pipeline on the given already tokenized text.
+                - #result.tokens == tokens
+                - #result.token_offsets.size() == 0
+                - The tokens are treated as a single sentence regardless of
+                  get_sentence_splitting().
+                - #result contains the entities, relations, and categories found in tokens.
+        !*/
+
+    private:
+
+        void process_sentence (
+            std::vector<std::string>& words,
+            document_analysis& result,
+            std::vector<dlib::matrix<float,0,1> >& doc_feats
+        ) const;
+        /*!
+            ensures
+                - Runs the NER and relation detectors on words and appends the results,
+                  with indices adjusted, to result.  The contents of words are moved onto
+                  the end of result.tokens.
+                - if (any text_categorizer can reuse the NER word vectors) then
+                    - the word vectors for words are moved onto the end of doc_feats.
+        !*/
+
+        void categorize (
+            document_analysis& result,
+            const std::vector<dlib::matrix<float,0,1> >& doc_feats
+        ) const;
+
+        // The models are owned by the caller.  See the class documentation.
+        const named_entity_extractor* ner;
+        bool split_sentences;
+        std::vector<const binary_relation_detector*> detectors;
+        std::vector<const text_categorizer*> categorizers;
+        // categorizer_shares_feats[i] == true if categorizers[i] can use the NER word
+        // vectors.
+        std::vector<bool> categorizer_shares_feats;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_DOCUMENT_PIpELINE_H_
+
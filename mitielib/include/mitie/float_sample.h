@@ -0,0 +1,244 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_FLOAT_SaMPLE_H_
+#define MIT_LL_MITIE_FLOAT_SaMPLE_H_
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <dlib/uintn.h>
+#include <dlib/matrix.h>
+#include <dlib/svm.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct float_sample
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a compact version of the sparse feature vectors produced by
+                extract_ner_chunk_features() and the text feature extractors, used to
+                hold training samples.  Those vectors are a set of hashed features
+                followed by a long dense block copied from the float valued word
+                vectors.  Stored as std::pair<dlib::uint32,double> the dense block takes
+                16 bytes per value.  Here it takes 4, since it's kept as a contiguous
+                array of floats that starts at index dense_offset, and the hashed
+                features are stored as floats too.
+
+                The functions below let the dlib linear trainers and
+                multiclass_linear_decision_function<sparse_linear_kernel<float_sample>>
+                work with this type.
+
+            CONVENTION
+                - This object represents the sparse vector with the elements in sparse
+                  plus, for all valid i, the element (dense_offset+i, dense[i]).
+                - All the indices in sparse are < dense_offset.
+        !*/
+
+        float_sample() : dense_offset(0) {}
+
+        void swap (
+            float_sample& item
+        )
+        {
+            sparse.swap(item.sparse);
+            std::swap(dense_offset, item.dense_offset);
+            dense.swap(item.dense);
+        }
+
+        std::vector<std::pair<dlib::uint32,float> > sparse;
+        dlib::uint32 dense_offset;
+        std::vector<float> dense;
+    };
+
+    inline void swap (
+        float_sample& a,
+        float_sample& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+    inline float_sample make_float_sample (
+        const std::vector<std::pair<dlib::uint32,double> >& x,
+        const dlib::uint32 dense_offset
+    )
+    /*!
+        ensures
+            - returns a float_sample representing the same vector as x, except that the
+              values are rounded to float.
+            - The trailing elements of x with indices dense_offset, dense_offset+1,
+              dense_offset+2, and so on, become the dense part of the returned sample.
+              So for the outputs of the MITIE feature extractors, which put their
+              dense features at MAX_FEAT onward, dense_offset should be MAX_FEAT.
+    !*/
+    {
+        // find where the dense block starts, if x has one
+        unsigned long begin = x.size();
+        for (unsigned long i = 0; i < x.size(); ++i)
+        {
+            if (x[i].first != dense_offset)
+                continue;
+            unsigned long j = i;
+            while (j < x.size() && x[j].first == dense_offset + (j-i))
+                ++j;
+            if (j == x.size())
+                begin = i;
+            break;
+        }
+
+        float_sample result;
+        result.dense_offset = dense_offset;
+        result.sparse.reserve(begin);
+        for (unsigned long i = 0; i < begin; ++i)
+        {
+            DLIB_ASSERT(x[i].first < dense_offset, "All sparse features must come before the dense block.");
+            result.sparse.push_back(std::make_pair(x[i].first, static_cast<float>(x[i].second)));
+        }
+        result.dense.reserve(x.size()-begin);
+        for (unsigned long i = begin; i < x.size(); ++i)
+            result.dense.push_back(static_cast<float>(x[i].second));
+        return result;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    // The overloads below would otherwise hide dlib's versions from unqualified calls
+    // made inside namespace mitie.
+    using dlib::dot;
+    using dlib::assign;
+    using dlib::max_index_plus_one;
+
+    template <typename EXP>
+    typename EXP::type dot (
+        const dlib::matrix_exp<EXP>& w,
+        const float_sample& x
+    )
+    /*!
+        requires
+            - w is a column or row vector
+        ensures
+            - returns the dot product between w and x.  Like dlib's dot() for sparse
+              vectors, elements of x with indices >= w.size() are ignored.
+    !*/
+    {
+        typedef typename EXP::type scalar_type;
+        scalar_type sum = 0;
+        for (unsigned long i = 0; i < x.sparse.size(); ++i)
+        {
+            if (x.sparse[i].first < (unsigned long)w.size())
+                sum += w(x.sparse[i].first)*x.sparse[i].second;
+        }
+        const long end = std::min<long>(w.size(), (long)x.dense_offset + (long)x.dense.size());
+        for (long i = x.dense_offset; i < end; ++i)
+            sum += w(i)*x.dense[i-x.dense_offset];
+        return sum;
+    }
+
+    template <typename T>
+    void assign (
+        T& dest,
+        const float_sample& src
+    )
+    /*!
+        requires
+            - T is a std::vector of std::pairs, i.e. a dlib unsorted sparse vector.
+        ensures
+            - #dest == src converted to T's element type.
+    !*/
+    {
+        // This is called for every sample in every solver iteration, so fill dest
+        // through a pointer rather than with push_back().
+        dest.resize(src.sparse.size() + src.dense.size());
+        if (dest.size() == 0)
+            return;
+        typename T::value_type* out = &dest[0];
+        for (unsigned long i = 0; i < src.sparse.size(); ++i, ++out)
+        {
+            out->first = src.sparse[i].first;
+            out->second = src.sparse[i].second;
+        }
+        for (unsigned long i = 0; i < src.dense.size(); ++i, ++out)
+        {
+            out->first = src.dense_offset+i;
+            out->second = src.dense[i];
+        }
+    }
+
+    inline unsigned long max_index_plus_one (
+        const std::vector<float_sample>& samples
+    )
+    /*!
+        ensures
+            - returns the dimensionality of the samples, in the sense of dlib's
+              max_index_plus_one() for sparse vectors.
+    !*/
+    {
+        unsigned long dims = 0;
+        for (unsigned long i = 0; i < samples.size(); ++i)
+        {
+            const float_sample& x = samples[i];
+            for (unsigned long j = 0; j < x.sparse.size(); ++j)
+                dims = std::max<unsigned long>(dims, x.sparse[j].first+1);
+            if (x.dense.size() != 0)
+                dims = std::max<unsigned long>(dims, x.dense_offset + x.dense.size());
+        }
+        return dims;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename dest_type, typename src_type>
+    void convert_linear_decision_function (
+        const src_type& src,
+        dest_type& dest
+    )
+    /*!
+        requires
+            - src_type and dest_type are dlib::multiclass_linear_decision_function
+              objects with the same label type but possibly different sample types.
+        ensures
+            - #dest computes the same function as src, for the sample type dest uses.
+              This is how a classifier trained on float_samples is turned into one for
+              the std::vector<std::pair<dlib::uint32,double> > samples MITIE's models
+              use, and vice versa.
+    !*/
+    {
+        dest.labels = src.labels;
+        dest.weights = src.weights;
+        dest.b = src.b;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+namespace dlib
+{
+    template <>
+    struct sparse_linear_kernel<mitie::float_sample>
+    {
+        /*!
+            The general sparse_linear_kernel gets its scalar type from the sample's
+            elements.  float_samples are trained with double precision weights, so
+            this is spelled out here.  This lets float_samples be used with
+            svm_multiclass_linear_trainer and multiclass_linear_decision_function.
+        !*/
+        typedef double scalar_type;
+        typedef mitie::float_sample sample_type;
+        typedef default_memory_manager mem_manager_type;
+
+        bool operator== (
+            const sparse_linear_kernel&
+        ) const
+        {
+            return true;
+        }
+    };
+}
+
+#endif // MIT_LL_MITIE_FLOAT_SaMPLE_H_
+
@@ -0,0 +1,90 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_MAPPED_FiLE_H_
+#define MIT_LL_MITIE_MAPPED_FiLE_H_
+
+#include <string>
+#include <vector>
+#include <dlib/noncopyable.h>
+#include <dlib/uintn.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_file : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object gives read only access to the entire contents of a file as one
+                contiguous block of memory.
+
+                Whenever possible the file is memory mapped rather than read, so opening
+                even a very large file costs almost nothing and the pages are only brought
+                in from disk as they are touched.  The operating system is also told that
+                the file will be read sequentially so it can read ahead aggressively and
+                drop pages that have already been processed.  Files that can't be mapped
+                (e.g. pipes, character devices, or empty files, and all files on Windows)
+                are instead read into memory owned by this object.  Either way, the
+                contents are accessed the same way.
+
+                Note that the contents are not NULL terminated.
+        !*/
+
+    public:
+
+        explicit mapped_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - #data() points to the contents of the given file.
+                - #size() == the number of bytes in the file.
+            throws
+                - dlib::error if the file can't be opened, or if it is too big to fit in
+                  this process's address space (i.e. its size doesn't fit in a size_t).
+        !*/
+
+        ~mapped_file (
+        );
+
+        const char* data (
+        ) const { return ptr; }
+        /*!
+            ensures
+                - returns a pointer to the first byte of the file.  The file contents are
+                  data()[0] through data()[size()-1].  If size() == 0 this may be NULL.
+        !*/
+
+        dlib::uint64 size (
+        ) const { return length; }
+        /*!
+            ensures
+                - returns the number of bytes in the file.  This is always small enough
+                  to fit in a size_t.
+        !*/
+
+        bool is_memory_mapped (
+        ) const { return mapped; }
+        /*!
+            ensures
+                - returns true if the file is memory mapped and false if it was read into
+                  a buffer instead.
+        !*/
+
+    private:
+
+        const char* ptr;
+        dlib::uint64 length;
+        bool mapped;
+        std::vector<char> buf;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_MAPPED_FiLE_H_
+
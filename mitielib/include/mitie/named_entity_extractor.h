@@ -161,6 +161,25 @@ namespace mitie
                       an exception is thrown if there is a mismatch
         !*/
 
+        void predict(
+            const std::vector<std::string>& sentence,
+            const std::vector<dlib::matrix<float,0,1> >& sentence_feats,
+            std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+            std::vector<unsigned long>& chunk_tags,
+            std::vector<double>& chunk_scores,
+            const total_word_feature_extractor& fe
+        ) const;
+        /*!
+            requires
+                - sentence_feats == sentence_to_feats(fe, sentence)
+            ensures
+                - This function is identical to predict(sentence,chunks,chunk_tags,chunk_scores,fe)
+                  except that it uses the word feature vectors in sentence_feats rather than
+                  computing them itself.  This lets a caller that needs the word features
+                  for other purposes (e.g. relation extraction or text categorization) compute
+                  them only once.
+        !*/
+
         void operator() (
             const std::vector<std::string>& sentence,
             std::vector<std::pair<unsigned long, unsigned long> >& chunks,
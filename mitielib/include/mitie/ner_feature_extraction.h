@@ -76,6 +76,19 @@ namespace mitie
                     V[i] == the word feature vector for the word sentence[i]
     !*/
 
+    std::vector<dlib::matrix<float,0,1> > sentence_to_feats (
+        const total_word_feature_extractor& fe,
+        const std::vector<std::string>& sentence,
+        std::vector<dlib::uint16>& scratch
+    );
+    /*!
+        ensures
+            - returns the same thing as sentence_to_feats(fe, sentence).  However, scratch
+              is used as working memory rather than memory inside fe.  This means it is
+              safe for multiple threads to call this function with the same fe at the
+              same time, so long as each thread uses its own scratch vector.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     const unsigned long MAX_FEAT = 500000;
@@ -0,0 +1,209 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_NER_FEATURE_SToRE_H_
+#define MIT_LL_MITIE_NER_FEATURE_SToRE_H_
+
+#include <string>
+#include <vector>
+#include <dlib/uintn.h>
+#include <dlib/matrix.h>
+#include <dlib/smart_pointers.h>
+#include <mitie/mapped_file.h>
+#include <mitie/total_word_feature_extractor.h>
+#include <mitie/ner_training_corpus.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct ner_sentence_feats
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a lightweight reference to the word feature vectors of one
+                sentence held inside a ner_feature_store.  It is the sequence type used
+                by ner_store_feature_extractor, so copying it around (e.g. when the
+                cross-validation routines split the training data into folds) only copies
+                a pointer rather than the feature vectors themselves.
+        !*/
+
+        ner_sentence_feats() : feats(0), num_tokens(0), num_dims(0) {}
+
+        ner_sentence_feats (
+            const float* feats_,
+            unsigned long num_tokens_,
+            unsigned long num_dims_
+        ) : feats(feats_), num_tokens(num_tokens_), num_dims(num_dims_) {}
+
+        unsigned long size (
+        ) const { return num_tokens; }
+
+        const float* operator[] (
+            unsigned long i
+        ) const { return feats + i*num_dims; }
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns a pointer to the num_dims elements of the feature vector for
+                  the i-th word in the sentence.
+        !*/
+
+        const float* feats;
+        unsigned long num_tokens;
+        unsigned long num_dims;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class ner_store_feature_extractor
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a version of the ner_feature_extractor that reads the word
+                feature vectors out of a ner_feature_store.  It produces exactly the same
+                features as ner_feature_extractor and is serialized the same way, so a
+                sequence_segmenter trained with it can be turned into a
+                sequence_segmenter<ner_feature_extractor> just by copying its weights.
+        !*/
+
+    public:
+        typedef ner_sentence_feats sequence_type;
+
+        ner_store_feature_extractor() :num_feats(1) {}
+
+        ner_store_feature_extractor (
+            unsigned long num_feats_
+        ) :
+            num_feats(num_feats_)
+        {}
+
+        unsigned long num_feats;
+
+        const static bool use_BIO_model           = false;
+        const static bool use_high_order_features = false;
+        const static bool allow_negative_weights  = true;
+
+        unsigned long window_size()  const { return 3; }
+
+        unsigned long num_features() const { return num_feats; }
+
+        template <typename feature_setter>
+        void get_features (
+            feature_setter& set_feature,
+            const sequence_type& sentence,
+            unsigned long position
+        ) const
+        {
+            const float* feats = sentence[position];
+            for (unsigned long i = 0; i < sentence.num_dims; ++i)
+                set_feature(i, feats[i]);
+        }
+    };
+
+    inline void serialize(const ner_store_feature_extractor& item, std::ostream& out)
+    {
+        dlib::serialize(item.num_feats, out);
+    }
+    inline void deserialize(ner_store_feature_extractor& item, std::istream& in)
+    {
+        dlib::deserialize(item.num_feats, in);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class ner_feature_store : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the word feature vectors (i.e. the output of
+                sentence_to_feats()) for a whole set of training sentences.  It lets a
+                trainer run the total_word_feature_extractor over its data once and then
+                reuse the results in every training and cross-validation pass.
+
+                All the vectors are packed back to back in one contiguous block of
+                floats, so there is no per-word allocation overhead.  The block can
+                either live in RAM or in a scratch file that is memory mapped, in which
+                case the operating system pages the features in and out as needed and
+                the store takes up essentially no RAM of its own.
+
+            THREAD SAFETY
+                Once constructed this object is read only, so any number of threads may
+                use it at the same time.
+        !*/
+
+    public:
+
+        ner_feature_store (
+            const total_word_feature_extractor& fe,
+            const ner_training_corpus& sentences,
+            unsigned long num_threads,
+            const std::string& cache_filename = ""
+        );
+        /*!
+            requires
+                - num_threads > 0
+            ensures
+                - #size() == sentences.size()
+                - #get_num_dimensions() == fe.get_num_dimensions()
+                - for all valid i:
+                    - (*this)[i] refers to the vectors of sentence_to_feats(fe,T) where
+                      T is the tokens of sentences' i-th sentence.
+                - The features are computed using num_threads threads.
+                - if (cache_filename != "") then
+                    - The features are written to cache_filename and that file is memory
+                      mapped rather than holding the features in RAM.  The file is
+                      deleted when this object is destroyed.
+            throws
+                - dlib::error if cache_filename can't be written.
+        !*/
+
+        ~ner_feature_store (
+        );
+
+        unsigned long size (
+        ) const { return offsets.size()-1; }
+
+        unsigned long get_num_dimensions (
+        ) const { return num_dims; }
+
+        ner_sentence_feats operator[] (
+            unsigned long i
+        ) const { return ner_sentence_feats(feats + offsets[i]*num_dims, offsets[i+1]-offsets[i], num_dims); }
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns a reference to the features of the i-th sentence.
+        !*/
+
+        void get_sentence_feats (
+            unsigned long i,
+            std::vector<dlib::matrix<float,0,1> >& sent
+        ) const;
+        /*!
+            requires
+                - i < size()
+            ensures
+                - #sent == a copy of the features of the i-th sentence in the form
+                  returned by sentence_to_feats().
+        !*/
+
+    private:
+
+        unsigned long num_dims;
+        std::vector<dlib::uint64> offsets;
+        std::vector<float> mem;
+        dlib::scoped_ptr<mapped_file> file;
+        std::string filename;
+        const float* feats;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_NER_FEATURE_SToRE_H_
+
@@ -9,6 +9,10 @@
 #include <utility>
 #include <mitie/total_word_feature_extractor.h>
 #include <mitie/named_entity_extractor.h>
+#include <mitie/ner_feature_store.h>
+#include <mitie/ner_training_corpus.h>
+#include <mitie/float_sample.h>
+#include <mitie/training_options.h>
 #include <dlib/svm.h>
 #include <map>
 
@@ -114,6 +118,10 @@ namespace mitie
             WHAT THIS OBJECT REPRESENTS
                 This is a tool for training mitie::named_entity_extractor objects from a 
                 set of annotated training data.
+
+                The training data is kept in a ner_training_corpus, so each distinct
+                token is only stored once no matter how many times it appears.  This
+                lets the trainer hold corpora with millions of sentences.
         !*/
     public:
         explicit ner_trainer (
@@ -123,6 +131,14 @@ namespace mitie
             ensures
                 - #get_beta() == 0.5
                 - #num_threads() == 4
+                - #get_feature_cache_file() == ""
+                - #get_parallel_search() == false
+                - #get_online_training_epochs() == 0
+                - #has_base_model() == false
+                - #replay_size() == 0
+                - #get_replay_ratio() == 1
+                - #get_training_options() == a default initialized training_options
+                  object, i.e. training isn't limited and progress isn't reported.
                 - This function attempts to load a mitie::total_word_feature_extractor from the
                   file with the given filename.  This feature extractor is used during the
                   NER training process.  
@@ -135,6 +151,14 @@ namespace mitie
                 - returns the number of training instances that have been added into this object.
         !*/
 
+        dlib::uint64 get_memory_usage (
+        ) const;
+        /*!
+            ensures
+                - returns the number of bytes of memory used to store the training
+                  instances given to add() and add_replay().
+        !*/
+
         void add (
             const ner_training_instance& item
         );
@@ -177,6 +201,91 @@ namespace mitie
                   data into a trainer in one call).
         !*/
 
+        void set_base_model (
+            const named_entity_extractor& ner
+        );
+        /*!
+            requires
+                - ner was trained using the same total_word_feature_extractor this
+                  object was constructed from.
+            ensures
+                - #has_base_model() == true
+                - train() will update ner rather than training a new
+                  named_entity_extractor from scratch.  That is, it continues training
+                  ner's segmenter and segment classifier from their current weights
+                  using the averaged perceptron described in
+                  get_online_training_epochs(), but run over only the instances given to
+                  add() and a sample of the ones given to add_replay().  So updating a
+                  model with a few hundred new sentences takes minutes rather than the
+                  hours it takes to retrain on the whole corpus.
+                - The updated model can tag all of ner's entity types as well as any new
+                  ones found in the training data.  In particular, get_all_labels()
+                  begins with ner.get_tag_name_strings().
+        !*/
+
+        bool has_base_model (
+        ) const;
+        /*!
+            ensures
+                - returns true if set_base_model() has been called and false otherwise.
+        !*/
+
+        unsigned long replay_size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of training instances that have been added into this
+                  object via add_replay().
+        !*/
+
+        void add_replay (
+            const ner_training_instance& item
+        );
+        /*!
+            ensures
+                - #replay_size() == replay_size() + 1
+                - Adds the given training instance into this object as replay data.
+                  When updating a model with set_base_model() you will usually want to
+                  give it some of the data the model was originally trained on as well
+                  as the new data.  Otherwise the updates can make the model forget
+                  things it used to get right that the new data doesn't happen to
+                  cover.  train() adds a random sample of the replay data to the
+                  training data, see get_replay_ratio().
+        !*/
+
+        void add_replay (
+            const std::vector<std::string>& tokens,
+            const std::vector<std::pair<unsigned long,unsigned long> >& ranges,
+            const std::vector<std::string>& labels
+        );
+        /*!
+            requires
+                - it must be legal to call add(tokens, ranges, labels)
+            ensures
+                - This function is just like add(tokens, ranges, labels) except that it
+                  adds the training instance as replay data like add_replay(item) does.
+        !*/
+
+        double get_replay_ratio (
+        ) const;
+        /*!
+            ensures
+                - returns the amount of replay data train() uses relative to the amount
+                  of regular training data.  In particular, train() adds
+                  min(replay_size(), get_replay_ratio()*size()) randomly chosen replay
+                  instances to the training data.
+        !*/
+
+        void set_replay_ratio (
+            double ratio
+        );
+        /*!
+            requires
+                - ratio >= 0
+            ensures
+                - #get_replay_ratio() == ratio
+        !*/
+
         unsigned long get_num_threads (
         ) const;
         /*!
@@ -221,6 +330,116 @@ namespace mitie
                 - #get_beta() == new_beta
         !*/
 
+        bool get_parallel_search (
+        ) const;
+        /*!
+            ensures
+                - returns true if train() uses a parallel search to pick the parameters
+                  of the segmenter and segment classifier and false if it uses the
+                  default serial search.
+
+                  The default search runs BOBYQA (or a single variable line search) and
+                  so only ever tries one parameter setting at a time, running the
+                  cross-validation folds for it one after another.  The parallel search
+                  instead tries a grid of parameter settings around the best one found
+                  so far, several at once, and trains the cross-validation folds of each
+                  setting at the same time.  All of this is done within the
+                  get_num_threads() thread budget.  It generally tries more parameter
+                  settings than the serial search but, on a machine with many cores,
+                  finishes much sooner.  It also prints how long the search took compared
+                  to running the same evaluations serially.  If get_num_threads() is too
+                  small to try more than one setting at a time, the parallel search
+                  would only be slower, so train() uses the serial search anyway.
+        !*/
+
+        void set_parallel_search (
+            bool enabled
+        );
+        /*!
+            ensures
+                - #get_parallel_search() == enabled
+        !*/
+
+        unsigned long get_online_training_epochs (
+        ) const;
+        /*!
+            ensures
+                - returns the number of passes over the training data train() makes when
+                  using its fast online training mode, or 0 if it uses the default
+                  structural SVM training.
+
+                  The default training learns the segmenter with a structural SVM and
+                  the segment classifier with a multiclass SVM, using cross-validation
+                  to pick their parameters.  This gives the best results but can take
+                  hours on a large training set.  The online mode trains both with
+                  averaged perceptrons instead, making exactly
+                  get_online_training_epochs() passes over the data and doing no
+                  parameter search.  It is typically much faster and its running time
+                  is predictable, which makes it useful for quickly checking changes to
+                  the training data, though the resulting extractor is usually somewhat
+                  less accurate.  Each pass is split over get_num_threads() threads
+                  using iterative parameter mixing.  Either way the result is an
+                  ordinary named_entity_extractor.
+                - When updating a model given to set_base_model(), train() always uses
+                  the averaged perceptron.  If get_online_training_epochs() == 0 it
+                  makes 10 passes over the data.
+        !*/
+
+        void set_online_training_epochs (
+            unsigned long epochs
+        );
+        /*!
+            ensures
+                - #get_online_training_epochs() == epochs
+        !*/
+
+        const std::string& get_feature_cache_file (
+        ) const;
+        /*!
+            ensures
+                - returns the name of the file train() uses to hold the word feature
+                  vectors of the training sentences, or "" if they are kept in RAM.
+
+                  train() runs the total_word_feature_extractor over each training
+                  sentence only once and keeps the results in a ner_feature_store, which
+                  the segmenter training, all the cross-validation folds of the parameter
+                  search, and the segment classifier feature extraction then read from.
+                  For very large training sets this store can be bigger than you want to
+                  keep in RAM, in which case you can have it written to a memory mapped
+                  file instead.
+        !*/
+
+        void set_feature_cache_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - #get_feature_cache_file() == filename
+                - if (filename != "") then
+                    - train() writes the word feature vectors to this file, memory maps
+                      it while training, and deletes it when it's done.  So filename
+                      should be somewhere with enough disk space to hold one word feature
+                      vector (i.e. get_num_dimensions() floats from the
+                      total_word_feature_extractor) for every token in the training data.
+        !*/
+
+        const training_options& get_training_options (
+        ) const;
+        /*!
+            ensures
+                - returns the limits on how long train() spends searching for the
+                  segmenter's and segment classifier's parameters, and the callback it
+                  reports its progress to.  See training_options for details.
+        !*/
+
+        void set_training_options (
+            const training_options& options
+        );
+        /*!
+            ensures
+                - #get_training_options() == options
+        !*/
+
         named_entity_extractor train (
         ) const;
         /*!
@@ -239,18 +458,27 @@ namespace mitie
 
         typedef dlib::multiclass_linear_decision_function<dlib::sparse_linear_kernel<ner_sample_type>,unsigned long> classifier_type;
         classifier_type train_ner_segment_classifier (
-            const std::vector<ner_sample_type>& samples,
-            const std::vector<unsigned long>& labels
+            const std::vector<float_sample>& samples,
+            const std::vector<unsigned long>& labels,
+            training_monitor& monitor
         ) const;
 
         void extract_ner_segment_feats (
-            const dlib::sequence_segmenter<ner_feature_extractor>& segmenter,
-            std::vector<ner_sample_type>& samples,
+            const ner_feature_store& feats,
+            const ner_training_corpus& train_data,
+            const dlib::sequence_segmenter<ner_store_feature_extractor>& segmenter,
+            std::vector<float_sample>& samples,
             std::vector<unsigned long>& labels
         ) const;
 
         void train_segmenter (
-            dlib::sequence_segmenter<ner_feature_extractor>& segmenter
+            const ner_feature_store& feats,
+            const ner_training_corpus& train_data,
+            dlib::sequence_segmenter<ner_store_feature_extractor>& segmenter,
+            training_monitor& monitor
+        ) const;
+
+        unsigned long get_perceptron_epochs (
         ) const;
 
         unsigned long get_label_id (
@@ -264,10 +492,20 @@ namespace mitie
         total_word_feature_extractor tfe;
         double beta;
         unsigned long num_threads;
+        bool parallel_search;
+        unsigned long online_training_epochs;
+        std::string feature_cache_file;
+        training_options options;
         std::map<std::string,unsigned long> label_to_id;
-        std::vector<std::vector<std::string> > sentences;
-        std::vector<std::vector<std::pair<unsigned long, unsigned long> > > chunks;
-        std::vector<std::vector<unsigned long> > chunk_labels;
+        ner_training_corpus corpus;
+        // named_entity_extractor isn't assignable, so we keep the parts of the base
+        // model train() needs.
+        bool has_base;
+        unsigned long base_num_tags;
+        dlib::matrix<double,0,1> base_segmenter_weights;
+        classifier_type base_df;
+        double replay_ratio;
+        ner_training_corpus replay_corpus;
     };
 
 // ----------------------------------------------------------------------------------------
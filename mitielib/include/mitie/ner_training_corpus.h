@@ -0,0 +1,209 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_NER_TRAINING_CoRPUS_H_
+#define MIT_LL_MITIE_NER_TRAINING_CoRPUS_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <dlib/uintn.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class ner_training_corpus
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds a set of sentences along with the labeled entity
+                chunks in each of them.  It's what the ner_trainer keeps its training
+                data in.
+
+                Storing each sentence as a std::vector<std::string> costs a heap
+                allocation and a string header per token, which is several times the
+                size of the text itself.  So instead this object interns the tokens.
+                Each distinct token is stored once in a shared string pool and
+                identified by a 32 bit id.  A sentence is then just a range of token ids
+                in one contiguous array, and the chunks of all the sentences are
+                likewise packed into one array.
+
+            CONVENTION
+                - size() == token_offsets.size()-1 == chunk_offsets.size()-1
+                - The ids of the tokens in the i-th sentence are
+                  token_ids[token_offsets[i]] through token_ids[token_offsets[i+1]-1].
+                - The chunks of the i-th sentence are chunks[chunk_offsets[i]] through
+                  chunks[chunk_offsets[i+1]-1].
+                - get_num_unique_tokens() == pool_offsets.size()-1
+                - The token with id t is the text from pool[pool_offsets[t]] to
+                  pool[pool_offsets[t+1]-1].
+                - hash_table is an open addressing hash table of token ids, keyed by
+                  the token text.  Empty slots hold EMPTY_SLOT.  Its size is a power of 2
+                  and it's never more than half full.
+        !*/
+
+    public:
+
+        ner_training_corpus (
+        );
+        /*!
+            ensures
+                - #size() == 0
+                - #get_num_unique_tokens() == 0
+        !*/
+
+        unsigned long size (
+        ) const { return token_offsets.size()-1; }
+
+        unsigned long get_num_unique_tokens (
+        ) const { return pool_offsets.size()-1; }
+
+        void add (
+            const std::vector<std::string>& tokens,
+            const std::vector<std::pair<unsigned long,unsigned long> >& chunks,
+            const std::vector<unsigned long>& chunk_labels
+        );
+        /*!
+            requires
+                - chunks.size() == chunk_labels.size()
+                - for all valid i:
+                    - chunks[i].first < chunks[i].second <= tokens.size()
+            ensures
+                - #size() == size() + 1
+                - Adds the given sentence and its labeled chunks to the end of this
+                  corpus.  Any tokens that haven't been seen before are added to the
+                  string pool.
+        !*/
+
+        void add (
+            const ner_training_corpus& other,
+            unsigned long i
+        );
+        /*!
+            requires
+                - i < other.size()
+            ensures
+                - #size() == size() + 1
+                - Adds a copy of other's i-th sentence to the end of this corpus.
+        !*/
+
+        unsigned long num_tokens (
+            unsigned long i
+        ) const { return token_offsets[i+1]-token_offsets[i]; }
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns the number of tokens in the i-th sentence.
+        !*/
+
+        void get_tokens (
+            unsigned long i,
+            std::vector<std::string>& tokens
+        ) const;
+        /*!
+            requires
+                - i < size()
+            ensures
+                - #tokens == the tokens of the i-th sentence.
+        !*/
+
+        void get_chunks (
+            unsigned long i,
+            std::vector<std::pair<unsigned long,unsigned long> >& chunks
+        ) const;
+        /*!
+            requires
+                - i < size()
+            ensures
+                - #chunks == the ranges of the entities in the i-th sentence.
+        !*/
+
+        void get_chunk_labels (
+            unsigned long i,
+            std::vector<unsigned long>& chunk_labels
+        ) const;
+        /*!
+            requires
+                - i < size()
+            ensures
+                - #chunk_labels == the labels of the entities in the i-th sentence.
+                  That is, chunk_labels[j] is the label of the entity get_chunks() puts
+                  in chunks[j].
+        !*/
+
+        void remap_labels (
+            const std::vector<unsigned long>& new_labels
+        );
+        /*!
+            requires
+                - for all chunk labels L in this corpus:
+                    - L < new_labels.size()
+            ensures
+                - Replaces each chunk label L in this corpus with new_labels[L].
+        !*/
+
+        dlib::uint64 get_memory_usage (
+        ) const;
+        /*!
+            ensures
+                - returns the number of bytes of memory this object has allocated.
+        !*/
+
+        void swap (
+            ner_training_corpus& item
+        );
+        /*!
+            ensures
+                - swaps the state of *this and item
+        !*/
+
+    private:
+
+        struct chunk
+        {
+            chunk() : begin(0), end(0), label(0) {}
+            chunk(dlib::uint32 b, dlib::uint32 e, dlib::uint32 l) : begin(b), end(e), label(l) {}
+
+            dlib::uint32 begin;
+            dlib::uint32 end;
+            dlib::uint32 label;
+        };
+
+        dlib::uint32 intern (
+            const std::string& token
+        );
+
+        dlib::uint32 hash_token (
+            const char* str,
+            unsigned long len
+        ) const;
+
+        void grow_hash_table (
+        );
+
+        const static dlib::uint32 EMPTY_SLOT = 0xFFFFFFFF;
+
+        std::vector<char> pool;
+        std::vector<dlib::uint64> pool_offsets;
+        std::vector<dlib::uint32> hash_table;
+
+        std::vector<dlib::uint32> token_ids;
+        std::vector<dlib::uint64> token_offsets;
+        std::vector<chunk> chunks;
+        std::vector<dlib::uint64> chunk_offsets;
+    };
+
+    inline void swap (
+        ner_training_corpus& a,
+        ner_training_corpus& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_NER_TRAINING_CoRPUS_H_
+
@@ -0,0 +1,481 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_PARALLEL_GROUP_ToKENIZER_H_
+#define MIT_LL_PARALLEL_GROUP_ToKENIZER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <dlib/dir_nav.h>
+#include <dlib/threads.h>
+#include <dlib/error.h>
+#include <mitie/gigaword_reader.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class token_block
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is a compact list of tokens.  Rather than holding a
+                std::string for each token it stores all the characters in one buffer
+                along with where each token ends, so filling it with the tokens from an
+                entire file only needs a handful of memory allocations.
+        !*/
+
+    public:
+
+        unsigned long size (
+        ) const { return ends.size(); }
+
+        void clear (
+        )
+        {
+            chars.clear();
+            ends.clear();
+        }
+
+        void add (
+            const std::string& token
+        )
+        /*!
+            ensures
+                - #size() == size() + 1
+                - appends token to the end of this block.
+        !*/
+        {
+            chars += token;
+            ends.push_back(chars.size());
+        }
+
+        void get (
+            unsigned long i,
+            std::string& token
+        ) const
+        /*!
+            requires
+                - i < size()
+            ensures
+                - #token == the i-th token added to this block.
+        !*/
+        {
+            const unsigned long begin = (i == 0) ? 0 : ends[i-1];
+            token.assign(chars, begin, ends[i] - begin);
+        }
+
+        void swap (
+            token_block& item
+        )
+        {
+            chars.swap(item.chars);
+            ends.swap(item.ends);
+        }
+
+    private:
+        std::string chars;
+        std::vector<unsigned long> ends;
+    };
+
+    inline void swap (
+        token_block& a,
+        token_block& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename basic_tokenizer
+        >
+    struct text_file_tokenizer
+    {
+        /*!
+            REQUIREMENTS ON basic_tokenizer
+                This must be an object with an interface compatible with the unigram_tokenizer.
+
+            WHAT THIS OBJECT REPRESENTS
+                This is a file tokenizer for parallel_group_tokenizer that reads plain text
+                files.  It produces exactly the tokens group_tokenizer<basic_tokenizer>
+                would produce for the same file.
+        !*/
+
+        void operator() (
+            const std::string& filename,
+            token_block& tokens
+        ) const
+        {
+            std::ifstream fin(filename.c_str());
+            basic_tokenizer tok(fin);
+            std::string token;
+            while (tok(token))
+                tokens.add(token);
+        }
+    };
+
+    template <
+        typename basic_tokenizer
+        >
+    struct gigaword_file_tokenizer
+    {
+        /*!
+            REQUIREMENTS ON basic_tokenizer
+                This must be an object with an interface compatible with the unigram_tokenizer.
+
+            WHAT THIS OBJECT REPRESENTS
+                This is a file tokenizer for parallel_group_tokenizer that reads gigaword
+                XML files.  It produces exactly the tokens gigaword_tokenizer<basic_tokenizer>
+                would produce for the same file.  Since the XML parsing of each file is
+                what makes gigaword_tokenizer slow, doing it on parallel_group_tokenizer's
+                thread pool is where most of the speedup comes from.
+        !*/
+
+        void operator() (
+            const std::string& filename,
+            token_block& tokens
+        ) const
+        {
+            std::ifstream fin(filename.c_str());
+            gigaword_file_reader reader(fin);
+            gigaword_document doc;
+            std::istringstream sin;
+            std::string token;
+            while (reader(doc))
+            {
+                sin.clear();
+                sin.str(doc.text);
+                basic_tokenizer tok(sin);
+                while (tok(token))
+                    tokens.add(token);
+            }
+        }
+    };
+
+    class gigaword_file_document_tokenizer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a file tokenizer for parallel_group_tokenizer that reads gigaword
+                XML files and outputs each <DOC> record as a single token.  That is, each
+                token is the text of one document, exactly as gigaword_reader's
+                operator()(std::string&) would give it, except that documents without any
+                text are skipped.  If includes_headline() then the document's headline
+                is appended to its text, separated by a space.
+
+                This lets code that works on whole gigaword documents, rather than on a
+                stream of words, do the XML parsing on a thread pool.
+        !*/
+
+    public:
+
+        explicit gigaword_file_document_tokenizer (
+            bool include_headline_ = false
+        ) : include_headline(include_headline_) {}
+
+        bool includes_headline (
+        ) const { return include_headline; }
+
+        void operator() (
+            const std::string& filename,
+            token_block& tokens
+        ) const
+        {
+            std::ifstream fin(filename.c_str());
+            gigaword_file_reader reader(fin);
+            gigaword_document doc;
+            while (reader(doc))
+            {
+                if (include_headline)
+                    doc.text += " " + doc.headline;
+                if (doc.text.size() != 0)
+                    tokens.add(doc.text);
+            }
+        }
+
+    private:
+        bool include_headline;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename file_tokenizer
+        >
+    class parallel_group_tokenizer : dlib::noncopyable
+    {
+        /*!
+            REQUIREMENTS ON file_tokenizer
+                This must be a copyable function object with the same interface as
+                text_file_tokenizer (and default constructable, if you use the constructor
+                that doesn't take one).  That is, it must tokenize a whole file
+                into a token_block.  It will be called from several threads at once so it
+                must not modify any shared state.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a drop in replacement for group_tokenizer and
+                gigaword_tokenizer (use text_file_tokenizer or gigaword_file_tokenizer
+                respectively as the file_tokenizer) that reads and tokenizes several files
+                at once on a thread pool.
+
+                It reads ahead by up to get_num_threads() files.  That is, while the
+                caller is consuming the tokens from one file, the next
+                get_num_threads() files are being read and tokenized in the background.
+                Since the tokens of a whole file are held in memory, the memory usage of
+                this object is roughly proportional to get_num_threads() times the size
+                of the largest file.
+
+                If is_ordered() then the files are output in the order they were given to
+                the constructor, so the tokens are exactly the same as what group_tokenizer
+                would output.  Otherwise, each file is output as soon as it has been
+                tokenized, which avoids waiting on a slow file but means the order of the
+                files varies from run to run.  The tokens within each file are always in
+                order.
+
+                If the file_tokenizer throws an exception while tokenizing a file, the
+                exception is caught on the worker thread and operator() throws a
+                dlib::error describing it when it gets to that file.
+
+            THREAD SAFETY
+                The worker threads are internal to this object.  As with group_tokenizer,
+                only one thread at a time should use a parallel_group_tokenizer.
+        !*/
+
+    public:
+
+        typedef std::string token_type;
+
+        parallel_group_tokenizer (
+            const std::vector<dlib::file>& file_list,
+            unsigned long num_threads = 4,
+            bool ordered = true
+        ) : in_flight(0), next_to_output(0), next_to_schedule(0), next_token(0),
+            ordered_output(ordered), done_signal(m), pool(num_threads)
+        /*!
+            requires
+                - num_threads > 0
+            ensures
+                - This object will read tokens out of the list of supplied file_list.
+                - #get_num_threads() == num_threads
+                - #is_ordered() == ordered
+        !*/
+        {
+            for (unsigned long i = 0; i < file_list.size(); ++i)
+                files.push_back(file_list[i].full_name());
+            schedule_files();
+        }
+
+        parallel_group_tokenizer (
+            const std::vector<dlib::file>& file_list,
+            const file_tokenizer& tokenizer_,
+            unsigned long num_threads = 4,
+            bool ordered = true
+        ) : tokenizer(tokenizer_), in_flight(0), next_to_output(0), next_to_schedule(0),
+            next_token(0), ordered_output(ordered), done_signal(m), pool(num_threads)
+        /*!
+            requires
+                - num_threads > 0
+            ensures
+                - This object will read tokens out of the list of supplied file_list,
+                  using a copy of tokenizer_ to tokenize each file.
+                - #get_num_threads() == num_threads
+                - #is_ordered() == ordered
+        !*/
+        {
+            for (unsigned long i = 0; i < file_list.size(); ++i)
+                files.push_back(file_list[i].full_name());
+            schedule_files();
+        }
+
+        ~parallel_group_tokenizer (
+        )
+        {
+            pool.wait_for_all_tasks();
+        }
+
+        unsigned long get_num_threads (
+        ) const { return pool.num_threads_in_pool(); }
+
+        bool is_ordered (
+        ) const { return ordered_output; }
+
+        void reset (
+        )
+        /*!
+            ensures
+                - puts the tokenizer back at the start of the token sequence.  Therefore,
+                  calling reset() will allow you to do another pass over the tokens.
+        !*/
+        {
+            pool.wait_for_all_tasks();
+            completed.clear();
+            current.clear();
+            in_flight = 0;
+            next_to_output = 0;
+            next_to_schedule = 0;
+            next_token = 0;
+            schedule_files();
+        }
+
+        bool operator() (
+            std::string& token
+        )
+        /*!
+            ensures
+                - reads the next token from the dataset given to this object's constructor
+                  and stores it in #token.
+                - if (there is not a next token) then
+                    - #token.size() == 0
+                    - returns false
+                - else
+                    - #token.size() != 0
+                    - returns true
+            throws
+                - dlib::error if the file_tokenizer failed on the file the next token
+                  would have come from.
+        !*/
+        {
+            while (next_token >= current.size())
+            {
+                if (!next_file())
+                {
+                    token.clear();
+                    return false;
+                }
+            }
+            current.get(next_token++, token);
+            return true;
+        }
+
+    private:
+
+        void schedule_files (
+        )
+        /*!
+            ensures
+                - starts tokenizing files in the background until get_num_threads() of them
+                  are either in progress or waiting to be output.
+        !*/
+        {
+            while (in_flight < get_num_threads() && next_to_schedule < files.size())
+            {
+                ++in_flight;
+                pool.add_task(*this, &parallel_group_tokenizer::tokenize_file, next_to_schedule++);
+            }
+        }
+
+        void tokenize_file (
+            long idx
+        )
+        {
+            token_block tokens;
+            std::string error;
+            try
+            {
+                tokenizer(files[idx], tokens);
+            }
+            catch (std::exception& e)
+            {
+                error = std::string("Error while tokenizing ") + files[idx] + ": " + e.what();
+            }
+            catch (...)
+            {
+                error = "Error while tokenizing " + files[idx];
+            }
+
+            // Always fill in the slot, even on failure, so next_file() doesn't wait for
+            // it forever.
+            dlib::auto_mutex lock(m);
+            tokenized_file& f = completed[idx];
+            swap(f.tokens, tokens);
+            f.error.swap(error);
+            done_signal.broadcast();
+        }
+
+        bool next_file (
+        )
+        /*!
+            ensures
+                - if (there are more files) then
+                    - waits for the next file to be tokenized and moves its tokens into
+                      current.
+                    - returns true
+                - else
+                    - returns false
+            throws
+                - dlib::error if the file_tokenizer failed on the next file.  That file
+                  is skipped, so calling this function again moves on to the file after
+                  it.
+        !*/
+        {
+            if (next_to_output >= files.size())
+                return false;
+
+            std::string error;
+            {
+                dlib::auto_mutex lock(m);
+                typename std::map<unsigned long, tokenized_file>::iterator i;
+                while (true)
+                {
+                    i = ordered_output ? completed.find(next_to_output) : completed.begin();
+                    if (i != completed.end())
+                        break;
+                    done_signal.wait();
+                }
+                swap(current, i->second.tokens);
+                error.swap(i->second.error);
+                completed.erase(i);
+            }
+
+            ++next_to_output;
+            next_token = 0;
+            --in_flight;
+            schedule_files();
+            if (error.size() != 0)
+            {
+                current.clear();
+                throw dlib::error(error);
+            }
+            return true;
+        }
+
+        std::vector<std::string> files;
+        file_tokenizer tokenizer;
+
+        // The number of files that have been scheduled but not yet moved into current.
+        unsigned long in_flight;
+        // How many files have been moved into current.  In ordered mode this is also the
+        // index of the next file to output.
+        unsigned long next_to_output;
+        unsigned long next_to_schedule;
+
+        token_block current;
+        unsigned long next_token;
+        const bool ordered_output;
+
+        struct tokenized_file
+        {
+            token_block tokens;
+            // The reason the file_tokenizer failed, or "" if it didn't.
+            std::string error;
+        };
+
+        // Files that have been tokenized but not yet output.  Only touched while holding m.
+        std::map<unsigned long, tokenized_file> completed;
+        dlib::mutex m;
+        dlib::signaler done_signal;
+
+        // This is last so that it is destroyed first, while the things the tasks use still
+        // exist.
+        dlib::thread_pool pool;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_PARALLEL_GROUP_ToKENIZER_H_
+
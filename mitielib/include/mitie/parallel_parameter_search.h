@@ -0,0 +1,601 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_PARALLEL_PARAMETER_SeARCH_H_
+#define MIT_LL_MITIE_PARALLEL_PARAMETER_SeARCH_H_
+
+#include <map>
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <dlib/svm.h>
+#include <dlib/threads.h>
+#include <dlib/misc_api.h>
+#include <mitie/training_options.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    inline bool split_search_threads (
+        const unsigned long num_threads,
+        const unsigned long folds,
+        unsigned long& num_concurrent,
+        unsigned long& threads_per_eval
+    )
+    /*!
+        requires
+            - folds > 0
+        ensures
+            - Splits a budget of num_threads threads between a parameter search and the
+              cross-validation it runs for each candidate parameter.  In particular, the
+              search should evaluate #num_concurrent candidates at a time and each of
+              those evaluations should use #threads_per_eval threads for its folds.
+            - The split is the one that finishes the most candidates per unit of time,
+              assuming all the folds take as long to train.  An evaluation with t
+              threads trains its folds in ceil(folds/t) rounds, so when folds doesn't
+              divide num_threads it can pay to run more candidates at once with fewer
+              threads each, e.g. 2 candidates with 2 threads each rather than 1 with 4
+              when num_threads == 4 and folds == 6.
+            - #num_concurrent >= 1
+            - #threads_per_eval >= 1
+            - #num_concurrent*#threads_per_eval <= max(1,num_threads)
+            - returns #num_concurrent > 1.  If this is false then evaluating one
+              candidate at a time already uses the whole budget as well as anything
+              else would, so a parallel search would only be slower than a serial one
+              like BOBYQA and the caller should use the serial search instead.
+    !*/
+    {
+        const unsigned long n = std::max<unsigned long>(1, num_threads);
+        num_concurrent = 1;
+        threads_per_eval = n;
+        unsigned long rounds = (folds + n - 1)/n;
+        for (unsigned long c = 2; c <= n; ++c)
+        {
+            const unsigned long t = n/c;
+            const unsigned long r = (folds + t - 1)/t;
+            // Does c candidates every r rounds beat num_concurrent every rounds?
+            if (c*rounds > num_concurrent*r)
+            {
+                num_concurrent = c;
+                threads_per_eval = t;
+                rounds = r;
+            }
+        }
+        return num_concurrent > 1;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename trainer_type, typename sequence_type>
+        class segmenter_fold_runner
+        {
+        public:
+            segmenter_fold_runner (
+                const std::vector<trainer_type>& trainers_,
+                const std::vector<sequence_type>& samples_,
+                const std::vector<std::vector<std::pair<unsigned long,unsigned long> > >& segments_
+            ) : trainers(trainers_), samples(samples_), segments(segments_), metrics(trainers_.size())
+            {}
+
+            void run_fold (
+                long i
+            )
+            {
+                // These are the same splits cross_validate_sequence_segmenter() uses.
+                const long num_in_test = samples.size()/metrics.size();
+                const long num_in_train = samples.size() - num_in_test;
+
+                std::vector<sequence_type> x_test, x_train;
+                std::vector<std::vector<std::pair<unsigned long,unsigned long> > > y_test, y_train;
+                long next = (i*num_in_test)%samples.size();
+                for (long cnt = 0; cnt < num_in_test; ++cnt)
+                {
+                    x_test.push_back(samples[next]);
+                    y_test.push_back(segments[next]);
+                    next = (next + 1)%samples.size();
+                }
+                for (long cnt = 0; cnt < num_in_train; ++cnt)
+                {
+                    x_train.push_back(samples[next]);
+                    y_train.push_back(segments[next]);
+                    next = (next + 1)%samples.size();
+                }
+
+                metrics[i] = dlib::impl::raw_metrics_test_sequence_segmenter(trainers[i].train(x_train,y_train), x_test, y_test);
+            }
+
+            const std::vector<trainer_type>& trainers;
+            const std::vector<sequence_type>& samples;
+            const std::vector<std::vector<std::pair<unsigned long,unsigned long> > >& segments;
+            std::vector<dlib::matrix<double,1,3> > metrics;
+        };
+    }
+
+    template <typename trainer_type, typename sequence_type>
+    const dlib::matrix<double,1,3> cross_validate_sequence_segmenter_threaded (
+        const std::vector<trainer_type>& fold_trainers,
+        const std::vector<sequence_type>& samples,
+        const std::vector<std::vector<std::pair<unsigned long,unsigned long> > >& segments,
+        const unsigned long num_concurrent
+    )
+    /*!
+        requires
+            - The requirements of dlib::cross_validate_sequence_segmenter() are met for
+              each of the trainers, with folds == fold_trainers.size().
+            - num_concurrent > 0
+        ensures
+            - Returns the same thing as cross_validate_sequence_segmenter(trainer,
+              samples, segments, fold_trainers.size()) except that the i-th fold is
+              trained with fold_trainers[i] and up to num_concurrent folds are trained
+              at the same time.  This lets each fold carry its own state, such as a
+              warm start for its solver, from one call to the next.
+    !*/
+    {
+        const long folds = fold_trainers.size();
+        impl::segmenter_fold_runner<trainer_type,sequence_type> runner(fold_trainers, samples, segments);
+        dlib::parallel_for(std::min<unsigned long>(folds, num_concurrent), 0, folds, runner,
+                           &impl::segmenter_fold_runner<trainer_type,sequence_type>::run_fold, folds);
+
+        dlib::matrix<double,1,3> metrics;
+        metrics = 0;
+        for (long i = 0; i < folds; ++i)
+            metrics += runner.metrics[i];
+
+        const double total_detections    = metrics(0);
+        const double total_true_segments = metrics(1);
+        const double true_hits           = metrics(2);
+
+        const double precision = (total_detections   ==0) ? 1 : true_hits/total_detections;
+        const double recall    = (total_true_segments==0) ? 1 : true_hits/total_true_segments;
+        const double f1        = (precision+recall   ==0) ? 0 : 2*precision*recall/(precision+recall);
+
+        dlib::matrix<double,1,3> res;
+        res = precision, recall, f1;
+        return res;
+    }
+
+    template <typename trainer_type, typename sequence_type>
+    const dlib::matrix<double,1,3> cross_validate_sequence_segmenter_threaded (
+        const trainer_type& trainer,
+        const std::vector<sequence_type>& samples,
+        const std::vector<std::vector<std::pair<unsigned long,unsigned long> > >& segments,
+        const long folds,
+        const unsigned long num_threads
+    )
+    /*!
+        requires
+            - The requirements of dlib::cross_validate_sequence_segmenter() are met.
+            - num_threads > 0
+        ensures
+            - Returns the same thing as cross_validate_sequence_segmenter(trainer,
+              samples, segments, folds) except that the folds are trained at the same
+              time rather than one after another.  Up to num_threads folds run at once
+              and the threads are divided between them, so each fold's copy of trainer
+              gets set_num_threads(max(1,num_threads/folds)).
+    !*/
+    {
+        std::vector<trainer_type> fold_trainers(folds, trainer);
+        for (long i = 0; i < folds; ++i)
+            fold_trainers[i].set_num_threads(std::max<unsigned long>(1, num_threads/folds));
+        return cross_validate_sequence_segmenter_threaded(fold_trainers, samples, segments, num_threads);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename trainer_type, typename sample_type, typename label_type>
+        class multiclass_fold_runner
+        {
+        public:
+            multiclass_fold_runner (
+                const std::vector<trainer_type>& trainers_,
+                const std::vector<sample_type>& x_,
+                const std::vector<label_type>& y_,
+                const std::vector<std::vector<unsigned long> >& test_idx_,
+                const std::vector<std::vector<unsigned long> >& train_idx_
+            ) : trainers(trainers_), x(x_), y(y_), test_idx(test_idx_), train_idx(train_idx_), res(test_idx_.size())
+            {}
+
+            void run_fold (
+                long i
+            )
+            {
+                std::vector<sample_type> x_test, x_train;
+                std::vector<label_type> y_test, y_train;
+                for (unsigned long j = 0; j < test_idx[i].size(); ++j)
+                {
+                    x_test.push_back(x[test_idx[i][j]]);
+                    y_test.push_back(y[test_idx[i][j]]);
+                }
+                for (unsigned long j = 0; j < train_idx[i].size(); ++j)
+                {
+                    x_train.push_back(x[train_idx[i][j]]);
+                    y_train.push_back(y[train_idx[i][j]]);
+                }
+                res[i] = dlib::test_multiclass_decision_function(trainers[i].train(x_train,y_train),x_test,y_test);
+            }
+
+            const std::vector<trainer_type>& trainers;
+            const std::vector<sample_type>& x;
+            const std::vector<label_type>& y;
+            const std::vector<std::vector<unsigned long> >& test_idx;
+            const std::vector<std::vector<unsigned long> >& train_idx;
+            std::vector<dlib::matrix<double> > res;
+        };
+    }
+
+    template <typename trainer_type, typename sample_type, typename label_type>
+    const dlib::matrix<double> cross_validate_multiclass_trainer_threaded (
+        const std::vector<trainer_type>& fold_trainers,
+        const std::vector<sample_type>& x,
+        const std::vector<label_type>& y,
+        const unsigned long num_concurrent
+    )
+    /*!
+        requires
+            - The requirements of dlib::cross_validate_multiclass_trainer() are met for
+              each of the trainers, with folds == fold_trainers.size().
+            - num_concurrent > 0
+        ensures
+            - Returns the same thing as cross_validate_multiclass_trainer(trainer, x, y,
+              fold_trainers.size()) except that the i-th fold is trained with
+              fold_trainers[i] and up to num_concurrent folds are trained at the same
+              time.  This lets each fold carry its own state, such as a warm start for
+              its solver, from one call to the next.
+        throws
+            - dlib::cross_validation_error if a class has fewer than
+              fold_trainers.size() samples.
+    !*/
+    {
+        using namespace dlib;
+        const long folds = fold_trainers.size();
+        const std::vector<label_type> all_labels = select_all_distinct_labels(y);
+
+        std::map<label_type,long> label_counts;
+        for (unsigned long i = 0; i < y.size(); ++i)
+            label_counts[y[i]] += 1;
+
+        std::map<label_type,long> num_in_test, num_in_train;
+        for (typename std::map<label_type,long>::iterator i = label_counts.begin(); i != label_counts.end(); ++i)
+        {
+            const long in_test = i->second/folds;
+            if (in_test == 0)
+            {
+                std::ostringstream sout;
+                sout << "In cross_validate_multiclass_trainer_threaded(), the number of folds was larger" << std::endl;
+                sout << "than the number of elements of one of the training classes." << std::endl;
+                sout << "  folds: "<< folds << std::endl;
+                sout << "  size of class " << i->first << ": "<< i->second << std::endl;
+                throw cross_validation_error(sout.str());
+            }
+            num_in_test[i->first] = in_test;
+            num_in_train[i->first] = i->second - in_test;
+        }
+
+        // Pick out the same splits cross_validate_multiclass_trainer() uses.  This is
+        // cheap, so we do it up front and then only the training runs in parallel.
+        std::vector<std::vector<unsigned long> > test_idx(folds), train_idx(folds);
+        std::map<label_type,long> next_test_idx;
+        for (unsigned long i = 0; i < all_labels.size(); ++i)
+            next_test_idx[all_labels[i]] = 0;
+        for (long i = 0; i < folds; ++i)
+        {
+            for (unsigned long j = 0; j < all_labels.size(); ++j)
+            {
+                const label_type& label = all_labels[j];
+                long next = next_test_idx[label];
+                for (long cur = 0; cur < num_in_test[label]; next = (next + 1)%x.size())
+                {
+                    if (y[next] == label)
+                    {
+                        test_idx[i].push_back(next);
+                        ++cur;
+                    }
+                }
+                next_test_idx[label] = next;
+            }
+            for (unsigned long j = 0; j < all_labels.size(); ++j)
+            {
+                const label_type& label = all_labels[j];
+                long next = next_test_idx[label];
+                for (long cur = 0; cur < num_in_train[label]; next = (next + 1)%x.size())
+                {
+                    if (y[next] == label)
+                    {
+                        train_idx[i].push_back(next);
+                        ++cur;
+                    }
+                }
+            }
+        }
+
+        impl::multiclass_fold_runner<trainer_type,sample_type,label_type> runner(fold_trainers, x, y, test_idx, train_idx);
+        parallel_for(std::min<unsigned long>(folds, num_concurrent), 0, folds, runner,
+                     &impl::multiclass_fold_runner<trainer_type,sample_type,label_type>::run_fold, folds);
+
+        matrix<double> res;
+        for (long i = 0; i < folds; ++i)
+            res += runner.res[i];
+        return res;
+    }
+
+    template <typename trainer_type, typename sample_type, typename label_type>
+    const dlib::matrix<double> cross_validate_multiclass_trainer_threaded (
+        const trainer_type& trainer,
+        const std::vector<sample_type>& x,
+        const std::vector<label_type>& y,
+        const long folds,
+        const unsigned long num_threads
+    )
+    /*!
+        requires
+            - The requirements of dlib::cross_validate_multiclass_trainer() are met.
+            - num_threads > 0
+        ensures
+            - Returns the same thing as cross_validate_multiclass_trainer(trainer, x, y,
+              folds) except that the folds are trained at the same time rather than one
+              after another.  Up to num_threads folds run at once and the threads are
+              divided between them, so each fold's copy of trainer gets
+              set_num_threads(max(1,num_threads/folds)).
+        throws
+            - dlib::cross_validation_error if a class has fewer than folds samples.
+    !*/
+    {
+        std::vector<trainer_type> fold_trainers(folds, trainer);
+        for (long i = 0; i < folds; ++i)
+            fold_trainers[i].set_num_threads(std::max<unsigned long>(1, num_threads/folds));
+        return cross_validate_multiclass_trainer_threaded(fold_trainers, x, y, num_threads);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename funct>
+    class log_space_objective
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a wrapper that calls f(exp(x)).  It lets find_max_parallel_grid()
+                search over the log of parameters like C that are only meaningful over
+                several orders of magnitude.
+        !*/
+    public:
+        log_space_objective(const funct& f_) : f(f_) {}
+
+        double operator() (const double& x) const { return f(std::exp(x)); }
+
+        template <long NR>
+        double operator() (const dlib::matrix<double,NR,1>& x) const
+        {
+            const dlib::matrix<double,NR,1> temp = dlib::exp(x);
+            return f(temp);
+        }
+
+    private:
+        const funct& f;
+    };
+
+    template <typename funct>
+    log_space_objective<funct> make_log_space_objective (const funct& f) { return log_space_objective<funct>(f); }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename funct, long NR>
+        class grid_evaluator
+        {
+        public:
+            grid_evaluator (
+                const funct& f_,
+                const std::vector<dlib::matrix<double,NR,1> >& points_
+            ) : f(f_), points(points_), scores(points_.size()), seconds(points_.size()) {}
+
+            void eval (
+                long i
+            )
+            {
+                dlib::timestamper ts;
+                const dlib::uint64 start = ts.get_timestamp();
+                scores[i] = f(points[i]);
+                seconds[i] = (ts.get_timestamp() - start)/1e6;
+            }
+
+            const funct& f;
+            const std::vector<dlib::matrix<double,NR,1> >& points;
+            std::vector<double> scores;
+            // The wall clock time each evaluation took.
+            std::vector<double> seconds;
+        };
+
+        template <typename funct>
+        class scalar_objective
+        {
+        public:
+            scalar_objective(const funct& f_) : f(f_) {}
+            double operator() (const dlib::matrix<double,1,1>& x) const { return f(x(0)); }
+        private:
+            const funct& f;
+        };
+    }
+
+    template <typename funct, long NR>
+    double find_max_parallel_grid (
+        const funct& f,
+        dlib::matrix<double,NR,1>& x,
+        const dlib::matrix<double,NR,1>& lower,
+        const dlib::matrix<double,NR,1>& upper,
+        const dlib::matrix<double,NR,1>& min_step,
+        const unsigned long num_concurrent,
+        const unsigned long max_evals,
+        const training_monitor* monitor = 0
+    )
+    /*!
+        requires
+            - f(x) must be a valid expression that evaluates to a double and it must be
+              safe to call f from num_concurrent threads at the same time.
+            - x.size() == lower.size() == upper.size() == min_step.size() > 0
+            - lower < upper (element wise)
+            - min(min_step) > 0
+            - num_concurrent > 0
+            - max_evals > 0
+        ensures
+            - This is an alternative to dlib::find_max_bobyqa() for when each evaluation
+              of f is expensive and there are spare cores.  BOBYQA picks each new point
+              based on all the previous ones, so it can only evaluate f one point at a
+              time.  This function instead evaluates a whole batch of points at once,
+              num_concurrent at a time:
+                - The first batch is a grid over the box [lower,upper] along with the
+                  starting point x.
+                - Each later batch is a smaller grid centered on the best point found so
+                  far whose spacing is half the spacing of the previous grid.
+                - The search stops once the grid spacing is below min_step in every
+                  dimension, max_evals evaluations have been made, or, if monitor != 0,
+                  monitor->search_is_over().  No point is evaluated twice.
+              The number of points per dimension in each grid is picked so a batch
+              gives all num_concurrent threads something to do.
+            - #x == the point with the largest value of f() that was evaluated.
+            - returns f(#x)
+            - Prints the number of evaluations and how long the search took to cout,
+              along with how long the evaluations would have taken one after another
+              (the sum of their individual wall clock times).
+    !*/
+    {
+        using namespace dlib;
+        DLIB_CASSERT(x.size() > 0 && x.size() == lower.size() && x.size() == upper.size() &&
+                     x.size() == min_step.size() && min(min_step) > 0 && min(upper-lower) > 0 &&
+                     num_concurrent > 0 && max_evals > 0,
+                     "Invalid inputs were given to this function");
+
+        const long dims = x.size();
+        // Use enough points per dimension that one grid keeps all the threads busy.
+        // It's always odd so the best point found so far is in the middle of the grid.
+        unsigned long points_per_dim = 3;
+        while (std::pow((double)points_per_dim, (double)dims) < num_concurrent+1)
+            points_per_dim += 2;
+
+        std::map<std::vector<double>,double> evaluated;
+        double best_score = -std::numeric_limits<double>::infinity();
+        matrix<double,NR,1> center = (lower+upper)/2;
+        matrix<double,NR,1> step = (upper-lower)/(points_per_dim-1);
+        x = dlib::clamp(x, lower, upper);
+        bool first = true;
+
+        timestamper ts;
+        const uint64 start = ts.get_timestamp();
+        double serial_seconds = 0;
+
+        while (evaluated.size() < max_evals)
+        {
+            // make the grid of points for this round
+            std::vector<matrix<double,NR,1> > points;
+            if (first)
+                points.push_back(x);
+            matrix<long,0,1> counter(dims);
+            counter = 0;
+            while (counter(dims-1) < (long)points_per_dim)
+            {
+                matrix<double,NR,1> p = center;
+                for (long d = 0; d < dims; ++d)
+                    p(d) += (counter(d) - (long)points_per_dim/2)*step(d);
+                points.push_back(dlib::clamp(p, lower, upper));
+
+                for (long d = 0; d < dims; ++d)
+                {
+                    if (++counter(d) < (long)points_per_dim || d == dims-1)
+                        break;
+                    counter(d) = 0;
+                }
+            }
+
+            // drop points we have already looked at
+            std::vector<matrix<double,NR,1> > new_points;
+            for (unsigned long i = 0; i < points.size() && evaluated.size()+new_points.size() < max_evals; ++i)
+            {
+                const std::vector<double> key(points[i].begin(), points[i].end());
+                if (evaluated.count(key) == 0)
+                {
+                    evaluated[key] = 0;
+                    new_points.push_back(points[i]);
+                }
+            }
+
+            impl::grid_evaluator<funct,NR> evaluator(f, new_points);
+            parallel_for(num_concurrent, 0, new_points.size(), evaluator, &impl::grid_evaluator<funct,NR>::eval,
+                         std::max<long>(1, new_points.size()));
+            for (unsigned long i = 0; i < new_points.size(); ++i)
+            {
+                evaluated[std::vector<double>(new_points[i].begin(), new_points[i].end())] = evaluator.scores[i];
+                serial_seconds += evaluator.seconds[i];
+                if (evaluator.scores[i] > best_score)
+                {
+                    best_score = evaluator.scores[i];
+                    x = new_points[i];
+                }
+            }
+
+            if (monitor && monitor->search_is_over())
+                break;
+
+            first = false;
+            center = x;
+            step = step/2;
+            bool done = true;
+            for (long d = 0; d < dims; ++d)
+            {
+                if (step(d) >= min_step(d))
+                    done = false;
+            }
+            if (done)
+                break;
+        }
+
+        // Running the evaluations one after another would have taken the sum of their
+        // wall clock times, so the ratio of that to how long the search took is the
+        // speedup from running them concurrently.
+        const double wall_seconds = (ts.get_timestamp() - start)/1e6;
+        std::cout << "parameter search: " << evaluated.size() << " evaluations, "
+                  << num_concurrent << " at a time, took " << wall_seconds << " seconds ("
+                  << serial_seconds << " seconds if run one at a time, speedup: "
+                  << serial_seconds/std::max(wall_seconds,1e-6) << "x)" << std::endl;
+        return best_score;
+    }
+
+    template <typename funct>
+    double find_max_parallel_grid (
+        const funct& f,
+        double& x,
+        const double lower,
+        const double upper,
+        const double min_step,
+        const unsigned long num_concurrent,
+        const unsigned long max_evals,
+        const training_monitor* monitor = 0
+    )
+    /*!
+        ensures
+            - This is just a version of find_max_parallel_grid() for objective functions
+              that take a single double rather than a column vector.
+    !*/
+    {
+        dlib::matrix<double,1,1> xx, ll, uu, ss;
+        xx = x; ll = lower; uu = upper; ss = min_step;
+        impl::scalar_objective<funct> obj(f);
+        const double score = find_max_parallel_grid(obj, xx, ll, uu, ss, num_concurrent, max_evals, monitor);
+        x = xx(0);
+        return score;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_PARALLEL_PARAMETER_SeARCH_H_
+
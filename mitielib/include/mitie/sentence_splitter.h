@@ -0,0 +1,336 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_SENTENCE_SpLITTER_H_
+#define MIT_LL_MITIE_SENTENCE_SpLITTER_H_
+
+#include <mitie/conll_span_tokenizer.h>
+#include <vector>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class sentence_splitter
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a tool for breaking a text buffer into sentences.  It reads tokens
+                from a conll_span_tokenizer and groups them into sentences using a few
+                simple rules:
+                    - A blank line always ends a sentence.
+                    - A ! or ? token ends a sentence unless the next token starts with a
+                      lower case letter or is a , ; or : character.
+                    - A . token does the same, except when it follows a title like "Prof"
+                      or "Gen" (e.g. "Gen. Patton"), in which case it never ends a
+                      sentence.  Note that the tokenizer already drops the . from two
+                      letter titles like "Mr." or "Dr.".
+                    - An ellipsis (i.e. a run of . tokens) and a number with a trailing .
+                      (e.g. "in 1990." or "costs $3.50.") end a sentence only if the next
+                      token starts with an upper case letter or an opening quote or
+                      bracket.
+                    - Tokens like "U.S." or "J." that contain their own periods are never
+                      treated as the end of a sentence.  Missing a sentence break is much
+                      less harmful than splitting a named entity in two.
+                    - Closing brackets and quotes that follow the end of a sentence are
+                      included in that sentence.
+                    - No sentence is allowed to be longer than get_max_sentence_length()
+                      tokens.  Longer sentences are simply cut at that length.
+
+                The text is processed in a single pass, looking at most one token past
+                the end of each sentence.
+
+            CONVENTION
+                - if (has_lookahead) then
+                    - lookahead is the next token that should be returned by next_token().
+        !*/
+
+    public:
+
+        sentence_splitter (
+            const char* text_,
+            unsigned long length_,
+            unsigned long max_sentence_length_ = 300
+        ) : text(text_), tok(text_, length_), max_sentence_length(max_sentence_length_), has_lookahead(false) {}
+        /*!
+            requires
+                - text_ points to an array of at least length_ bytes.
+                - max_sentence_length_ > 0
+            ensures
+                - This object will split the tokens in text_[0] through text_[length_-1]
+                  into sentences.  Note that it holds a pointer to the buffer so the buffer
+                  should continue to exist for the lifetime of this sentence_splitter.
+                - #get_max_sentence_length() == max_sentence_length_
+        !*/
+
+        unsigned long get_max_sentence_length (
+        ) const { return max_sentence_length; }
+
+        bool operator() (
+            std::vector<token_span>& sentence
+        )
+        /*!
+            ensures
+                - reads the next sentence from the buffer and stores its tokens into
+                  #sentence.  The tokens are exactly the ones a conll_span_tokenizer would
+                  output, so concatenating all the sentences gives the same sequence of
+                  tokens as running the conll_span_tokenizer over the whole buffer.
+                - if (there are no more tokens) then
+                    - #sentence.size() == 0
+                    - returns false
+                - else
+                    - 0 < #sentence.size() <= get_max_sentence_length()
+                    - returns true
+        !*/
+        {
+            sentence.clear();
+            token_span t;
+            while (sentence.size() < max_sentence_length && next_token(t))
+            {
+                if (sentence.size() != 0 && is_paragraph_break(sentence.back(), t))
+                {
+                    put_back(t);
+                    return true;
+                }
+
+                sentence.push_back(t);
+
+                const terminator_type type = get_terminator_type(t);
+                if (type == NOT_TERMINATOR)
+                    continue;
+
+                // Remember what came just before the terminator so we can check for
+                // things like "Gen."
+                const bool has_prev = sentence.size() >= 2;
+                const token_span prev = has_prev ? sentence[sentence.size()-2] : token_span();
+                unsigned long num_periods = is_single(t,'.') ? 1 : 0;
+
+                // Pull in any other sentence ending punctuation and closing quotes.
+                while (sentence.size() < max_sentence_length && next_token(t))
+                {
+                    if (is_paragraph_break(sentence.back(), t))
+                    {
+                        put_back(t);
+                        return true;
+                    }
+                    if (is_single(t,'.') || is_single(t,'!') || is_single(t,'?'))
+                    {
+                        if (is_single(t,'.'))
+                            ++num_periods;
+                        sentence.push_back(t);
+                    }
+                    else if (is_closer(sentence.back(), t))
+                    {
+                        sentence.push_back(t);
+                    }
+                    else
+                    {
+                        put_back(t);
+                        break;
+                    }
+                }
+
+                // If we hit the end of the text then we are done no matter what.
+                if (!has_lookahead || ends_sentence(type, num_periods, has_prev, prev, lookahead))
+                    return true;
+            }
+            return sentence.size() != 0;
+        }
+
+    private:
+
+        enum terminator_type
+        {
+            NOT_TERMINATOR,
+            PERIOD,
+            EXCLAMATION,
+            NUMBER_PERIOD
+        };
+
+        bool next_token (
+            token_span& t
+        )
+        {
+            if (has_lookahead)
+            {
+                t = lookahead;
+                has_lookahead = false;
+                return true;
+            }
+            return tok(t);
+        }
+
+        void put_back (
+            const token_span& t
+        )
+        {
+            lookahead = t;
+            has_lookahead = true;
+        }
+
+        unsigned char first_byte (
+            const token_span& t
+        ) const { return t.utf8_apostrophe ? '\'' : (unsigned char)text[t.begin]; }
+
+        bool is_single (
+            const token_span& t,
+            char ch
+        ) const { return t.end - t.begin == 1 && text[t.begin] == ch; }
+
+        bool is_utf8_quote (
+            const token_span& t,
+            unsigned char last
+        ) const
+        /*!
+            ensures
+                - returns true if t is the 3 byte UTF-8 character E2 80 last.
+        !*/
+        {
+            return !t.utf8_apostrophe && t.end - t.begin == 3 &&
+                (unsigned char)text[t.begin]   == 0xE2 &&
+                (unsigned char)text[t.begin+1] == 0x80 &&
+                (unsigned char)text[t.begin+2] == last;
+        }
+
+        terminator_type get_terminator_type (
+            const token_span& t
+        ) const
+        {
+            if (is_single(t,'.'))
+                return PERIOD;
+            if (is_single(t,'!') || is_single(t,'?'))
+                return EXCLAMATION;
+
+            // The tokenizer keeps the period on the end of a number, so look for tokens
+            // where a digit comes right before the final period.  Only the end of the
+            // token matters since numbers often start with things like $ or #.
+            if (t.utf8_apostrophe || t.end - t.begin < 2 || text[t.end-1] != '.')
+                return NOT_TERMINATOR;
+            if (!('0' <= text[t.end-2] && text[t.end-2] <= '9'))
+                return NOT_TERMINATOR;
+            return NUMBER_PERIOD;
+        }
+
+        bool is_closer (
+            const token_span& prev,
+            const token_span& t
+        ) const
+        /*!
+            ensures
+                - returns true if t looks like a closing bracket or quote for the sentence
+                  that ends with prev.
+        !*/
+        {
+            if (is_single(t,')') || is_single(t,']') || is_utf8_quote(t, 0x9D) || is_utf8_quote(t, 0x99))
+                return true;
+            // Straight quotes could be opening the next sentence, so only count them if
+            // they are touching the end of the sentence.
+            if ((is_single(t,'"') || is_single(t,'\'')) && prev.end == t.begin)
+                return true;
+            return false;
+        }
+
+        bool is_paragraph_break (
+            const token_span& prev,
+            const token_span& t
+        ) const
+        /*!
+            ensures
+                - returns true if there is a blank line between prev and t.
+        !*/
+        {
+            unsigned long num_newlines = 0;
+            for (unsigned long i = prev.end; i < t.begin; ++i)
+            {
+                if (text[i] == '\n' && ++num_newlines == 2)
+                    return true;
+            }
+            return false;
+        }
+
+        bool starts_upper (
+            const token_span& t
+        ) const
+        {
+            const unsigned char ch = first_byte(t);
+            // The last case is a UTF-8 left double quote.
+            return ('A' <= ch && ch <= 'Z') || ch == '"' || ch == '(' || ch == '[' ||
+                (t.end - t.begin >= 3 && ch == 0xE2 &&
+                 (unsigned char)text[t.begin+1] == 0x80 &&
+                 (unsigned char)text[t.begin+2] == 0x9C);
+        }
+
+        bool starts_lower (
+            const token_span& t
+        ) const
+        {
+            const unsigned char ch = first_byte(t);
+            return ('a' <= ch && ch <= 'z') || ch == ',' || ch == ';' || ch == ':';
+        }
+
+        bool is_title (
+            const token_span& t
+        ) const
+        /*!
+            ensures
+                - returns true if t is one of the abbreviations in the list below.  The
+                  comparison is case insensitive.
+        !*/
+        {
+            static const char* const titles[] = {
+                "adm", "capt", "cmdr", "col", "cpl", "gen", "gov", "hon", "lt", "maj",
+                "messrs", "mme", "mrs", "msgr", "pres", "prof", "rep", "rev", "sen", "sgt",
+                "supt", "nos", "fig", "figs", "vol", "pp", "approx", "dept", "ft", "mt",
+                "st", "sr", "jr", "dr", "mr", "ms", "cf", 0
+            };
+
+            const unsigned long size = t.end - t.begin;
+            if (t.utf8_apostrophe || size > 6)
+                return false;
+            for (unsigned long i = 0; titles[i]; ++i)
+            {
+                const char* title = titles[i];
+                unsigned long j = 0;
+                for (; j < size && title[j]; ++j)
+                {
+                    char ch = text[t.begin+j];
+                    if ('A' <= ch && ch <= 'Z')
+                        ch = ch - 'A' + 'a';
+                    if (ch != title[j])
+                        break;
+                }
+                if (j == size && title[j] == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        bool ends_sentence (
+            terminator_type type,
+            unsigned long num_periods,
+            bool has_prev,
+            const token_span& prev,
+            const token_span& next
+        ) const
+        {
+            if (type == NUMBER_PERIOD || num_periods >= 2)
+                return starts_upper(next);
+            if (type == PERIOD && has_prev && is_title(prev))
+                return false;
+            return !starts_lower(next);
+        }
+
+        const char* text;
+        conll_span_tokenizer tok;
+        unsigned long max_sentence_length;
+        token_span lookahead;
+        bool has_lookahead;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_SENTENCE_SpLITTER_H_
+
@@ -0,0 +1,308 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_SPACE_SaVING_H_
+#define MIT_LL_SPACE_SaVING_H_
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <dlib/uintn.h>
+#include <dlib/assert.h>
+#include <dlib/serialize.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename T
+        >
+    class space_saving
+    {
+        /*!
+            REQUIREMENTS ON T
+                T must be copyable and comparable with operator< (i.e. usable as the key
+                of a std::map).
+
+            WHAT THIS OBJECT REPRESENTS
+                This is an implementation of the SpaceSaving heavy hitters algorithm
+                described in the paper:
+                    Efficient Computation of Frequent and Top-k Elements in Data Streams
+                    by Ahmed Metwally, Divyakant Agrawal, and Amr El Abbadi
+
+                It watches a stream of items and keeps at most get_capacity() of them,
+                along with an overestimate of how many times each was seen.  Any item
+                which makes up more than 1/get_capacity() of the stream is guaranteed to
+                be among the items kept.  So in a single pass over the data it finds a
+                small set of candidates that contains all the frequent items.
+
+            CONVENTION
+                - heap is a binary min-heap of the monitored items ordered by count.
+                - for all i: heap[i].pos is the element of index for the i-th heap entry
+                  and heap[i].pos->second == i
+        !*/
+
+    public:
+
+        explicit space_saving (
+            unsigned long capacity = 1000
+        ) : max_size(capacity), total_count(0)
+        /*!
+            requires
+                - capacity > 0
+            ensures
+                - #get_capacity() == capacity
+                - #size() == 0
+                - #get_total_count() == 0
+        !*/
+        {
+            DLIB_CASSERT(capacity > 0, "Invalid inputs were given to this function");
+        }
+
+        space_saving (
+            const space_saving& item
+        ) : max_size(item.max_size), total_count(item.total_count), heap(item.heap), index(item.index)
+        {
+            // the copied heap still refers to item.index so point it at our own index
+            for (unsigned long i = 0; i < heap.size(); ++i)
+                heap[i].pos = index.find(item.heap[i].pos->first);
+        }
+
+        space_saving& operator= (
+            const space_saving& item
+        )
+        {
+            space_saving(item).swap(*this);
+            return *this;
+        }
+
+        unsigned long get_capacity (
+        ) const { return max_size; }
+
+        unsigned long size (
+        ) const { return heap.size(); }
+        /*!
+            ensures
+                - returns the number of items currently being monitored.
+                - size() <= get_capacity()
+        !*/
+
+        dlib::uint64 get_total_count (
+        ) const { return total_count; }
+        /*!
+            ensures
+                - returns the total of all values added into this object via increment().
+        !*/
+
+        void clear (
+        )
+        /*!
+            ensures
+                - #size() == 0
+                - #get_total_count() == 0
+        !*/
+        {
+            heap.clear();
+            index.clear();
+            total_count = 0;
+        }
+
+        void increment (
+            const T& item,
+            dlib::uint64 amount = 1
+        )
+        /*!
+            ensures
+                - Records amount more occurrences of item.  If item isn't monitored and
+                  size() == get_capacity() then the item with the smallest count is evicted
+                  and item inherits its count (this is what makes the counts overestimates).
+                - #get_total_count() == get_total_count() + amount
+        !*/
+        {
+            total_count += amount;
+            map_iterator i = index.find(item);
+            if (i != index.end())
+            {
+                heap[i->second].count += amount;
+                sift_down(i->second);
+            }
+            else if (heap.size() < max_size)
+            {
+                heap.push_back(counter(index.insert(std::make_pair(item, heap.size())).first, amount));
+                sift_up(heap.size()-1);
+            }
+            else
+            {
+                // replace the item with the smallest count
+                index.erase(heap[0].pos);
+                heap[0].pos = index.insert(std::make_pair(item, 0)).first;
+                heap[0].count += amount;
+                sift_down(0);
+            }
+        }
+
+        void update (
+            const T& item,
+            dlib::uint64 count
+        )
+        /*!
+            requires
+                - count is at least as large as any count previously given for item.
+            ensures
+                - This is an alternative to increment() for when the counts come from
+                  somewhere else, such as a count_min_sketch, rather than being estimated
+                  by this object.  It records that item has now been seen count times.
+                  If item isn't monitored then it displaces the item with the smallest
+                  count, but only if count is larger than that item's count.  So if the
+                  supplied counts are accurate this object always holds the get_capacity()
+                  items with the largest counts.
+                - does not change get_total_count().
+        !*/
+        {
+            map_iterator i = index.find(item);
+            if (i != index.end())
+            {
+                heap[i->second].count = count;
+                sift_down(i->second);
+            }
+            else if (heap.size() < max_size)
+            {
+                heap.push_back(counter(index.insert(std::make_pair(item, heap.size())).first, count));
+                sift_up(heap.size()-1);
+            }
+            else if (count > heap[0].count)
+            {
+                index.erase(heap[0].pos);
+                heap[0].pos = index.insert(std::make_pair(item, 0)).first;
+                heap[0].count = count;
+                sift_down(0);
+            }
+        }
+
+        void get_items (
+            std::vector<std::pair<T, dlib::uint64> >& items
+        ) const
+        /*!
+            ensures
+                - #items == all the monitored items along with their estimated counts.
+                  Each estimate is at least as large as the true count and overestimates
+                  it by at most the count of the smallest monitored item.
+                - #items.size() == size()
+        !*/
+        {
+            items.clear();
+            for (unsigned long i = 0; i < heap.size(); ++i)
+                items.push_back(std::make_pair(heap[i].pos->first, heap[i].count));
+        }
+
+        void swap (
+            space_saving& item
+        )
+        {
+            std::swap(max_size, item.max_size);
+            std::swap(total_count, item.total_count);
+            heap.swap(item.heap);
+            index.swap(item.index);
+        }
+
+        friend void serialize (const space_saving& item, std::ostream& out)
+        {
+            int version = 1;
+            dlib::serialize(version, out);
+            dlib::serialize(item.max_size, out);
+            dlib::serialize(item.total_count, out);
+            // save the items in heap order so deserialize() gets back the same heap.
+            std::vector<std::pair<T, dlib::uint64> > items;
+            item.get_items(items);
+            dlib::serialize(items, out);
+        }
+
+        friend void deserialize (space_saving& item, std::istream& in)
+        {
+            int version = 0;
+            dlib::deserialize(version, in);
+            if (version != 1)
+                throw dlib::serialization_error("Wrong version found while deserializing a mitie::space_saving object.");
+            std::vector<std::pair<T, dlib::uint64> > items;
+            item.clear();
+            dlib::deserialize(item.max_size, in);
+            dlib::deserialize(item.total_count, in);
+            dlib::deserialize(items, in);
+            for (unsigned long i = 0; i < items.size(); ++i)
+                item.heap.push_back(counter(item.index.insert(std::make_pair(items[i].first, i)).first, items[i].second));
+        }
+
+    private:
+
+        typedef typename std::map<T,unsigned long>::iterator map_iterator;
+
+        struct counter
+        {
+            counter(map_iterator pos_, dlib::uint64 count_) : pos(pos_), count(count_) {}
+
+            map_iterator pos;
+            dlib::uint64 count;
+        };
+
+        void swap_entries (
+            unsigned long a,
+            unsigned long b
+        )
+        {
+            std::swap(heap[a], heap[b]);
+            heap[a].pos->second = a;
+            heap[b].pos->second = b;
+        }
+
+        void sift_up (
+            unsigned long i
+        )
+        {
+            while (i != 0 && heap[i].count < heap[(i-1)/2].count)
+            {
+                swap_entries(i, (i-1)/2);
+                i = (i-1)/2;
+            }
+        }
+
+        void sift_down (
+            unsigned long i
+        )
+        {
+            while (true)
+            {
+                const unsigned long left = 2*i+1;
+                const unsigned long right = 2*i+2;
+                unsigned long smallest = i;
+                if (left < heap.size() && heap[left].count < heap[smallest].count)
+                    smallest = left;
+                if (right < heap.size() && heap[right].count < heap[smallest].count)
+                    smallest = right;
+                if (smallest == i)
+                    return;
+                swap_entries(i, smallest);
+                i = smallest;
+            }
+        }
+
+        unsigned long max_size;
+        dlib::uint64 total_count;
+        std::vector<counter> heap;
+        std::map<T,unsigned long> index;
+    };
+
+    template <typename T>
+    inline void swap (
+        space_saving<T>& a,
+        space_saving<T>& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_SPACE_SaVING_H_
+
@@ -0,0 +1,181 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_STREAMING_TEXT_CATEGORIZER_TRaINER_H_
+#define MIT_LL_MITIE_STREAMING_TEXT_CATEGORIZER_TRaINER_H_
+
+#include <vector>
+#include <string>
+#include <mitie/total_word_feature_extractor.h>
+#include <mitie/text_categorizer.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class streaming_text_categorizer_trainer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a tool for training mitie::text_categorizer objects from more
+                labeled documents than fit in RAM.  Unlike text_categorizer_trainer,
+                which holds every document it is given in memory, this object only
+                holds the names of files that contain the training documents, and
+                train() streams through them.
+
+                train() reads the files once, computes the features of each document
+                exactly as text_categorizer::predict() does, and writes them to a
+                text_feature_store in a scratch file.  It then trains the classifier
+                with an averaged perceptron that makes get_num_epochs() passes over the
+                store.  Each pass visits the store's blocks in a random order, a chunk
+                of blocks at a time, shuffles the documents in the chunk, and splits
+                them among get_num_threads() threads using iterative parameter mixing.
+                So the RAM train() uses is bounded by a few copies of the classifier's
+                weights per thread plus one chunk of documents, no matter how many
+                documents there are.
+
+                The price for this is that train() doesn't search for the best
+                regularization parameter like text_categorizer_trainer does, so on data
+                sets small enough to fit in RAM text_categorizer_trainer will usually
+                produce a somewhat more accurate classifier.
+
+            TRAINING FILE FORMAT
+                A training file holds one document per line.  Each line is the
+                document's label, a tab character, and then the text of the document.
+                The text is split into tokens the same way mitie_tokenize() does.  Lines
+                without a tab or without any tokens after it are skipped.
+        !*/
+
+    public:
+
+        streaming_text_categorizer_trainer (
+        );
+        /*!
+            ensures
+                - #get_num_files() == 0
+                - #get_num_threads() == 4
+                - #get_num_epochs() == 10
+                - #get_feature_store_file() == ""
+                - The trained text_categorizer uses only bag-of-words features, as with
+                  the default constructed text_categorizer_trainer.
+        !*/
+
+        explicit streaming_text_categorizer_trainer (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - #get_num_files() == 0
+                - #get_num_threads() == 4
+                - #get_num_epochs() == 10
+                - #get_feature_store_file() == ""
+                - This function attempts to load a mitie::total_word_feature_extractor
+                  from the file with the given filename.  The trained text_categorizer
+                  uses it along with bag-of-words features.
+        !*/
+
+        void add_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - Adds the documents in the given file, which must be in the TRAINING
+                  FILE FORMAT described above, to the training data.  The file isn't
+                  read until train() is called.
+                - #get_num_files() == get_num_files() + 1
+        !*/
+
+        unsigned long get_num_files (
+        ) const { return filenames.size(); }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+        /*!
+            ensures
+                - returns the number of threads that will be used to perform training.
+                  You should set this equal to the number of processing cores you have
+                  on your computer.
+        !*/
+
+        void set_num_threads (
+            unsigned long num
+        );
+        /*!
+            requires
+                - num > 0
+            ensures
+                - #get_num_threads() == num
+        !*/
+
+        unsigned long get_num_epochs (
+        ) const { return num_epochs; }
+        /*!
+            ensures
+                - returns the number of passes train() makes over the training
+                  documents.
+        !*/
+
+        void set_num_epochs (
+            unsigned long num
+        );
+        /*!
+            requires
+                - num > 0
+            ensures
+                - #get_num_epochs() == num
+        !*/
+
+        const std::string& get_feature_store_file (
+        ) const { return feature_store_file; }
+        /*!
+            ensures
+                - returns the name of the scratch file train() writes the documents'
+                  features to.  It needs enough disk space to hold them all, which is
+                  about 16 bytes per distinct word in each document plus 4 bytes per
+                  word feature extractor dimension per document.  train() deletes the
+                  file when it's done.
+                - If this is "" then each call to train() picks its own file name in the
+                  current directory, made from the process ID and a count of the calls
+                  to train() so far.  So several trainings can run from the same
+                  directory at once without clobbering each other's files.  If you set
+                  the file name yourself, make sure no other training uses it at the
+                  same time.
+        !*/
+
+        void set_feature_store_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - #get_feature_store_file() == filename
+        !*/
+
+        text_categorizer train (
+        ) const;
+        /*!
+            requires
+                - get_num_files() > 0
+            ensures
+                - Trains a text_categorizer based on the documents in the files given
+                  to add_file() and returns the result.
+            throws
+                - dlib::error if a training file can't be read, the feature store file
+                  can't be written, or the files don't contain any documents.
+        !*/
+
+    private:
+
+        total_word_feature_extractor tfe;
+        std::vector<std::string> filenames;
+        unsigned long num_threads;
+        unsigned long num_epochs;
+        std::string feature_store_file;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_STREAMING_TEXT_CATEGORIZER_TRaINER_H_
+
@@ -144,6 +144,23 @@ namespace mitie
                       while training this categorizer. For pure_model_version_1 and above,
                       an exception is thrown if there is a mismatch
         !*/
+        void predict(
+                const std::vector<std::string>& sentence,
+                const std::vector<dlib::matrix<float,0,1> >& sentence_feats,
+                string& text_tag,
+                double& text_score,
+                const total_word_feature_extractor& fe
+        ) const;
+        /*!
+            requires
+                - sentence_feats == sentence_to_feats(fe, sentence)
+            ensures
+                - This function is identical to predict(sentence,text_tag,text_score,fe)
+                  except that it uses the word feature vectors in sentence_feats rather
+                  than computing them itself.  This allows the features computed for a
+                  named_entity_extractor to be reused by the categorizer.
+        !*/
+
         string operator() (
                 const std::vector<std::string>& sentence
         ) const;
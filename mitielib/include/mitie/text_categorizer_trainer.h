@@ -7,6 +7,7 @@
 #include <mitie/total_word_feature_extractor.h>
 #include <mitie/text_categorizer.h>
 #include <mitie/text_feature_extraction.h>
+#include <mitie/training_options.h>
 #include <dlib/svm.h>
 #include <map>
 
@@ -27,6 +28,9 @@ namespace mitie
             ensures
                 - #get_beta() == 0.5
                 - #num_threads() == 4
+                - #get_parallel_search() == false
+                - #get_training_options() == a default initialized training_options
+                  object, i.e. training isn't limited and progress isn't reported.
                 - This function attempts to initialize a trainer for BoW based text categorizer.
         !*/
 
@@ -38,6 +42,9 @@ namespace mitie
             ensures
                 - #get_beta() == 0.5
                 - #num_threads() == 4
+                - #get_parallel_search() == false
+                - #get_training_options() == a default initialized training_options
+                  object, i.e. training isn't limited and progress isn't reported.
                 - This function attempts to load a mitie::total_word_feature_extractor from the
                   file with the given filename.  This feature extractor can be used during the
                   training process to improve the accuracy of text categorizer.
@@ -118,6 +125,47 @@ namespace mitie
                 - #get_beta() == new_beta
         !*/
 
+        bool get_parallel_search (
+        ) const;
+        /*!
+            ensures
+                - returns true if train() picks the classifier's C parameter with a
+                  parallel search and false if it uses the default serial line search.
+                  The parallel search evaluates several values of C at once, trains
+                  the cross-validation folds of each value at the same time, and keeps
+                  within the get_num_threads() thread budget.  So on a machine with
+                  many cores it finishes much sooner, even though it usually tries more
+                  values of C.  It also prints how long the search took compared to
+                  running the same evaluations serially.  If get_num_threads() is too
+                  small to evaluate more than one value of C at a time, the parallel
+                  search would only be slower, so train() uses the line search anyway.
+        !*/
+
+        void set_parallel_search (
+                bool enabled
+        );
+        /*!
+            ensures
+                - #get_parallel_search() == enabled
+        !*/
+
+        const training_options& get_training_options (
+        ) const;
+        /*!
+            ensures
+                - returns the limits on how long train() spends searching for the
+                  classifier's C parameter, and the callback it reports its progress
+                  to.  See training_options for details.
+        !*/
+
+        void set_training_options (
+                const training_options& options
+        );
+        /*!
+            ensures
+                - #get_training_options() == options
+        !*/
+
         text_categorizer train (
         ) const;
         /*!
@@ -136,6 +184,7 @@ namespace mitie
 
         typedef dlib::multiclass_linear_decision_function<dlib::sparse_linear_kernel<text_sample_type>,unsigned long> classifier_type;
         classifier_type train_text_categorizer_classifier (
+                training_monitor& monitor
         ) const;
 
         unsigned long get_label_id (
@@ -148,6 +197,8 @@ namespace mitie
         total_word_feature_extractor tfe;
         double beta;
         unsigned long num_threads;
+        bool parallel_search;
+        training_options options;
         std::map<std::string,unsigned long> label_to_id;
         std::vector<std::vector<std::string> > contents;
         std::vector<unsigned long> text_labels;
@@ -0,0 +1,158 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_TEXT_FEATURE_SToRE_H_
+#define MIT_LL_MITIE_TEXT_FEATURE_SToRE_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <dlib/uintn.h>
+#include <dlib/noncopyable.h>
+#include <mitie/float_sample.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class text_feature_store : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds a set of labeled float_samples in a scratch file on
+                disk.  It is how a trainer can make many passes over more training data
+                than fits in RAM: the features of each document are computed once,
+                appended to the store, and then read back a block at a time on each
+                pass.
+
+                The samples are packed back to back in the file in blocks of roughly
+                get_block_size() bytes.  Only the file offset of each block is kept in
+                RAM, so the RAM used by this object is essentially independent of how
+                many samples it holds.  Reading blocks in a random order gives a
+                trainer a cheap approximation of shuffling the whole data set.
+
+                Adding samples and reading them back are two separate stages.  First
+                call add() for every sample and then finish().  After that the store is
+                read only.
+
+            THREAD SAFETY
+                Not thread safe.  read_block() reads through one file handle, so only
+                one thread may call it at a time.
+        !*/
+
+    public:
+
+        explicit text_feature_store (
+            const std::string& filename,
+            unsigned long block_size = 1024*1024
+        );
+        /*!
+            requires
+                - block_size > 0
+            ensures
+                - Creates an empty store backed by the given file, which is created or
+                  truncated.  The file is deleted when this object is destroyed.
+                - #size() == 0
+                - #num_blocks() == 0
+                - #get_block_size() == block_size
+                - #is_finished() == false
+            throws
+                - dlib::error if the file can't be created.
+        !*/
+
+        ~text_feature_store (
+        );
+
+        void add (
+            const float_sample& x,
+            unsigned long label
+        );
+        /*!
+            requires
+                - is_finished() == false
+            ensures
+                - Appends x and its label to the store.
+                - #size() == size() + 1
+            throws
+                - dlib::error if the file can't be written.
+        !*/
+
+        void finish (
+        );
+        /*!
+            requires
+                - is_finished() == false
+            ensures
+                - Writes out any samples still buffered in RAM.
+                - #is_finished() == true
+            throws
+                - dlib::error if the file can't be written.
+        !*/
+
+        bool is_finished (
+        ) const { return finished; }
+
+        dlib::uint64 size (
+        ) const { return num_samples; }
+        /*!
+            ensures
+                - returns the number of samples that have been added to this store.
+        !*/
+
+        unsigned long get_block_size (
+        ) const { return block_size; }
+
+        unsigned long num_blocks (
+        ) const { return block_offsets.size()-1; }
+        /*!
+            ensures
+                - returns the number of blocks the samples have been written in.  Every
+                  sample is in exactly one block.
+        !*/
+
+        unsigned long max_index_plus_one (
+        ) const { return dims; }
+        /*!
+            ensures
+                - returns the dimensionality of the samples in the store, in the sense
+                  of dlib's max_index_plus_one().
+        !*/
+
+        void read_block (
+            unsigned long i,
+            std::vector<float_sample>& samples,
+            std::vector<unsigned long>& labels
+        );
+        /*!
+            requires
+                - is_finished() == true
+                - i < num_blocks()
+            ensures
+                - Appends the samples in the i-th block to samples and their labels to
+                  labels, in the order they were added.
+            throws
+                - dlib::error if the file can't be read.
+        !*/
+
+    private:
+
+        void write_block (
+        );
+
+        std::string filename;
+        unsigned long block_size;
+        std::fstream file;
+        std::vector<char> buf;
+        std::vector<dlib::uint64> block_offsets;
+        dlib::uint64 num_samples;
+        unsigned long dims;
+        bool finished;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_TEXT_FEATURE_SToRE_H_
+
@@ -28,7 +28,8 @@ namespace mitie
             THREAD SAFETY
                 Note that this object uses mutable internal scratch space.  Therefore, it is
                 unsafe for two threads to touch the same instance of this object at a time
-                without mutex locking it first.
+                without mutex locking it first.  The only exception is the version of
+                get_feature_vector() that takes a scratch argument.
         !*/
 
         inline static std::string convert_numbers (
@@ -90,6 +91,53 @@ namespace mitie
             compute_fingerprint();
         }
 
+        unsigned long add_words (
+            const std::map<std::string, dlib::matrix<float,0,1> >& word_vectors,
+            const double scale
+        )
+        /*!
+            requires
+                - get_num_dimensions() != 0
+                - for all words W in word_vectors:
+                    - word_vectors[W].size() == the size of the word vectors this object
+                      was constructed from.
+            ensures
+                - Adds the words in word_vectors that aren't already in this object's
+                  dictionary.  Each new word gets the feature vector the constructor would
+                  have given it if it had been one of the original words, except the word
+                  vector is multiplied by the given scale rather than a scale computed from
+                  word_vectors.  So if scale is the scale used when this object was
+                  constructed then the new words look just like the old ones.  The
+                  morphological features and the vectors of words already in the
+                  dictionary are not changed.
+                - Since this changes the state of this object, #get_fingerprint() will be
+                  different from get_fingerprint() if any words were added.  That means
+                  models trained with the old version of this object won't accept the new
+                  version.  They need to be retrained.
+                - returns the number of words added.
+        !*/
+        {
+            DLIB_CASSERT(get_num_dimensions() != 0, "Invalid arguments");
+
+            unsigned long num_added = 0;
+            dlib::matrix<float,0,1> feats;
+            std::map<std::string, dlib::matrix<float,0,1> >::const_iterator i;
+            for (i = word_vectors.begin(); i != word_vectors.end(); ++i)
+            {
+                DLIB_CASSERT(i->second.size()+1 == non_morph_feats, "Invalid arguments");
+                if (total_word_vectors.count(i->first) != 0)
+                    continue;
+
+                morph_fe.get_feature_vector(i->first, feats);
+                total_word_vectors[i->first] = join_cols(join_cols(dlib::zeros_matrix<float>(1,1), scale*i->second), feats);
+                ++num_added;
+            }
+
+            if (num_added != 0)
+                compute_fingerprint();
+            return num_added;
+        }
+
         dlib::uint64 get_fingerprint(
         ) const { return fingerprint; }
         /*!
@@ -136,6 +184,41 @@ namespace mitie
             feats(0) = 1;
         }
 
+        void get_feature_vector(
+            const std::string& word_,
+            dlib::matrix<float,0,1>& feats,
+            std::vector<dlib::uint16>& scratch
+        ) const
+        /*!
+            ensures
+                - This function is identical to the above get_feature_vector() routine
+                  except that it uses scratch as its working memory rather than memory
+                  inside this object.  Therefore, it is safe for multiple threads to call
+                  this function at the same time so long as they each use their own
+                  scratch vector.
+        !*/
+        {
+            const std::string word = convert_numbers(word_);
+            std::map<std::string, dlib::matrix<float,0,1> >::const_iterator i;
+            i = total_word_vectors.find(word);
+            if (i != total_word_vectors.end())
+            {
+                feats = i->second;
+                return;
+            }
+
+            if (get_num_dimensions() == 0)
+            {
+                feats.set_size(0);
+                return;
+            }
+
+            dlib::matrix<float,0,1> morph;
+            morph_fe.get_feature_vector(word, morph, scratch);
+            feats = join_cols(dlib::zeros_matrix<float>(non_morph_feats,1), morph);
+            feats(0) = 1;
+        }
+
         unsigned long get_num_dimensions(
         ) const
         /*!
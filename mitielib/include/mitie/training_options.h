@@ -0,0 +1,422 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_TRAINING_OPTIoNS_H_
+#define MIT_LL_MITIE_TRAINING_OPTIoNS_H_
+
+#include <string>
+#include <limits>
+#include <dlib/uintn.h>
+#include <dlib/error.h>
+#include <dlib/threads.h>
+#include <dlib/misc_api.h>
+#include <dlib/smart_pointers.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct training_progress
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is what the trainers report to a training_progress_callback as they
+                run.  Training is split into phases, which happen one after another:
+                    - "segmenter parameter search" and "segmenter training"
+                      (ner_trainer only)
+                    - "classifier parameter search" and "classifier training"
+                The parameter search phases run cross-validation for each candidate
+                parameter setting they try, and these evaluations are where nearly all
+                the time goes and what the training_options limit.  A trainer skips the
+                parameter search phases when there's too little data to cross-validate
+                on or, for ner_trainer, when it uses the averaged perceptron.
+        !*/
+
+        training_progress (
+        ) : iteration(0), objective(0), best_objective(0), elapsed_seconds(0), eta_seconds(-1), memory_usage(0) {}
+
+        // The name of the current phase, one of the strings listed above.
+        std::string phase;
+
+        // 0 when a phase begins.  After that, the number of parameter settings the
+        // search has evaluated, or 1 once a training phase is done.
+        unsigned long iteration;
+
+        // The cross-validation score of the parameters that were just evaluated, or for
+        // a finished training phase, the score of the trained model on its training
+        // data.  Higher is better.  In both cases best_objective is the largest
+        // objective seen so far in this phase.
+        double objective;
+        double best_objective;
+
+        // Seconds since train() was called.
+        double elapsed_seconds;
+
+        // An estimate of the seconds left in this phase, or -1 if there isn't one.  For
+        // a parameter search this assumes it uses its whole evaluation budget, so it's
+        // pessimistic, but it never exceeds the time left under the wall time limit.
+        double eta_seconds;
+
+        // The number of bytes of RAM the process is using, or 0 if that isn't
+        // available on this platform.
+        dlib::uint64 memory_usage;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class training_progress_callback
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is the interface for receiving progress reports from the trainers.
+                Subclass it and give an instance to
+                training_options::set_progress_callback().
+
+                The callback may be invoked from threads other than the one that called
+                train(), but never from two threads at once.  It should return quickly
+                since training waits for it.
+        !*/
+    public:
+        virtual ~training_progress_callback() {}
+
+        virtual void operator() (
+            const training_progress& progress
+        ) = 0;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class training_options
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the limits on how long ner_trainer,
+                text_categorizer_trainer, and binary_relation_detector_trainer spend
+                training, along with an optional callback they report their progress to.
+
+                The running time of these trainers is dominated by their parameter
+                searches, each of which cross-validates a model for every parameter
+                setting it tries.  How many settings that takes depends on the data, so
+                left alone the training time is hard to predict.  These options bound
+                the searches.  When a search hits a limit it stops and the trainer uses
+                the best parameters found so far, or its default parameters if the
+                search didn't get to evaluate any.
+        !*/
+    public:
+
+        training_options (
+        );
+        /*!
+            ensures
+                - #get_max_wall_time() == 0
+                - #get_max_search_evaluations() == 0
+                - #get_early_stopping_patience() == 0
+                - #get_early_stopping_tolerance() == 0
+                - #get_progress_callback() == a null pointer
+        !*/
+
+        double get_max_wall_time (
+        ) const { return max_wall_time; }
+        /*!
+            ensures
+                - returns the number of seconds train() may spend on parameter
+                  searches, counted from when train() is called, or 0 if there is no
+                  limit.  Once the time is up, a search that is running stops and any
+                  later searches are skipped.  Every model still has to be trained once
+                  with the chosen parameters, so train() runs longer than this by the
+                  time those final trainings take.
+        !*/
+
+        void set_max_wall_time (
+            double seconds
+        );
+        /*!
+            requires
+                - seconds >= 0
+            ensures
+                - #get_max_wall_time() == seconds
+        !*/
+
+        unsigned long get_max_search_evaluations (
+        ) const { return max_search_evaluations; }
+        /*!
+            ensures
+                - returns the maximum number of parameter settings each parameter search
+                  may evaluate, or 0 if the trainers use their built in limits.
+        !*/
+
+        void set_max_search_evaluations (
+            unsigned long num
+        ) { max_search_evaluations = num; }
+        /*!
+            ensures
+                - #get_max_search_evaluations() == num
+        !*/
+
+        unsigned long get_early_stopping_patience (
+        ) const { return patience; }
+        /*!
+            ensures
+                - returns the number of evaluations in a row a parameter search may make
+                  without improving on its best cross-validation score by more than
+                  get_early_stopping_tolerance() before it stops, or 0 if the searches
+                  don't stop early.
+        !*/
+
+        double get_early_stopping_tolerance (
+        ) const { return tolerance; }
+
+        void set_early_stopping (
+            unsigned long patience,
+            double tolerance
+        );
+        /*!
+            requires
+                - tolerance >= 0
+            ensures
+                - #get_early_stopping_patience() == patience
+                - #get_early_stopping_tolerance() == tolerance
+        !*/
+
+        const dlib::shared_ptr<training_progress_callback>& get_progress_callback (
+        ) const { return callback; }
+        /*!
+            ensures
+                - returns the callback the trainers report their progress to, or a null
+                  pointer if they don't report it.
+        !*/
+
+        void set_progress_callback (
+            const dlib::shared_ptr<training_progress_callback>& cb
+        ) { callback = cb; }
+        /*!
+            ensures
+                - #get_progress_callback() == cb
+                - The trainers call cb at the start of each phase, after each parameter
+                  evaluation in a search, and at the end of each training phase.
+        !*/
+
+    private:
+        double max_wall_time;
+        unsigned long max_search_evaluations;
+        unsigned long patience;
+        double tolerance;
+        dlib::shared_ptr<training_progress_callback> callback;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    dlib::uint64 get_process_memory_usage (
+    );
+    /*!
+        ensures
+            - returns the number of bytes of RAM this process is using, or 0 if that
+              can't be determined on this platform.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    class training_monitor
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is what the trainers use to apply a training_options to one
+                call to train().  It keeps the clock, counts the evaluations of the
+                current parameter search, decides when the search should stop, and
+                sends training_progress reports to the callback.
+
+                All the member functions are thread safe, since the parallel parameter
+                searches evaluate several settings at once.
+        !*/
+    public:
+
+        explicit training_monitor (
+            const training_options& options
+        );
+        /*!
+            ensures
+                - The clock for options.get_max_wall_time() starts now.
+        !*/
+
+        void begin_search (
+            const std::string& phase,
+            unsigned long default_max_evaluations
+        );
+        /*!
+            ensures
+                - Starts a new parameter search phase and reports it to the callback.
+                - #get_max_evaluations() == the options' get_max_search_evaluations(),
+                  or default_max_evaluations if that is 0.
+        !*/
+
+        unsigned long get_max_evaluations (
+        ) const;
+        /*!
+            ensures
+                - returns the number of evaluations the current search may make.
+        !*/
+
+        bool begin_evaluation (
+        );
+        /*!
+            ensures
+                - if (the current search may make another evaluation) then
+                    - returns true.  The caller should evaluate a parameter setting and
+                      then call end_evaluation().
+                - else
+                    - returns false and #search_is_over() == true.  The first time this
+                      happens in a search it prints why the search is stopping.
+        !*/
+
+        void end_evaluation (
+            double score
+        );
+        /*!
+            ensures
+                - Records the cross-validation score of an evaluation begun with
+                  begin_evaluation() and reports it to the callback.
+        !*/
+
+        bool search_is_over (
+        ) const;
+        /*!
+            ensures
+                - returns true if begin_evaluation() has refused to start an evaluation
+                  in the current search.
+        !*/
+
+        void begin_phase (
+            const std::string& phase
+        );
+        /*!
+            ensures
+                - Starts a new phase that isn't a parameter search and reports it to the
+                  callback.
+        !*/
+
+        void end_phase (
+            double objective
+        );
+        /*!
+            ensures
+                - Reports to the callback that the current phase finished and its model
+                  scored objective on the training data.
+        !*/
+
+        double get_elapsed_seconds (
+        ) const;
+        /*!
+            ensures
+                - returns the number of seconds since this object was constructed.
+        !*/
+
+    private:
+
+        void report (
+            unsigned long iteration,
+            double objective,
+            double eta_seconds
+        ) const;
+
+        const training_options options;
+        dlib::timestamper ts;
+        const dlib::uint64 start;
+        dlib::mutex m;
+
+        std::string phase;
+        dlib::uint64 phase_start;
+        unsigned long max_evals;
+        unsigned long num_started;
+        unsigned long num_finished;
+        unsigned long since_improvement;
+        double best_score;
+        bool over;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class search_stopped : public dlib::error
+    {
+    public:
+        search_stopped() : dlib::error("The parameter search was stopped by its training_options.") {}
+    };
+
+    template <typename funct, typename param_type>
+    class monitored_objective
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a wrapper that runs a parameter search's objective function under
+                a training_monitor.  Each call checks with the monitor first.  When the
+                search should stop, a serial search is aborted by throwing search_stopped,
+                while for a parallel search, which can't throw out of its worker threads,
+                the call just returns -infinity without evaluating f.  Either way
+                get_best() gives the best parameters that were evaluated.
+        !*/
+    public:
+        monitored_objective (
+            const funct& f_,
+            training_monitor& monitor_,
+            bool throw_when_stopped_
+        ) : f(f_), monitor(monitor_), throw_when_stopped(throw_when_stopped_),
+            has_best(false), best_score(-std::numeric_limits<double>::infinity()) {}
+
+        double operator() (
+            const param_type& x
+        ) const
+        {
+            if (!monitor.begin_evaluation())
+            {
+                if (throw_when_stopped)
+                    throw search_stopped();
+                return -std::numeric_limits<double>::infinity();
+            }
+
+            const double score = f(x);
+            {
+                dlib::auto_mutex lock(m);
+                if (!has_best || score > best_score)
+                {
+                    has_best = true;
+                    best_score = score;
+                    best_x = x;
+                }
+            }
+            monitor.end_evaluation(score);
+            return score;
+        }
+
+        bool get_best (
+            param_type& x
+        ) const
+        /*!
+            ensures
+                - if (any parameters were evaluated) then
+                    - #x == the parameters that got the largest score
+                    - returns true
+                - else
+                    - returns false
+        !*/
+        {
+            dlib::auto_mutex lock(m);
+            if (has_best)
+                x = best_x;
+            return has_best;
+        }
+
+    private:
+        const funct& f;
+        training_monitor& monitor;
+        const bool throw_when_stopped;
+        dlib::mutex m;
+        mutable bool has_best;
+        mutable double best_score;
+        mutable param_type best_x;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_TRAINING_OPTIoNS_H_
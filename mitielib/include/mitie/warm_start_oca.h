@@ -0,0 +1,563 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_WARM_START_OcA_H_
+#define MIT_LL_MITIE_WARM_START_OcA_H_
+
+#include <vector>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <dlib/matrix.h>
+#include <dlib/threads.h>
+#include <dlib/smart_pointers.h>
+#include <dlib/optimization/optimization_oca.h>
+#include <dlib/optimization/optimization_solve_qp_using_smo.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class warm_start_oca;
+    template <typename matrix_type> class fold_warm_starts;
+
+    template <typename matrix_type>
+    class oca_warm_start
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object carries what warm_start_oca learned while solving one
+                problem over to the next solve of a similar problem.  It holds the last
+                solution found and the cutting planes that were active at that
+                solution.
+
+                The cutting planes are lower bounds on the risk part of the objective,
+                so they stay valid when only C changes.  They are reused when the next
+                problem has the same training data and was tagged with the same
+                risk_params (e.g. the loss parameters of a structural SVM).  Otherwise
+                only the solution is used, as the starting point of the next solve.
+
+                The solution and cutting planes are dense vectors as big as the whole
+                weight vector, so they are held by read only shared pointers.  That
+                means copying an oca_warm_start only copies the pointers and a few
+                small matrices, not the vectors themselves.
+        !*/
+
+    public:
+        typedef typename matrix_type::type scalar_type;
+
+        explicit oca_warm_start (
+            unsigned long max_saved_planes_ = 20
+        ) : w(new matrix_type()), max_saved_planes(max_saved_planes_) {}
+        /*!
+            ensures
+                - #has_solution() == false
+                - #num_saved_planes() == 0
+                - #get_max_saved_planes() == max_saved_planes_
+        !*/
+
+        bool has_solution (
+        ) const { return w->size() != 0; }
+
+        const matrix_type& get_solution (
+        ) const { return *w; }
+        /*!
+            ensures
+                - returns the solution found by the last solve that used this object, or
+                  the vector given to set_solution().
+        !*/
+
+        void set_solution (
+            const matrix_type& w_
+        )
+        /*!
+            ensures
+                - #get_solution() == w_
+                - #num_saved_planes() == 0
+                  (since they may not be valid for whatever problem w_ came from)
+        !*/
+        {
+            w.reset(new matrix_type(w_));
+            planes.clear();
+            bs.clear();
+            alpha.set_size(0);
+            K.set_size(0,0);
+        }
+
+        unsigned long num_saved_planes (
+        ) const { return planes.size(); }
+
+        unsigned long get_max_saved_planes (
+        ) const { return max_saved_planes; }
+        /*!
+            ensures
+                - returns the most cutting planes a solve will leave in this object.
+                  Each is as big as the solution vector, so this bounds the RAM used.
+        !*/
+
+        void clear (
+        )
+        /*!
+            ensures
+                - #has_solution() == false
+                - #num_saved_planes() == 0
+        !*/
+        {
+            set_solution(matrix_type());
+            risk_params.clear();
+        }
+
+    private:
+        friend class warm_start_oca;
+        friend class fold_warm_starts<matrix_type>;
+
+        typedef dlib::matrix<scalar_type,0,0,typename matrix_type::mem_manager_type,
+                             typename matrix_type::layout_type> kernel_matrix_type;
+        // Nothing ever modifies a vector once one of these points to it, which is what
+        // lets copies of this object share them.
+        typedef dlib::shared_ptr<const matrix_type> vector_ptr;
+
+        vector_ptr w;
+        std::vector<double> risk_params;
+        std::vector<vector_ptr> planes;
+        std::vector<scalar_type> bs;
+        matrix_type alpha;
+        kernel_matrix_type K;
+        unsigned long max_saved_planes;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class warm_start_oca
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is the same cutting plane solver as dlib::oca, with the same
+                settings, except that it can be warm started from an oca_warm_start
+                object.  dlib::oca always starts from w == 0 and an empty set of cutting
+                planes.  That is a waste when solving a sequence of problems which only
+                differ a little, such as when trying different values of C during a
+                parameter search.
+
+                Note that dlib::oca's support for priors and force_weight_to_1 isn't
+                implemented here.
+        !*/
+
+    public:
+
+        warm_start_oca (
+        ) : sub_eps(1e-2), sub_max_iter(50000), inactive_thresh(20) {}
+
+        void set_subproblem_epsilon (
+            double eps_
+        ) { sub_eps = eps_; }
+
+        double get_subproblem_epsilon (
+        ) const { return sub_eps; }
+
+        void set_subproblem_max_iterations (
+            unsigned long sub_max_iter_
+        ) { sub_max_iter = sub_max_iter_; }
+
+        unsigned long get_subproblem_max_iterations (
+        ) const { return sub_max_iter; }
+
+        void set_inactive_plane_threshold (
+            unsigned long inactive_thresh_
+        ) { inactive_thresh = inactive_thresh_; }
+
+        unsigned long get_inactive_plane_threshold (
+        ) const { return inactive_thresh; }
+
+        template <
+            typename matrix_type
+            >
+        typename matrix_type::type operator() (
+            const dlib::oca_problem<matrix_type>& problem,
+            matrix_type& w,
+            unsigned long num_nonnegative = 0
+        ) const
+        /*!
+            ensures
+                - Solves problem from scratch, exactly like dlib::oca does.
+        !*/
+        {
+            oca_warm_start<matrix_type> ws(0);
+            return (*this)(problem, w, num_nonnegative, ws, std::vector<double>());
+        }
+
+        template <
+            typename matrix_type
+            >
+        typename matrix_type::type operator() (
+            const dlib::oca_problem<matrix_type>& problem,
+            matrix_type& w,
+            unsigned long num_nonnegative,
+            oca_warm_start<matrix_type>& ws,
+            const std::vector<double>& risk_params
+        ) const
+        /*!
+            requires
+                - problem.get_c() > 0
+                - problem.get_num_dimensions() > 0
+                - if (ws.num_saved_planes() != 0 && ws.risk_params == risk_params) then
+                    - ws was last used to solve a problem whose risk function is the
+                      same as problem's.  That is, it had the same training data and
+                      loss and can differ only in C.
+            ensures
+                - Solves the same optimization problem as dlib::oca()(problem, w,
+                  num_nonnegative) and returns the objective value at #w.
+                - If ws.get_solution() has the right dimensionality then the solver
+                  starts from it rather than from 0.
+                - If ws holds cutting planes tagged with risk_params then they are used
+                  as the solver's initial approximation of the risk.
+                - #ws.get_solution() == #w
+                - #ws holds the cutting planes which were active at #w, tagged with
+                  risk_params, so the next call can pick up where this one left off.
+        !*/
+        {
+            using namespace dlib;
+            typedef typename matrix_type::type scalar_type;
+            typedef typename oca_warm_start<matrix_type>::kernel_matrix_type kernel_matrix_type;
+            typedef typename oca_warm_start<matrix_type>::vector_ptr vector_ptr;
+
+            const long num_dims = problem.get_num_dimensions();
+
+            DLIB_ASSERT(problem.get_c() > 0 && num_dims > 0,
+                "\t scalar_type warm_start_oca::operator()"
+                << "\n\t The oca_problem is invalid"
+                << "\n\t problem.get_c():              " << problem.get_c()
+                << "\n\t problem.get_num_dimensions(): " << num_dims
+                << "\n\t this: " << this
+                );
+
+            if (num_nonnegative > (unsigned long)num_dims)
+                num_nonnegative = num_dims;
+
+            const scalar_type C = problem.get_c();
+
+            std::vector<vector_ptr> planes;
+            std::vector<scalar_type> bs, miss_count;
+            matrix_type new_plane, alpha;
+            kernel_matrix_type K, Ktmp;
+
+            if (ws.w->size() == num_dims)
+            {
+                w = *ws.w;
+                if (num_nonnegative != 0)
+                    set_rowm(w,range(0,num_nonnegative-1)) = lowerbound(rowm(w,range(0,num_nonnegative-1)),0);
+            }
+            else
+            {
+                w.set_size(num_dims, 1);
+                w = 0;
+            }
+
+            if (ws.planes.size() != 0 && ws.risk_params == risk_params && ws.planes[0]->size() == num_dims)
+            {
+                // The old planes are still lower bounds on the risk, but the dual
+                // variables must sum to the new C.  ws may be a copy sharing its planes
+                // with other warm starts, so only the pointers are copied here.
+                planes = ws.planes;
+                bs = ws.bs;
+                K = ws.K;
+                alpha = ws.alpha*(C/sum(ws.alpha));
+                miss_count.assign(planes.size(), 0);
+            }
+            else
+            {
+                scalar_type R_lower_bound;
+                if (problem.risk_has_lower_bound(R_lower_bound))
+                {
+                    // The flat lower bounding plane is always good to have if we know
+                    // what it is.
+                    bs.push_back(R_lower_bound);
+                    planes.push_back(vector_ptr(new matrix_type(zeros_matrix(w))));
+                    alpha = uniform_matrix<scalar_type>(1,1, C);
+                    miss_count.push_back(0);
+
+                    K.set_size(1,1);
+                    K(0,0) = 0;
+                }
+            }
+
+            // The current objective value.  Note also that w always contains the
+            // current solution.
+            scalar_type cur_obj = std::numeric_limits<scalar_type>::max();
+
+            // This will hold the cutting plane objective value.  This value is a lower
+            // bound on the true optimal objective value.
+            scalar_type cp_obj = 0;
+
+            unsigned long counter = 0;
+            while (true)
+            {
+                // add the next cutting plane
+                scalar_type cur_risk;
+                problem.get_risk(w, cur_risk, new_plane);
+
+                bs.push_back(cur_risk - dot(w,new_plane));
+                planes.push_back(vector_ptr(new matrix_type(new_plane)));
+                miss_count.push_back(0);
+
+                // If alpha is empty then initialize it (we must always have sum(alpha) ==
+                // C).  But otherwise, just append a zero.
+                if (alpha.size() == 0)
+                    alpha = uniform_matrix<scalar_type>(1,1, C);
+                else
+                    alpha = join_cols(alpha,zeros_matrix<scalar_type>(1,1));
+
+                const scalar_type wnorm = 0.5*trans(w)*w;
+                cur_obj = wnorm + C*cur_risk;
+
+                // report current status
+                const scalar_type risk_gap = cur_risk - (cp_obj-wnorm)/C;
+                if (counter > 0 && problem.optimization_status(cur_obj, cur_obj - cp_obj,
+                                                               cur_risk, risk_gap, planes.size(), counter))
+                {
+                    break;
+                }
+
+                // compute kernel matrix for all the planes
+                K.swap(Ktmp);
+                K.set_size(planes.size(), planes.size());
+                // copy over the old K matrix
+                set_subm(K, 0,0, Ktmp.nr(), Ktmp.nc()) = Ktmp;
+
+                // now add the new row and column to K
+                for (unsigned long c = 0; c < planes.size(); ++c)
+                {
+                    K(c, Ktmp.nc()) = dot(*planes[c], *planes.back());
+                    K(Ktmp.nc(), c) = K(c,Ktmp.nc());
+                }
+
+                // solve the cutting plane subproblem for the next w.   We solve it to an
+                // accuracy that is related to how big the error gap is.
+                scalar_type eps = std::min<scalar_type>(sub_eps, 0.1*(cur_obj-cp_obj)) ;
+                // just a sanity check
+                if (eps < 1e-16)
+                    eps = 1e-16;
+                // Note that we warm start this optimization by using the alpha from the
+                // last iteration as the starting point.
+                if (num_nonnegative != 0)
+                {
+                    // copy planes into a matrix so we can call solve_qp4_using_smo()
+                    kernel_matrix_type planes_mat(num_nonnegative,planes.size());
+                    for (unsigned long i = 0; i < planes.size(); ++i)
+                        set_colm(planes_mat,i) = colm(*planes[i],0,num_nonnegative);
+
+                    solve_qp4_using_smo(planes_mat, K, mat(bs), alpha, eps, sub_max_iter);
+                }
+                else
+                {
+                    solve_qp_using_smo(K, mat(bs), alpha, eps, sub_max_iter);
+                }
+
+                // construct the w that minimized the subproblem.
+                w = -alpha(0)*(*planes[0]);
+                for (unsigned long i = 1; i < planes.size(); ++i)
+                    w -= alpha(i)*(*planes[i]);
+                // threshold the first num_nonnegative w elements if necessary.
+                if (num_nonnegative != 0)
+                    set_rowm(w,range(0,num_nonnegative-1)) = lowerbound(rowm(w,range(0,num_nonnegative-1)),0);
+
+                for (long i = 0; i < alpha.size(); ++i)
+                {
+                    if (alpha(i) != 0)
+                        miss_count[i] = 0;
+                    else
+                        miss_count[i] += 1;
+                }
+
+                // Compute the lower bound on the true objective given to us by the
+                // cutting plane subproblem.
+                cp_obj = -0.5*trans(w)*w + trans(alpha)*mat(bs);
+
+                // If it has been a while since a cutting plane was an active constraint
+                // then we should throw it away.
+                while (max(mat(miss_count)) >= inactive_thresh)
+                {
+                    const long idx = index_of_max(mat(miss_count));
+                    bs.erase(bs.begin()+idx);
+                    miss_count.erase(miss_count.begin()+idx);
+                    K = removerc(K, idx, idx);
+                    alpha = remove_row(alpha,idx);
+                    planes.erase(planes.begin()+idx);
+                }
+
+                ++counter;
+            }
+
+            save_active_planes(w, planes, bs, alpha, K, ws, risk_params);
+            return cur_obj;
+        }
+
+    private:
+
+        template <
+            typename matrix_type,
+            typename kernel_matrix_type
+            >
+        void save_active_planes (
+            const matrix_type& w,
+            const std::vector<typename oca_warm_start<matrix_type>::vector_ptr>& planes,
+            const std::vector<typename matrix_type::type>& bs,
+            const matrix_type& alpha,
+            const kernel_matrix_type& K,
+            oca_warm_start<matrix_type>& ws,
+            const std::vector<double>& risk_params
+        ) const
+        /*!
+            ensures
+                - puts the (at most ws.get_max_saved_planes()) planes with the largest
+                  alpha values into ws.  The last plane is left out since it was made at
+                  w and the next solve starts by making that same plane again.
+        !*/
+        {
+            typedef typename matrix_type::type scalar_type;
+            ws.set_solution(w);
+            ws.risk_params = risk_params;
+
+            std::vector<std::pair<scalar_type,unsigned long> > active;
+            for (long i = 0; i < K.nr(); ++i)
+            {
+                if (alpha(i) > 0)
+                    active.push_back(std::make_pair(-alpha(i), (unsigned long)i));
+            }
+            std::sort(active.begin(), active.end());
+            if (active.size() > ws.max_saved_planes)
+                active.resize(ws.max_saved_planes);
+            if (active.size() == 0)
+                return;
+
+            ws.planes.resize(active.size());
+            ws.bs.resize(active.size());
+            ws.alpha.set_size(active.size());
+            ws.K.set_size(active.size(), active.size());
+            for (unsigned long i = 0; i < active.size(); ++i)
+            {
+                const unsigned long idx = active[i].second;
+                ws.planes[i] = planes[idx];
+                ws.bs[i] = bs[idx];
+                ws.alpha(i) = alpha(idx);
+                for (unsigned long j = 0; j < active.size(); ++j)
+                    ws.K(i,j) = K(idx, active[j].second);
+            }
+        }
+
+        double sub_eps;
+        unsigned long sub_max_iter;
+        unsigned long inactive_thresh;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename matrix_type>
+    class fold_warm_starts : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object keeps one oca_warm_start for each fold of the
+                cross-validation run by a parameter search, so each candidate
+                parameter's folds are warm started from the folds of the candidate
+                evaluated before it.  It also remembers the fold solutions of the
+                best scoring candidate so the final training on all the data can start
+                from them.
+
+            THREAD SAFETY
+                It is safe for any number of threads to use this object at once, so it
+                works with searches that evaluate several candidates at the same time.
+                Each evaluation gets its own copy of the fold states and the last one
+                to finish is what the next evaluation starts from.  The copies share
+                their solution and cutting plane vectors, so handing them out doesn't
+                copy any of the big vectors.
+        !*/
+
+    public:
+        typedef dlib::shared_ptr<oca_warm_start<matrix_type> > warm_start_ptr;
+
+        fold_warm_starts (
+            unsigned long folds,
+            unsigned long max_saved_planes
+        ) : best_score(-std::numeric_limits<double>::infinity())
+        {
+            for (unsigned long i = 0; i < folds; ++i)
+                states.push_back(warm_start_ptr(new oca_warm_start<matrix_type>(max_saved_planes)));
+        }
+
+        unsigned long num_folds (
+        ) const { return states.size(); }
+
+        void get_fold_states (
+            std::vector<warm_start_ptr>& ws
+        ) const
+        /*!
+            ensures
+                - #ws.size() == num_folds()
+                - #ws[i] is a new copy of the current state of the i-th fold.  It
+                  shares the state's solution and cutting plane vectors rather than
+                  copying them.
+        !*/
+        {
+            dlib::auto_mutex lock(m);
+            ws.resize(states.size());
+            for (unsigned long i = 0; i < states.size(); ++i)
+                ws[i].reset(new oca_warm_start<matrix_type>(*states[i]));
+        }
+
+        void record_fold_states (
+            const std::vector<warm_start_ptr>& ws,
+            double score
+        )
+        /*!
+            requires
+                - ws.size() == num_folds()
+                - ws came from get_fold_states() and was then used to train the folds of
+                  a candidate which got the given cross-validation score.
+            ensures
+                - the next call to get_fold_states() returns copies of ws.
+                - if (score is the best score recorded so far) then
+                    - #get_best_solutions() returns the solutions in ws.
+        !*/
+        {
+            dlib::auto_mutex lock(m);
+            for (unsigned long i = 0; i < states.size(); ++i)
+                states[i] = ws[i];
+            if (score > best_score)
+            {
+                best_score = score;
+                best_solutions.resize(ws.size());
+                for (unsigned long i = 0; i < ws.size(); ++i)
+                    best_solutions[i] = ws[i]->w;
+            }
+        }
+
+        void get_best_solutions (
+            std::vector<matrix_type>& solutions
+        ) const
+        /*!
+            ensures
+                - #solutions == the fold solutions of the best scoring candidate given to
+                  record_fold_states(), or an empty vector if nothing has been recorded.
+        !*/
+        {
+            dlib::auto_mutex lock(m);
+            solutions.resize(best_solutions.size());
+            for (unsigned long i = 0; i < best_solutions.size(); ++i)
+                solutions[i] = *best_solutions[i];
+        }
+
+    private:
+        dlib::mutex m;
+        std::vector<warm_start_ptr> states;
+        double best_score;
+        std::vector<typename oca_warm_start<matrix_type>::vector_ptr> best_solutions;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_WARM_START_OcA_H_
+
@@ -0,0 +1,308 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MITIE_WARM_START_TRaINERS_H_
+#define MIT_LL_MITIE_WARM_START_TRaINERS_H_
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <dlib/svm.h>
+#include <dlib/svm_threaded.h>
+#include <dlib/smart_pointers.h>
+#include <mitie/warm_start_oca.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename matrix_type>
+    matrix_type resize_multiclass_weights (
+        const matrix_type& w,
+        const long num_labels,
+        const long dims
+    )
+    /*!
+        requires
+            - num_labels > 0
+            - w.size() is a multiple of num_labels and w.size()/num_labels > 0
+            - w holds the weights of a multiclass linear SVM laid out the way
+              dlib::multiclass_svm_problem lays them out.  That is, for each label in
+              turn, a weight for each sample dimension followed by the bias.
+        ensures
+            - returns the weight vector for the same classifier on samples with dims
+              dimensions.  Weights for dimensions w doesn't have are set to 0 and
+              weights for dimensions beyond dims are dropped.
+    !*/
+    {
+        const long old_dims = w.size()/num_labels - 1;
+        matrix_type temp(num_labels*(dims+1));
+        temp = 0;
+        const long n = std::min(dims, old_dims);
+        for (long r = 0; r < num_labels; ++r)
+        {
+            for (long c = 0; c < n; ++c)
+                temp(r*(dims+1) + c) = w(r*(old_dims+1) + c);
+            temp(r*(dims+1) + dims) = w(r*(old_dims+1) + old_dims);
+        }
+        return temp;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename K,
+        typename label_type_ = typename K::scalar_type
+        >
+    class warm_start_multiclass_linear_trainer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object trains the same classifier as dlib::svm_multiclass_linear_trainer
+                but solves with warm_start_oca.  So if it's given an oca_warm_start left
+                over from training on the same samples with a different C, or from a
+                classifier trained on similar data, it starts from that solution rather
+                than from scratch.
+
+                It takes its settings (C, epsilon, max iterations, number of threads, and
+                whether to learn non-negative weights) from a
+                dlib::svm_multiclass_linear_trainer.  Priors aren't supported.
+        !*/
+
+    public:
+        typedef label_type_ label_type;
+        typedef K kernel_type;
+        typedef typename kernel_type::scalar_type scalar_type;
+        typedef typename kernel_type::sample_type sample_type;
+        typedef dlib::matrix<scalar_type,0,1> w_type;
+        typedef dlib::multiclass_linear_decision_function<kernel_type, label_type> trained_function_type;
+        typedef dlib::shared_ptr<oca_warm_start<w_type> > warm_start_ptr;
+
+        warm_start_multiclass_linear_trainer (
+        ) {}
+
+        warm_start_multiclass_linear_trainer (
+            const dlib::svm_multiclass_linear_trainer<K,label_type>& settings_,
+            const warm_start_ptr& warm_start_ = warm_start_ptr()
+        ) : settings(settings_), warm_start(warm_start_) {}
+
+        void set_num_threads (
+            unsigned long num
+        ) { settings.set_num_threads(num); }
+
+        unsigned long get_num_threads (
+        ) const { return settings.get_num_threads(); }
+
+        const warm_start_ptr& get_warm_start (
+        ) const { return warm_start; }
+
+        void set_warm_start (
+            const warm_start_ptr& ws
+        ) { warm_start = ws; }
+        /*!
+            ensures
+                - train() will start from *ws and update it with the solution it finds.
+                  If ws is null then train() starts from scratch.
+        !*/
+
+        const trained_function_type train (
+            const std::vector<sample_type>& all_samples,
+            const std::vector<label_type>& all_labels
+        ) const
+        {
+            using namespace dlib;
+            DLIB_ASSERT(is_learning_problem(all_samples,all_labels),
+                "\t trained_function_type warm_start_multiclass_linear_trainer::train(all_samples,all_labels)"
+                << "\n\t invalid inputs were given to this function"
+                << "\n\t all_samples.size():     " << all_samples.size()
+                << "\n\t all_labels.size():      " << all_labels.size()
+                );
+
+            trained_function_type df;
+            df.labels = select_all_distinct_labels(all_labels);
+            const long dims = max_index_plus_one(all_samples);
+
+            multiclass_svm_problem<w_type, sample_type, label_type> problem(all_samples, all_labels, df.labels,
+                                                                            dims, settings.get_num_threads());
+            problem.set_max_cache_size(0);
+            problem.set_c(settings.get_c());
+            problem.set_epsilon(settings.get_epsilon());
+            problem.set_max_iterations(settings.get_max_iterations());
+
+            unsigned long num_nonnegative = 0;
+            if (settings.learns_nonnegative_weights())
+                num_nonnegative = problem.get_num_dimensions();
+
+            w_type weights;
+            warm_start_oca solver;
+            if (warm_start)
+            {
+                // A solution from data with a different number of dimensions can still
+                // be used as a starting point once it's padded out or truncated.
+                const long num_labels = df.labels.size();
+                const w_type& w = warm_start->get_solution();
+                if (w.size() != 0 && w.size() != problem.get_num_dimensions() && w.size()%num_labels == 0)
+                    warm_start->set_solution(resize_multiclass_weights(w, num_labels, dims));
+                solver(problem, weights, num_nonnegative, *warm_start, std::vector<double>());
+            }
+            else
+            {
+                solver(problem, weights, num_nonnegative);
+            }
+
+            df.weights = colm(reshape(weights, df.labels.size(), dims+1), range(0,dims-1));
+            df.b       = colm(reshape(weights, df.labels.size(), dims+1), dims);
+            return df;
+        }
+
+    private:
+        dlib::svm_multiclass_linear_trainer<K,label_type> settings;
+        warm_start_ptr warm_start;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename feature_extractor
+        >
+    class warm_start_segmentation_trainer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object trains the same sequence_segmenter as
+                dlib::structural_sequence_segmentation_trainer but solves with
+                warm_start_oca.  So if it's given an oca_warm_start left over from
+                training on the same data with different parameters, or from a
+                segmenter trained on similar data, it starts from that solution rather
+                than from scratch.  The cutting planes in the oca_warm_start are only
+                reused if the loss parameters haven't changed.
+
+                It takes its settings from a dlib::structural_sequence_segmentation_trainer.
+        !*/
+
+    public:
+        typedef typename feature_extractor::sequence_type sample_sequence_type;
+        typedef std::vector<std::pair<unsigned long, unsigned long> > segmented_sequence_type;
+        typedef dlib::sequence_segmenter<feature_extractor> trained_function_type;
+        typedef dlib::shared_ptr<oca_warm_start<dlib::matrix<double,0,1> > > warm_start_ptr;
+
+        warm_start_segmentation_trainer (
+        ) {}
+
+        warm_start_segmentation_trainer (
+            const dlib::structural_sequence_segmentation_trainer<feature_extractor>& settings_,
+            const warm_start_ptr& warm_start_ = warm_start_ptr()
+        ) : settings(settings_), warm_start(warm_start_) {}
+
+        void set_num_threads (
+            unsigned long num
+        ) { settings.set_num_threads(num); }
+
+        unsigned long get_num_threads (
+        ) const { return settings.get_num_threads(); }
+
+        const warm_start_ptr& get_warm_start (
+        ) const { return warm_start; }
+
+        void set_warm_start (
+            const warm_start_ptr& ws
+        ) { warm_start = ws; }
+        /*!
+            ensures
+                - train() will start from *ws and update it with the solution it finds.
+                  If ws is null then train() starts from scratch.
+        !*/
+
+        const trained_function_type train (
+            const std::vector<sample_sequence_type>& x,
+            const std::vector<segmented_sequence_type>& y
+        ) const
+        {
+            using namespace dlib;
+            DLIB_ASSERT(is_sequence_segmentation_problem(x,y) == true,
+                        "\t sequence_segmenter warm_start_segmentation_trainer::train(x,y)"
+                        << "\n\t invalid inputs were given to this function"
+                        << "\n\t x.size(): " << x.size()
+                        << "\n\t is_sequence_segmentation_problem(x,y): " << is_sequence_segmentation_problem(x,y)
+                        << "\n\t this: " << this
+            );
+
+            // This is the same labeling structural_sequence_segmentation_trainer uses.
+            std::vector<std::vector<unsigned long> > labels(y.size());
+            for (unsigned long i = 0; i < labels.size(); ++i)
+            {
+                labels[i].resize(x[i].size(), impl_ss::OUTSIDE);
+                for (unsigned long j = 0; j < y[i].size(); ++j)
+                {
+                    const unsigned long begin = y[i][j].first;
+                    const unsigned long end = y[i][j].second;
+                    if (begin == end)
+                        continue;
+
+                    if (feature_extractor::use_BIO_model)
+                    {
+                        labels[i][begin] = impl_ss::BEGIN;
+                        for (unsigned long k = begin+1; k < end; ++k)
+                            labels[i][k] = impl_ss::INSIDE;
+                    }
+                    else if (begin+1 == end)
+                    {
+                        labels[i][begin] = impl_ss::UNIT;
+                    }
+                    else
+                    {
+                        labels[i][begin] = impl_ss::BEGIN;
+                        for (unsigned long k = begin+1; k+1 < end; ++k)
+                            labels[i][k] = impl_ss::INSIDE;
+                        labels[i][end-1] = impl_ss::LAST;
+                    }
+                }
+            }
+
+            typedef impl_ss::feature_extractor<feature_extractor> ss_feature_extractor;
+            const ss_feature_extractor fe(settings.get_feature_extractor());
+            structural_svm_sequence_labeling_problem<ss_feature_extractor> prob(x, labels, fe, settings.get_num_threads());
+            prob.set_epsilon(settings.get_epsilon());
+            prob.set_max_iterations(settings.get_max_iterations());
+            prob.set_c(settings.get_c());
+            prob.set_max_cache_size(settings.get_max_cache_size());
+            const double missed = settings.get_loss_per_missed_segment();
+            const double false_alarm = settings.get_loss_per_false_alarm();
+            prob.set_loss(impl_ss::BEGIN, missed);
+            prob.set_loss(impl_ss::INSIDE, missed);
+            if (!feature_extractor::use_BIO_model)
+            {
+                prob.set_loss(impl_ss::LAST, missed);
+                prob.set_loss(impl_ss::UNIT, missed);
+            }
+            prob.set_loss(impl_ss::OUTSIDE, false_alarm);
+
+            matrix<double,0,1> weights;
+            warm_start_oca solver;
+            if (warm_start)
+            {
+                std::vector<double> risk_params;
+                risk_params.push_back(missed);
+                risk_params.push_back(false_alarm);
+                solver(prob, weights, num_nonnegative_weights(fe), *warm_start, risk_params);
+            }
+            else
+            {
+                solver(prob, weights, num_nonnegative_weights(fe));
+            }
+
+            return trained_function_type(weights, settings.get_feature_extractor());
+        }
+
+    private:
+        dlib::structural_sequence_segmentation_trainer<feature_extractor> settings;
+        warm_start_ptr warm_start;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MITIE_WARM_START_TRaINERS_H_
+
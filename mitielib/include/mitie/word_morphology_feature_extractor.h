@@ -20,7 +20,8 @@ namespace mitie
             THREAD SAFETY
                 Note that this object uses mutable internal scratch space.  Therefore, it is
                 unsafe for two threads to touch the same instance of this object at a time
-                without mutex locking it first.
+                without mutex locking it first.  The only exception is the version of
+                get_feature_vector() that takes a scratch argument.
         !*/
 
     public:
@@ -97,6 +98,26 @@ namespace mitie
             hits_to_vect(hits, feats);
         }
 
+        void get_feature_vector (
+            const std::string& word,
+            dlib::matrix<float,0,1>& feats,
+            std::vector<dlib::uint16>& scratch
+        ) const
+        /*!
+            requires
+                - get_num_dimensions() != 0
+            ensures
+                - This function is identical to the above get_feature_vector() routine
+                  except that it uses scratch as its working memory rather than memory
+                  inside this object.  Therefore, it is safe for multiple threads to call
+                  this function at the same time so long as they each use their own
+                  scratch vector.
+        !*/
+        {
+            substrings.find_substrings(word, scratch);
+            hits_to_vect(scratch, feats);
+        }
+
         friend void serialize (const word_morphology_feature_extractor& item, std::ostream& out)
         {
             int version = 1;
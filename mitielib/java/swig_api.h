@@ -21,7 +21,7 @@
 #include <sstream>
 #include <fstream>
 #include <dlib/error.h>
-#include <mitie/conll_tokenizer.h>
+#include <mitie/conll_span_tokenizer.h>
 #include <mitie/binary_relation_detector.h>
 #include <mitie/named_entity_extractor.h>
 #include <mitie/ner_trainer.h>
@@ -51,10 +51,9 @@ inline std::vector<std::string> tokenize (
 )
 {
     using namespace mitie;
-    std::istringstream sin(str);
-    // The conll_tokenizer splits the contents of an istream into a bunch of words and is
-    // MITIE's default tokenization method. 
-    conll_tokenizer tok(sin);
+    // The conll_span_tokenizer splits a string into a bunch of words and is MITIE's
+    // default tokenization method. 
+    conll_span_tokenizer tok(str.data(), str.size());
     std::vector<std::string> tokens;
     std::string token;
     // Read the tokens out of the file one at a time and store into tokens.
@@ -77,10 +76,9 @@ std::vector<TokenIndexPair> tokenizeWithOffsets (
 )
 {
     using namespace mitie;
-    std::istringstream sin(str);
-    // The conll_tokenizer splits the contents of an istream into a bunch of words and is
-    // MITIE's default tokenization method. 
-    conll_tokenizer tok(sin);
+    // The conll_span_tokenizer splits a string into a bunch of words and is MITIE's
+    // default tokenization method. 
+    conll_span_tokenizer tok(str.data(), str.size());
     std::vector<TokenIndexPair> tokens;
     TokenIndexPair p;
     // Read the tokens out of the file one at a time and store into tokens.
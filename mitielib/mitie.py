@@ -423,6 +423,130 @@ class binary_relation_detector:
 ####                          TRAINING API                                 ###
 ##############################################################################
 
+class _mitie_training_progress(ctypes.Structure):
+    _fields_ = [("phase", ctypes.c_char_p),
+                ("iteration", ctypes.c_ulong),
+                ("objective", ctypes.c_double),
+                ("best_objective", ctypes.c_double),
+                ("elapsed_seconds", ctypes.c_double),
+                ("eta_seconds", ctypes.c_double),
+                ("memory_usage", ctypes.c_ulonglong)]
+
+_mitie_training_progress_callback = ctypes.CFUNCTYPE(None, ctypes.POINTER(_mitie_training_progress), ctypes.c_void_p)
+
+_f.mitie_create_training_options.restype = ctypes.c_void_p
+_f.mitie_create_training_options.argtypes = ()
+
+_f.mitie_training_options_get_max_wall_time.restype = ctypes.c_double
+_f.mitie_training_options_get_max_wall_time.argtypes = ctypes.c_void_p,
+
+_f.mitie_training_options_set_max_wall_time.restype = None
+_f.mitie_training_options_set_max_wall_time.argtypes = ctypes.c_void_p, ctypes.c_double
+
+_f.mitie_training_options_get_max_search_evaluations.restype = ctypes.c_ulong
+_f.mitie_training_options_get_max_search_evaluations.argtypes = ctypes.c_void_p,
+
+_f.mitie_training_options_set_max_search_evaluations.restype = None
+_f.mitie_training_options_set_max_search_evaluations.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_training_options_get_early_stopping_patience.restype = ctypes.c_ulong
+_f.mitie_training_options_get_early_stopping_patience.argtypes = ctypes.c_void_p,
+
+_f.mitie_training_options_get_early_stopping_tolerance.restype = ctypes.c_double
+_f.mitie_training_options_get_early_stopping_tolerance.argtypes = ctypes.c_void_p,
+
+_f.mitie_training_options_set_early_stopping.restype = None
+_f.mitie_training_options_set_early_stopping.argtypes = ctypes.c_void_p, ctypes.c_ulong, ctypes.c_double
+
+_f.mitie_training_options_set_progress_callback.restype = None
+_f.mitie_training_options_set_progress_callback.argtypes = ctypes.c_void_p, _mitie_training_progress_callback, ctypes.c_void_p
+
+
+class training_progress:
+    """A progress report given to a training_options.progress_callback.  See
+    mitie_training_progress in mitie.h for what the fields mean."""
+    def __init__(self, p):
+        self.phase = to_default_str_type(p.phase)
+        self.iteration = p.iteration
+        self.objective = p.objective
+        self.best_objective = p.best_objective
+        self.elapsed_seconds = p.elapsed_seconds
+        self.eta_seconds = p.eta_seconds
+        self.memory_usage = p.memory_usage
+
+
+class training_options(object):
+    """Limits on how long the trainers spend on their parameter searches, along with
+    an optional function that gets called with a training_progress object as training
+    runs.  Give it to a trainer by assigning it to the trainer's training_options
+    property."""
+    def __init__(self):
+        self.__obj = _f.mitie_create_training_options()
+        self.__mitie_free = _f.mitie_free
+        self.__callback = None
+        self.__c_callback = None
+        if self.__obj is None:
+            raise Exception("Unable to create training_options.  Probably ran out of RAM.")
+
+    def __del__(self):
+        self.__mitie_free(self.__obj)
+
+    @property
+    def _obj(self):
+        return self.__obj
+
+    @property
+    def _c_callback(self):
+        return self.__c_callback
+
+    @property
+    def max_wall_time(self):
+        return _f.mitie_training_options_get_max_wall_time(self.__obj)
+
+    @max_wall_time.setter
+    def max_wall_time(self, value):
+        if value < 0:
+            raise Exception("Invalid max_wall_time value given.  It can't be negative.")
+        _f.mitie_training_options_set_max_wall_time(self.__obj, value)
+
+    @property
+    def max_search_evaluations(self):
+        return _f.mitie_training_options_get_max_search_evaluations(self.__obj)
+
+    @max_search_evaluations.setter
+    def max_search_evaluations(self, value):
+        _f.mitie_training_options_set_max_search_evaluations(self.__obj, value)
+
+    @property
+    def early_stopping_patience(self):
+        return _f.mitie_training_options_get_early_stopping_patience(self.__obj)
+
+    @property
+    def early_stopping_tolerance(self):
+        return _f.mitie_training_options_get_early_stopping_tolerance(self.__obj)
+
+    def set_early_stopping(self, patience, tolerance=0):
+        if tolerance < 0:
+            raise Exception("Invalid tolerance value given.  It can't be negative.")
+        _f.mitie_training_options_set_early_stopping(self.__obj, patience, tolerance)
+
+    @property
+    def progress_callback(self):
+        return self.__callback
+
+    @progress_callback.setter
+    def progress_callback(self, value):
+        if value is None:
+            # A CFUNCTYPE made without arguments is a NULL function pointer.
+            c_callback = _mitie_training_progress_callback()
+        else:
+            c_callback = _mitie_training_progress_callback(lambda p, context: value(training_progress(p.contents)))
+        _f.mitie_training_options_set_progress_callback(self.__obj, c_callback, None)
+        # The C side only has a pointer to c_callback so we need to keep it alive.
+        self.__callback = value
+        self.__c_callback = c_callback
+
+
 _f.mitie_add_ner_training_entity.restype = ctypes.c_int
 _f.mitie_add_ner_training_entity.argtypes = ctypes.c_void_p, ctypes.c_ulong, ctypes.c_ulong, ctypes.c_char_p
 
@@ -447,6 +571,9 @@ _f.mitie_ner_trainer_set_beta.argtypes = ctypes.c_void_p, ctypes.c_double
 _f.mitie_ner_trainer_set_num_threads.restype = None
 _f.mitie_ner_trainer_set_num_threads.argtypes = ctypes.c_void_p, ctypes.c_ulong
 
+_f.mitie_ner_trainer_set_training_options.restype = None
+_f.mitie_ner_trainer_set_training_options.argtypes = ctypes.c_void_p, ctypes.c_void_p
+
 _f.mitie_ner_trainer_size.restype = ctypes.c_ulong
 _f.mitie_ner_trainer_size.argtypes = ctypes.c_void_p,
 
@@ -507,6 +634,8 @@ class ner_trainer(object):
         filename = to_bytes(filename)
         self.__obj = _f.mitie_create_ner_trainer(filename)
         self.__mitie_free = _f.mitie_free
+        self.__training_options = None
+        self.__c_callback = None
         if self.__obj is None:
             raise Exception("Unable to create ner_trainer based on " + to_default_str_type(filename))
 
@@ -538,6 +667,19 @@ class ner_trainer(object):
     @num_threads.setter
     def num_threads(self, value):
         _f.mitie_ner_trainer_set_num_threads(self.__obj, value)
+
+    @property
+    def training_options(self):
+        return self.__training_options
+
+    @training_options.setter
+    def training_options(self, value):
+        _f.mitie_ner_trainer_set_training_options(self.__obj, value._obj)
+        # The trainer gets its own copy of the options, including the pointer to
+        # value's C callback as it is right now.  So keep that callback alive even if
+        # value.progress_callback is changed later.
+        self.__training_options = value
+        self.__c_callback = value._c_callback
     
     def train(self):
         if self.size == 0:
@@ -580,6 +722,9 @@ _f.mitie_binary_relation_trainer_set_beta.argtypes = ctypes.c_void_p, ctypes.c_d
 _f.mitie_binary_relation_trainer_set_num_threads.restype = None
 _f.mitie_binary_relation_trainer_set_num_threads.argtypes = ctypes.c_void_p, ctypes.c_ulong
 
+_f.mitie_binary_relation_trainer_set_training_options.restype = None
+_f.mitie_binary_relation_trainer_set_training_options.argtypes = ctypes.c_void_p, ctypes.c_void_p
+
 _f.mitie_train_binary_relation_detector.restype = ctypes.c_void_p
 _f.mitie_train_binary_relation_detector.argtypes = ctypes.c_void_p,
 
@@ -589,6 +734,8 @@ class binary_relation_detector_trainer(object):
         relation_name = to_bytes(relation_name)
         self.__obj = _f.mitie_create_binary_relation_trainer(relation_name, ner._obj)
         self.__mitie_free = _f.mitie_free
+        self.__training_options = None
+        self.__c_callback = None
         if self.__obj is None:
             raise Exception("Unable to create binary_relation_detector_trainer")
 
@@ -657,6 +804,19 @@ class binary_relation_detector_trainer(object):
     @num_threads.setter
     def num_threads(self, value):
         _f.mitie_binary_relation_trainer_set_num_threads(self.__obj, value)
+
+    @property
+    def training_options(self):
+        return self.__training_options
+
+    @training_options.setter
+    def training_options(self, value):
+        _f.mitie_binary_relation_trainer_set_training_options(self.__obj, value._obj)
+        # The trainer gets its own copy of the options, including the pointer to
+        # value's C callback as it is right now.  So keep that callback alive even if
+        # value.progress_callback is changed later.
+        self.__training_options = value
+        self.__c_callback = value._c_callback
     
     def train(self):
         if self.num_positive_examples == 0 or self.num_negative_examples == 0:
@@ -705,6 +865,9 @@ _f.mitie_text_categorizer_trainer_set_beta.argtypes = ctypes.c_void_p, ctypes.c_
 _f.mitie_text_categorizer_trainer_set_num_threads.restype = None
 _f.mitie_text_categorizer_trainer_set_num_threads.argtypes = ctypes.c_void_p, ctypes.c_ulong
 
+_f.mitie_text_categorizer_trainer_set_training_options.restype = None
+_f.mitie_text_categorizer_trainer_set_training_options.argtypes = ctypes.c_void_p, ctypes.c_void_p
+
 _f.mitie_text_categorizer_trainer_size.restype = ctypes.c_ulong
 _f.mitie_text_categorizer_trainer_size.argtypes = ctypes.c_void_p,
 
@@ -784,6 +947,8 @@ class text_categorizer_trainer(object):
         filename = to_bytes(filename)
         self.__obj = _f.mitie_create_text_categorizer_trainer(filename)
         self.__mitie_free = _f.mitie_free
+        self.__training_options = None
+        self.__c_callback = None
         if self.__obj is None:
             raise Exception("Unable to create text_categorizer_trainer based on " + to_default_str_type(filename))
 
@@ -818,6 +983,19 @@ class text_categorizer_trainer(object):
     def num_threads(self, value):
         _f.mitie_text_categorizer_trainer_set_num_threads(self.__obj, value)
 
+    @property
+    def training_options(self):
+        return self.__training_options
+
+    @training_options.setter
+    def training_options(self, value):
+        _f.mitie_text_categorizer_trainer_set_training_options(self.__obj, value._obj)
+        # The trainer gets its own copy of the options, including the pointer to
+        # value's C callback as it is right now.  So keep that callback alive even if
+        # value.progress_callback is changed later.
+        self.__training_options = value
+        self.__c_callback = value._c_callback
+
     def train(self):
         if self.size == 0:
             raise Exception("You can't call train() on an empty trainer.")
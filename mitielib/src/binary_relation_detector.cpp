@@ -118,19 +118,38 @@ namespace mitie
         DLIB_CASSERT(rel_arg1.first < rel_arg1.second && rel_arg1.second <= tokens.size(),"invalid inputs");
         DLIB_CASSERT(rel_arg2.first < rel_arg2.second && rel_arg2.second <= tokens.size(),"invalid inputs");
 
+        // Only the argument tokens need word vectors, so don't bother computing them for
+        // anything else.
+        std::vector<matrix<float,0,1> > token_feats(tokens.size());
+        for (unsigned long i = rel_arg1.first; i < rel_arg1.second; ++i)
+            tfe.get_feature_vector(tokens[i], token_feats[i]);
+        for (unsigned long i = rel_arg2.first; i < rel_arg2.second; ++i)
+            tfe.get_feature_vector(tokens[i], token_feats[i]);
+
+        return extract_binary_relation(tokens, token_feats, rel_arg1, rel_arg2, tfe);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    binary_relation extract_binary_relation (
+        const std::vector<std::string>& tokens,
+        const std::vector<matrix<float,0,1> >& token_feats,
+        const std::pair<unsigned long, unsigned long>& rel_arg1,
+        const std::pair<unsigned long, unsigned long>& rel_arg2,
+        const total_word_feature_extractor& tfe
+    )
+    {
+        DLIB_CASSERT(token_feats.size() == tokens.size(),"invalid inputs");
+        DLIB_CASSERT(rel_arg1.first < rel_arg1.second && rel_arg1.second <= tokens.size(),"invalid inputs");
+        DLIB_CASSERT(rel_arg2.first < rel_arg2.second && rel_arg2.second <= tokens.size(),"invalid inputs");
+
         // get dense word features for the two arguments.
-        matrix<float,0,1> arg1, arg2, temp;
+        matrix<float,0,1> arg1, arg2;
         for (unsigned long i = rel_arg1.first; i < rel_arg1.second; ++i)
-        {
-            tfe.get_feature_vector(tokens[i], temp);
-            arg1 += temp;
-        }
+            arg1 += token_feats[i];
         arg1 /= (rel_arg1.second-rel_arg1.first);
         for (unsigned long i = rel_arg2.first; i < rel_arg2.second; ++i)
-        {
-            tfe.get_feature_vector(tokens[i], temp);
-            arg2 += temp;
-        }
+            arg2 += token_feats[i];
         arg2 /= (rel_arg2.second-rel_arg2.first);
         // Put the dense vectors into the sparse format
         binary_relation rel;
@@ -3,6 +3,7 @@
 // Authors: Davis E. King (davis@dlib.net)
 
 #include <mitie/binary_relation_detector_trainer.h>
+#include <mitie/parallel_parameter_search.h>
 #include <dlib/svm_threaded.h>
 #include <dlib/optimization.h>
 
@@ -22,6 +23,7 @@ namespace mitie
         tfe(ner.get_total_word_feature_extractor()), 
         beta(0.1), 
         num_threads(4),
+        parallel_search(false),
         relation_name(relation_name_)
     {
     }
@@ -116,6 +118,25 @@ namespace mitie
         num_threads = num;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    bool binary_relation_detector_trainer::
+    get_parallel_search (
+    ) const
+    {
+        return parallel_search;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void binary_relation_detector_trainer::
+    set_parallel_search (
+        bool enabled
+    )
+    {
+        parallel_search = enabled;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     double binary_relation_detector_trainer::
@@ -136,6 +157,25 @@ namespace mitie
         beta = new_beta;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    const training_options& binary_relation_detector_trainer::
+    get_training_options (
+    ) const
+    {
+        return options;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void binary_relation_detector_trainer::
+    set_training_options (
+        const training_options& options_
+    )
+    {
+        options = options_;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class brdt_cv_objective
@@ -155,13 +195,17 @@ namespace mitie
             svm_c_linear_dcd_trainer<sparse_linear_kernel<sparse_vector_type> > trainer;
             trainer.set_c_class1(params(0));
             trainer.set_c_class2(params(1));
-            cout << "testing with params: " << trans(params);
             matrix<double> res = cross_validate_trainer_threaded(trainer, samples, labels, cv_folds, num_threads);
-            cout << "cv: "<< res;
 
             const double fscore = (1+beta*beta) * res(0)*res(1) / (beta*beta*res(1) + res(0));
 
-            cout << "fscore: "<< fscore << endl << endl;
+            // print with one write so output from concurrent evaluations doesn't get
+            // mixed up
+            std::ostringstream sout;
+            sout << "testing with params: " << trans(params);
+            sout << "cv: "<< res;
+            sout << "fscore: "<< fscore << endl << endl;
+            cout << sout.str() << flush;
             return fscore;
         }
 
@@ -180,6 +224,8 @@ namespace mitie
         DLIB_CASSERT(num_positive_examples() > 0, "Not enough training data given.");
         DLIB_CASSERT(num_negative_examples() > 0, "Not enough training data given.");
 
+        training_monitor monitor(options);
+
         std::vector<sparse_vector_type> samples;
         std::vector<double> labels;
 
@@ -197,7 +243,6 @@ namespace mitie
         randomize_samples(samples, labels);
 
         const int cv_folds = 6;
-        brdt_cv_objective obj(num_threads, cv_folds, beta, samples, labels);
 
         matrix<double,2,1> params;
         params = 5000.0/samples.size(), 5000.0/samples.size();
@@ -214,7 +259,34 @@ namespace mitie
             upper_params = log(upper_params);
             const double rho_begin = min(upper_params-lower_params)*0.15;
             const double rho_end = log(1.2/samples.size()) - log(1.0/samples.size());
-            find_max_bobyqa(obj, params, params.size()*2+1, lower_params, upper_params, rho_begin, rho_end, 200);
+            monitor.begin_search("classifier parameter search", 200);
+            unsigned long num_concurrent, threads_per_eval;
+            if (parallel_search && split_search_threads(num_threads, cv_folds, num_concurrent, threads_per_eval))
+            {
+                brdt_cv_objective obj(threads_per_eval, cv_folds, beta, samples, labels);
+                monitored_objective<brdt_cv_objective,matrix<double,2,1> > mobj(obj, monitor, false);
+                matrix<double,2,1> min_step;
+                min_step = rho_end, rho_end;
+                find_max_parallel_grid(mobj, params, lower_params, upper_params, min_step, num_concurrent,
+                                       monitor.get_max_evaluations(), &monitor);
+            }
+            else
+            {
+                brdt_cv_objective obj(num_threads, cv_folds, beta, samples, labels);
+                monitored_objective<brdt_cv_objective,matrix<double,2,1> > mobj(obj, monitor, true);
+                try
+                {
+                    // BOBYQA gets one more evaluation than the monitor allows so that
+                    // running out of evaluations keeps the best parameters found.
+                    find_max_bobyqa(mobj, params, params.size()*2+1, lower_params, upper_params, rho_begin, rho_end,
+                                    monitor.get_max_evaluations()+1);
+                }
+                catch (search_stopped&)
+                {
+                    // If nothing was evaluated params still holds the defaults.
+                    mobj.get_best(params);
+                }
+            }
         }
 
 
@@ -228,12 +300,16 @@ namespace mitie
         trainer.set_c_class2(params(1));
         cout << "using parameters of: " << trans(params);
         cout << "now doing training..." << endl;
+        monitor.begin_phase("classifier training");
         binary_relation_detector bd;
         bd.df = trainer.train(samples, labels);
         bd.relation_type = relation_name;
         bd.total_word_feature_extractor_fingerprint = tfe.get_fingerprint();
 
-        cout << "test on train: " << test_binary_decision_function(bd.df, samples, labels) << endl;
+        const matrix<double,1,2> res = test_binary_decision_function(bd.df, samples, labels);
+        cout << "test on train: " << res << endl;
+        // report the average of the accuracies on the positive and negative examples
+        monitor.end_phase(mean(res));
         return bd;
     }
 
@@ -0,0 +1,249 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/document_pipeline.h>
+#include <mitie/conll_span_tokenizer.h>
+#include <mitie/sentence_splitter.h>
+#include <algorithm>
+
+using namespace dlib;
+
+namespace mitie
+{
+    using namespace std;
+
+// ----------------------------------------------------------------------------------------
+
+    void document_analysis::
+    clear (
+    )
+    {
+        tokens.clear();
+        token_offsets.clear();
+        sentences.clear();
+        entity_ranges.clear();
+        entity_tags.clear();
+        entity_scores.clear();
+        relations.clear();
+        category_tags.clear();
+        category_scores.clear();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    document_pipeline::
+    document_pipeline (
+        const named_entity_extractor& ner_
+    ) : ner(&ner_), split_sentences(false)
+    {
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void document_pipeline::
+    add_binary_relation_detector (
+        const binary_relation_detector& detector
+    )
+    {
+        if (detector.total_word_feature_extractor_fingerprint != ner->get_total_word_feature_extractor().get_fingerprint())
+            throw dlib::error("Incompatible total_word_feature_extractor used with binary_relation_detector.");
+        detectors.push_back(&detector);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void document_pipeline::
+    add_text_categorizer (
+        const text_categorizer& categorizer
+    )
+    {
+        const total_word_feature_extractor& tfe = categorizer.get_total_word_feature_extractor();
+        const bool shares_feats = tfe.get_num_dimensions() != 0 &&
+            tfe.get_fingerprint() == ner->get_total_word_feature_extractor().get_fingerprint();
+
+        categorizers.push_back(&categorizer);
+        categorizer_shares_feats.push_back(shares_feats);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void document_pipeline::
+    process (
+        const std::string& text,
+        document_analysis& result
+    ) const
+    {
+        process(text.data(), text.size(), result);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void document_pipeline::
+    process (
+        const char* text,
+        unsigned long length,
+        document_analysis& result
+    ) const
+    {
+        result.clear();
+
+        std::vector<std::string> words;
+        std::vector<matrix<float,0,1> > doc_feats;
+        if (split_sentences)
+        {
+            sentence_splitter splitter(text, length);
+            std::vector<token_span> sentence;
+            while (splitter(sentence))
+            {
+                words.resize(sentence.size());
+                for (unsigned long i = 0; i < sentence.size(); ++i)
+                {
+                    assign_token(words[i], text, sentence[i]);
+                    result.token_offsets.push_back(sentence[i].begin);
+                }
+                process_sentence(words, result, doc_feats);
+            }
+        }
+        else
+        {
+            conll_span_tokenizer tok(text, length);
+            token_span span;
+            while (tok(span))
+            {
+                words.push_back(std::string());
+                assign_token(words.back(), text, span);
+                result.token_offsets.push_back(span.begin);
+            }
+            if (words.size() != 0)
+                process_sentence(words, result, doc_feats);
+        }
+
+        categorize(result, doc_feats);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void document_pipeline::
+    process (
+        const std::vector<std::string>& tokens,
+        document_analysis& result
+    ) const
+    {
+        result.clear();
+
+        std::vector<std::string> words(tokens);
+        std::vector<matrix<float,0,1> > doc_feats;
+        if (words.size() != 0)
+            process_sentence(words, result, doc_feats);
+
+        categorize(result, doc_feats);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void document_pipeline::
+    process_sentence (
+        std::vector<std::string>& words,
+        document_analysis& result,
+        std::vector<matrix<float,0,1> >& doc_feats
+    ) const
+    {
+        const total_word_feature_extractor& tfe = ner->get_total_word_feature_extractor();
+        const unsigned long token_offset = result.tokens.size();
+        const unsigned long entity_offset = result.entity_ranges.size();
+
+        // This is the only place the word vectors get computed.  Everything below reuses
+        // them.
+        std::vector<matrix<float,0,1> > feats = sentence_to_feats(tfe, words);
+
+        std::vector<std::pair<unsigned long, unsigned long> > ranges;
+        std::vector<unsigned long> tags;
+        std::vector<double> scores;
+        ner->predict(words, feats, ranges, tags, scores, tfe);
+
+        // Check each pair of neighboring entities, in both argument orders, for each
+        // kind of relation.
+        if (detectors.size() != 0)
+        {
+            for (unsigned long i = 0; i+1 < ranges.size(); ++i)
+            {
+                const binary_relation forward = extract_binary_relation(words, feats,
+                    ranges[i], ranges[i+1], tfe);
+                const binary_relation backward = extract_binary_relation(words, feats,
+                    ranges[i+1], ranges[i], tfe);
+
+                for (unsigned long d = 0; d < detectors.size(); ++d)
+                {
+                    relation_mention rel;
+                    rel.detector = d;
+
+                    rel.score = (*detectors[d])(forward);
+                    if (rel.score > 0)
+                    {
+                        rel.arg1 = entity_offset + i;
+                        rel.arg2 = entity_offset + i+1;
+                        result.relations.push_back(rel);
+                    }
+
+                    rel.score = (*detectors[d])(backward);
+                    if (rel.score > 0)
+                    {
+                        rel.arg1 = entity_offset + i+1;
+                        rel.arg2 = entity_offset + i;
+                        result.relations.push_back(rel);
+                    }
+                }
+            }
+        }
+
+        for (unsigned long i = 0; i < ranges.size(); ++i)
+        {
+            result.entity_ranges.push_back(std::make_pair(ranges[i].first + token_offset,
+                                                          ranges[i].second + token_offset));
+            result.entity_tags.push_back(tags[i]);
+            result.entity_scores.push_back(scores[i]);
+        }
+
+        result.sentences.push_back(std::make_pair(token_offset, token_offset + words.size()));
+
+        // Move the tokens, and the word vectors if anyone is going to need them, into the
+        // document wide arrays.  Swapping avoids copying each string and vector.
+        const bool keep_feats = std::find(categorizer_shares_feats.begin(),
+                                          categorizer_shares_feats.end(), true) != categorizer_shares_feats.end();
+        result.tokens.resize(token_offset + words.size());
+        if (keep_feats)
+            doc_feats.resize(token_offset + words.size());
+        for (unsigned long i = 0; i < words.size(); ++i)
+        {
+            result.tokens[token_offset + i].swap(words[i]);
+            if (keep_feats)
+                doc_feats[token_offset + i].swap(feats[i]);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void document_pipeline::
+    categorize (
+        document_analysis& result,
+        const std::vector<matrix<float,0,1> >& doc_feats
+    ) const
+    {
+        const total_word_feature_extractor& tfe = ner->get_total_word_feature_extractor();
+
+        result.category_tags.resize(categorizers.size());
+        result.category_scores.resize(categorizers.size());
+        for (unsigned long i = 0; i < categorizers.size(); ++i)
+        {
+            if (categorizer_shares_feats[i])
+                categorizers[i]->predict(result.tokens, doc_feats, result.category_tags[i], result.category_scores[i], tfe);
+            else
+                categorizers[i]->predict(result.tokens, result.category_tags[i], result.category_scores[i]);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
@@ -0,0 +1,84 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/mapped_file.h>
+#include <dlib/error.h>
+#include <dlib/vectorstream.h>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    mapped_file::
+    mapped_file (
+        const std::string& filename
+    ) : ptr(0), length(0), mapped(false)
+    {
+#ifndef _WIN32
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw dlib::error("Unable to open file " + filename);
+
+        // Only regular files can be mapped.  Things like /proc files also report a size
+        // of 0 even though they have contents, so those get read the normal way too.
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        {
+            // On a 32 bit system the file can be bigger than the address space.
+            if (static_cast<dlib::uint64>(info.st_size) > static_cast<size_t>(-1))
+            {
+                close(fd);
+                throw dlib::error("File is too big to map into memory: " + filename);
+            }
+
+            void* p = mmap(0, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                posix_madvise(p, static_cast<size_t>(info.st_size), POSIX_MADV_SEQUENTIAL);
+                ptr = static_cast<const char*>(p);
+                length = info.st_size;
+                mapped = true;
+                close(fd);
+                return;
+            }
+        }
+        close(fd);
+#endif
+
+        std::ifstream fin(filename.c_str(), std::ios::binary);
+        if (!fin)
+            throw dlib::error("Unable to open file " + filename);
+        dlib::vectorstream out(buf);
+        out << fin.rdbuf();
+
+        ptr = buf.size() != 0 ? &buf[0] : 0;
+        length = buf.size();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mapped_file::
+    ~mapped_file (
+    )
+    {
+#ifndef _WIN32
+        if (mapped)
+            munmap(const_cast<char*>(ptr), static_cast<size_t>(length));
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
@@ -9,16 +9,20 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <limits>
 #include <assert.h>
 #include <dlib/vectorstream.h>
 #include <mitie/named_entity_extractor.h>
-#include <mitie/conll_tokenizer.h>
+#include <mitie/conll_span_tokenizer.h>
 #include <mitie/binary_relation_detector.h>
 #include <mitie/ner_trainer.h>
 #include <mitie/binary_relation_detector_trainer.h>
 #include <mitie/text_categorizer.h>
 #include <mitie/text_categorizer_trainer.h>
 #include <mitie/total_word_feature_extractor.h>
+#include <mitie/document_pipeline.h>
+#include <mitie/mapped_file.h>
+#include <mitie/training_options.h>
 
 using namespace mitie;
 
@@ -46,7 +50,11 @@ namespace
         MITIE_NER_TRAINER,
         MITIE_TEXT_CATEGORIZER,
         MITIE_TEXT_CATEGORIZER_TRAINER,
-        MITIE_TOTAL_WORD_FEATURE_EXTRACTOR       
+        MITIE_TOTAL_WORD_FEATURE_EXTRACTOR,
+        MITIE_DOCUMENT_PIPELINE,
+        MITIE_DOCUMENT_ANALYSIS,
+        MITIE_MAPPED_DOCUMENT,
+        MITIE_TRAINING_OPTIONS
     };
 
     template <typename T>
@@ -63,6 +71,10 @@ namespace
     template <> struct allocatable_types<text_categorizer>              { const static mitie_object_type type = MITIE_TEXT_CATEGORIZER; };
     template <> struct allocatable_types<text_categorizer_trainer>      { const static mitie_object_type type = MITIE_TEXT_CATEGORIZER_TRAINER; };
     template <> struct allocatable_types<total_word_feature_extractor>      { const static mitie_object_type type = MITIE_TOTAL_WORD_FEATURE_EXTRACTOR; };
+    template <> struct allocatable_types<document_pipeline>             { const static mitie_object_type type = MITIE_DOCUMENT_PIPELINE; };
+    template <> struct allocatable_types<mitie_document_analysis>       { const static mitie_object_type type = MITIE_DOCUMENT_ANALYSIS; };
+    template <> struct allocatable_types<mitie_mapped_document>         { const static mitie_object_type type = MITIE_MAPPED_DOCUMENT; };
+    template <> struct allocatable_types<training_options>              { const static mitie_object_type type = MITIE_TRAINING_OPTIONS; };
 
 
 // ----------------------------------------------------------------------------------------
@@ -246,18 +258,15 @@ extern "C"
     {
         try
         {
-            ifstream fin(filename);
-            if (!fin)
-                return 0;
-            std::vector<char> buf;
-            dlib::vectorstream out(buf);
-            out << fin.rdbuf();
+            mapped_file file(filename);
 
-            char* final_buf = (char*)allocate_bytes(buf.size()+1);
+            const size_t size = static_cast<size_t>(file.size());
+            char* final_buf = (char*)allocate_bytes(size+1);
             if (!final_buf)
                 return 0;
-            memcpy(final_buf, &buf[0], buf.size());
-            final_buf[buf.size()] = '\0';
+            if (size != 0)
+                memcpy(final_buf, file.data(), size);
+            final_buf[size] = '\0';
             return final_buf;
         }
         catch (...)
@@ -266,6 +275,63 @@ extern "C"
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    struct mitie_mapped_document
+    {
+        explicit mitie_mapped_document(const std::string& filename) : file(filename)
+        {
+            // The rest of the API describes the contents with unsigned long lengths,
+            // which are only 32 bits on some platforms.
+            if (file.size() > std::numeric_limits<unsigned long>::max())
+                throw dlib::error("File is too big to process: " + filename);
+        }
+        mapped_file file;
+    };
+
+    mitie_mapped_document* mitie_open_mapped_document (
+        const char* filename
+    )
+    {
+        assert(filename);
+        try
+        {
+            return allocate<mitie_mapped_document>(std::string(filename));
+        }
+        catch(std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << "Error opening file: " << e.what() << endl;
+#endif
+            return NULL;
+        }
+        catch(...)
+        {
+            return NULL;
+        }
+    }
+
+    const char* mitie_mapped_document_text (
+        const mitie_mapped_document* doc
+    )
+    {
+        return checked_cast<mitie_mapped_document>(doc).file.data();
+    }
+
+    unsigned long mitie_mapped_document_length (
+        const mitie_mapped_document* doc
+    )
+    {
+        return static_cast<unsigned long>(checked_cast<mitie_mapped_document>(doc).file.size());
+    }
+
+    int mitie_mapped_document_is_memory_mapped (
+        const mitie_mapped_document* doc
+    )
+    {
+        return checked_cast<mitie_mapped_document>(doc).file.is_memory_mapped() ? 1 : 0;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     static char** std_vector_to_double_ptr (
@@ -305,8 +371,7 @@ extern "C"
         try
         {
             // first tokenize the text
-            istringstream sin(text);
-            conll_tokenizer tok(sin);
+            conll_span_tokenizer tok(text);
             std::vector<std::string> words;
             string word;
             while(tok(word))
@@ -333,8 +398,7 @@ extern "C"
         try
         {
             // first tokenize the text
-            istringstream sin(text);
-            conll_tokenizer tok(sin);
+            conll_span_tokenizer tok(text);
             std::vector<std::string> words;
             std::vector<unsigned long> offsets;
             string word;
@@ -360,19 +424,84 @@ extern "C"
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_tokenize_spans (
+        const char* text,
+        unsigned long text_length,
+        unsigned long* spans,
+        unsigned long max_tokens
+    )
+    {
+        assert(text || text_length == 0);
+        assert(spans || max_tokens == 0);
+
+        conll_span_tokenizer tok(text, text_length);
+        token_span span;
+        unsigned long num_tokens = 0;
+        while (tok(span))
+        {
+            if (num_tokens < max_tokens)
+            {
+                spans[2*num_tokens]   = span.begin;
+                spans[2*num_tokens+1] = span.end;
+            }
+            ++num_tokens;
+        }
+        return num_tokens;
+    }
+
+    static void spans_to_std_vector (
+        const char* text,
+        const unsigned long* spans,
+        unsigned long num_tokens,
+        std::vector<std::string>& words
+    )
+    {
+        words.resize(num_tokens);
+        for (unsigned long i = 0; i < num_tokens; ++i)
+        {
+            token_span span;
+            span.begin = spans[2*i];
+            span.end = spans[2*i+1];
+            if (i == 0)
+                span.utf8_apostrophe = false;
+            else
+                span.utf8_apostrophe = is_split_utf8_apostrophe(text, spans[2*i-2], spans[2*i-1], span.begin, span.end);
+            assign_token(words[i], text, span);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     char** mitie_tokenize_file (
         const char* filename
     )
     {
-        char* text = mitie_load_entire_file(filename);
-        if (!text)
-            return 0;
+        try
+        {
+            mapped_file file(filename);
+            const size_t size = static_cast<size_t>(file.size());
+
+            // mitie_tokenize() stops at the first NULL so we do too.
+            const char* end = size != 0 ? (const char*)memchr(file.data(), '\0', size) : 0;
+            const size_t text_length = end ? end - file.data() : size;
+            if (text_length > std::numeric_limits<unsigned long>::max())
+                return NULL;
+            const unsigned long length = static_cast<unsigned long>(text_length);
+
+            conll_span_tokenizer tok(file.data(), length);
+            std::vector<std::string> words;
+            string word;
+            while(tok(word))
+                words.push_back(word);
 
-        char** tokens = mitie_tokenize(text);
-        mitie_free(text);
-        return tokens;
+            return std_vector_to_double_ptr(words);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
     }
 
 // ----------------------------------------------------------------------------------------
@@ -385,6 +514,11 @@ extern "C"
         std::vector<std::string> tags;
     };
 
+    struct mitie_document_analysis
+    {
+        document_analysis analysis;
+    };
+
 
     void mitie_free (
         void* object 
@@ -428,6 +562,18 @@ extern "C"
             case MITIE_TOTAL_WORD_FEATURE_EXTRACTOR:
                 destroy<total_word_feature_extractor>(object);
                 break; 
+            case MITIE_DOCUMENT_PIPELINE:
+                destroy<document_pipeline>(object);
+                break;
+            case MITIE_DOCUMENT_ANALYSIS:
+                destroy<mitie_document_analysis>(object);
+                break;
+            case MITIE_MAPPED_DOCUMENT:
+                destroy<mitie_mapped_document>(object);
+                break;
+            case MITIE_TRAINING_OPTIONS:
+                destroy<training_options>(object);
+                break;
             default:
                 std::cerr << "ERROR, mitie_free() called on non-MITIE object or called twice." << std::endl;
                 assert(false);
@@ -636,6 +782,37 @@ extern "C"
         }
     }
 
+    mitie_named_entity_detections* mitie_extract_entities_from_spans (
+        const mitie_named_entity_extractor* ner_,
+        const char* text,
+        const unsigned long* spans,
+        unsigned long num_tokens
+    )
+    {
+        const named_entity_extractor& ner = checked_cast<named_entity_extractor>(ner_);
+        assert(text);
+        assert(spans || num_tokens == 0);
+
+        mitie_named_entity_detections* impl = 0;
+
+        try
+        {
+            impl = allocate<mitie_named_entity_detections>();
+
+            std::vector<std::string> words;
+            spans_to_std_vector(text, spans, num_tokens, words);
+
+            ner.predict(words, impl->ranges, impl->predicted_labels, impl->predicted_scores);
+            impl->tags = ner.get_tag_name_strings();
+            return impl;
+        }
+        catch(...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
     unsigned long mitie_ner_get_num_detections (
         const mitie_named_entity_detections* dets
     )
@@ -1042,6 +1219,373 @@ extern "C"
          }
      }
 
+     int mitie_categorize_text_from_spans (
+         const mitie_text_categorizer* tcat_,
+         const char* text,
+         const unsigned long* spans,
+         unsigned long num_tokens,
+         char** text_tag,
+         double* text_score
+     )
+     {
+         try
+         {
+             assert(text);
+             assert(spans || num_tokens == 0);
+             assert(text_tag);
+             assert(text_score);
+
+             string tag;
+             double score;
+             std::vector<std::string> words;
+             spans_to_std_vector(text, spans, num_tokens, words);
+
+             checked_cast<text_categorizer>(tcat_).predict(words,tag,score);
+
+             char * writable = (char*)allocate_bytes(tag.size()+1);
+             std::copy(tag.begin(), tag.end(), writable);
+             writable[tag.size()] = '\0';
+
+             *text_tag = writable;
+             *text_score = score;
+
+             return 0;
+         }
+         catch (...)
+         {
+#ifndef NDEBUG
+             cerr << "Error categorizing text: " << endl;
+#endif
+             return 1;
+         }
+     }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_document_pipeline* mitie_create_document_pipeline (
+        const mitie_named_entity_extractor* ner_
+    )
+    {
+        const named_entity_extractor& ner = checked_cast<named_entity_extractor>(ner_);
+
+        document_pipeline* impl = 0;
+        try
+        {
+            impl = allocate<document_pipeline>(ner);
+            return (mitie_document_pipeline*)impl;
+        }
+        catch(std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << e.what() << endl;
+#endif
+            mitie_free(impl);
+            return NULL;
+        }
+        catch(...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
+    int mitie_document_pipeline_add_binary_relation_detector (
+        mitie_document_pipeline* pipeline_,
+        const mitie_binary_relation_detector* detector_
+    )
+    {
+        document_pipeline& pipeline = checked_cast<document_pipeline>(pipeline_);
+        const binary_relation_detector& detector = checked_cast<binary_relation_detector>(detector_);
+
+        try
+        {
+            pipeline.add_binary_relation_detector(detector);
+            return 0;
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << e.what() << endl;
+#endif
+            return 1;
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
+    int mitie_document_pipeline_add_text_categorizer (
+        mitie_document_pipeline* pipeline_,
+        const mitie_text_categorizer* tcat_
+    )
+    {
+        document_pipeline& pipeline = checked_cast<document_pipeline>(pipeline_);
+        const text_categorizer& tcat = checked_cast<text_categorizer>(tcat_);
+
+        try
+        {
+            pipeline.add_text_categorizer(tcat);
+            return 0;
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << e.what() << endl;
+#endif
+            return 1;
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
+    unsigned long mitie_document_pipeline_num_binary_relation_detectors (
+        const mitie_document_pipeline* pipeline_
+    )
+    {
+        return checked_cast<document_pipeline>(pipeline_).num_binary_relation_detectors();
+    }
+
+    unsigned long mitie_document_pipeline_num_text_categorizers (
+        const mitie_document_pipeline* pipeline_
+    )
+    {
+        return checked_cast<document_pipeline>(pipeline_).num_text_categorizers();
+    }
+
+    void mitie_document_pipeline_set_sentence_splitting (
+        mitie_document_pipeline* pipeline,
+        int enabled
+    )
+    {
+        checked_cast<document_pipeline>(pipeline).set_sentence_splitting(enabled != 0);
+    }
+
+    mitie_document_analysis* mitie_process_document (
+        const mitie_document_pipeline* pipeline_,
+        const char* text
+    )
+    {
+        const document_pipeline& pipeline = checked_cast<document_pipeline>(pipeline_);
+        assert(text);
+
+        mitie_document_analysis* impl = 0;
+        try
+        {
+            impl = allocate<mitie_document_analysis>();
+            pipeline.process(text, impl->analysis);
+            return impl;
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << e.what() << endl;
+#endif
+            mitie_free(impl);
+            return NULL;
+        }
+        catch (...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
+    mitie_document_analysis* mitie_process_mapped_document (
+        const mitie_document_pipeline* pipeline_,
+        const mitie_mapped_document* doc_
+    )
+    {
+        const document_pipeline& pipeline = checked_cast<document_pipeline>(pipeline_);
+        const mapped_file& file = checked_cast<mitie_mapped_document>(doc_).file;
+
+        mitie_document_analysis* impl = 0;
+        try
+        {
+            impl = allocate<mitie_document_analysis>();
+            pipeline.process(file.data(), static_cast<unsigned long>(file.size()), impl->analysis);
+            return impl;
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << e.what() << endl;
+#endif
+            mitie_free(impl);
+            return NULL;
+        }
+        catch (...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
+    unsigned long mitie_document_num_tokens (
+        const mitie_document_analysis* doc
+    )
+    {
+        return checked_cast<mitie_document_analysis>(doc).analysis.tokens.size();
+    }
+
+    const char* mitie_document_get_token (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_tokens(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.tokens[idx].c_str();
+    }
+
+    unsigned long mitie_document_get_token_offset (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_tokens(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.token_offsets[idx];
+    }
+
+    unsigned long mitie_document_num_sentences (
+        const mitie_document_analysis* doc
+    )
+    {
+        return checked_cast<mitie_document_analysis>(doc).analysis.sentences.size();
+    }
+
+    unsigned long mitie_document_get_sentence_position (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_sentences(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.sentences[idx].first;
+    }
+
+    unsigned long mitie_document_get_sentence_length (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_sentences(doc));
+        const document_analysis& analysis = checked_cast<mitie_document_analysis>(doc).analysis;
+        return analysis.sentences[idx].second - analysis.sentences[idx].first;
+    }
+
+    unsigned long mitie_document_num_entities (
+        const mitie_document_analysis* doc
+    )
+    {
+        return checked_cast<mitie_document_analysis>(doc).analysis.entity_ranges.size();
+    }
+
+    unsigned long mitie_document_get_entity_position (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_entities(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.entity_ranges[idx].first;
+    }
+
+    unsigned long mitie_document_get_entity_length (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_entities(doc));
+        const document_analysis& analysis = checked_cast<mitie_document_analysis>(doc).analysis;
+        return analysis.entity_ranges[idx].second - analysis.entity_ranges[idx].first;
+    }
+
+    unsigned long mitie_document_get_entity_tag (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_entities(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.entity_tags[idx];
+    }
+
+    double mitie_document_get_entity_score (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_entities(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.entity_scores[idx];
+    }
+
+    unsigned long mitie_document_num_relations (
+        const mitie_document_analysis* doc
+    )
+    {
+        return checked_cast<mitie_document_analysis>(doc).analysis.relations.size();
+    }
+
+    unsigned long mitie_document_get_relation_arg1 (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_relations(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.relations[idx].arg1;
+    }
+
+    unsigned long mitie_document_get_relation_arg2 (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_relations(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.relations[idx].arg2;
+    }
+
+    unsigned long mitie_document_get_relation_detector (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_relations(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.relations[idx].detector;
+    }
+
+    double mitie_document_get_relation_score (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_relations(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.relations[idx].score;
+    }
+
+    unsigned long mitie_document_num_categories (
+        const mitie_document_analysis* doc
+    )
+    {
+        return checked_cast<mitie_document_analysis>(doc).analysis.category_tags.size();
+    }
+
+    const char* mitie_document_get_category_tag (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_categories(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.category_tags[idx].c_str();
+    }
+
+    double mitie_document_get_category_score (
+        const mitie_document_analysis* doc,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_document_num_categories(doc));
+        return checked_cast<mitie_document_analysis>(doc).analysis.category_scores[idx];
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 //                                      TRAINING ROUTINES
@@ -1290,6 +1834,140 @@ extern "C"
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        class c_progress_callback : public training_progress_callback
+        {
+            /*!
+                This adapts a mitie_training_progress_callback and its context pointer to
+                the C++ training_progress_callback interface.
+            !*/
+        public:
+            c_progress_callback (
+                mitie_training_progress_callback callback_,
+                void* context_
+            ) : callback(callback_), context(context_) {}
+
+            virtual void operator() (
+                const training_progress& p
+            )
+            {
+                mitie_training_progress temp;
+                temp.phase = p.phase.c_str();
+                temp.iteration = p.iteration;
+                temp.objective = p.objective;
+                temp.best_objective = p.best_objective;
+                temp.elapsed_seconds = p.elapsed_seconds;
+                temp.eta_seconds = p.eta_seconds;
+                temp.memory_usage = p.memory_usage;
+                callback(&temp, context);
+            }
+
+        private:
+            mitie_training_progress_callback callback;
+            void* context;
+        };
+    }
+
+    mitie_training_options* mitie_create_training_options (
+    )
+    {
+        try
+        {
+            return (mitie_training_options*)allocate<training_options>();
+        }
+        catch(...)
+        {
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mitie_training_options_set_max_wall_time (
+        mitie_training_options* options_,
+        double seconds
+    )
+    {
+        assert(seconds >= 0);
+        checked_cast<training_options>(options_).set_max_wall_time(seconds);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double mitie_training_options_get_max_wall_time (
+        const mitie_training_options* options_
+    )
+    {
+        return checked_cast<training_options>(options_).get_max_wall_time();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mitie_training_options_set_max_search_evaluations (
+        mitie_training_options* options_,
+        unsigned long num
+    )
+    {
+        checked_cast<training_options>(options_).set_max_search_evaluations(num);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_training_options_get_max_search_evaluations (
+        const mitie_training_options* options_
+    )
+    {
+        return checked_cast<training_options>(options_).get_max_search_evaluations();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mitie_training_options_set_early_stopping (
+        mitie_training_options* options_,
+        unsigned long patience,
+        double tolerance
+    )
+    {
+        assert(tolerance >= 0);
+        checked_cast<training_options>(options_).set_early_stopping(patience, tolerance);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_training_options_get_early_stopping_patience (
+        const mitie_training_options* options_
+    )
+    {
+        return checked_cast<training_options>(options_).get_early_stopping_patience();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double mitie_training_options_get_early_stopping_tolerance (
+        const mitie_training_options* options_
+    )
+    {
+        return checked_cast<training_options>(options_).get_early_stopping_tolerance();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mitie_training_options_set_progress_callback (
+        mitie_training_options* options_,
+        mitie_training_progress_callback callback,
+        void* context
+    )
+    {
+        training_options& options = checked_cast<training_options>(options_);
+        if (callback)
+            options.set_progress_callback(dlib::shared_ptr<training_progress_callback>(new c_progress_callback(callback, context)));
+        else
+            options.set_progress_callback(dlib::shared_ptr<training_progress_callback>());
+    }
+
 // ----------------------------------------------------------------------------------------
 
     mitie_ner_trainer* mitie_create_ner_trainer (
@@ -1376,6 +2054,16 @@ extern "C"
         return checked_cast<ner_trainer>(trainer_).get_num_threads();
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void mitie_ner_trainer_set_training_options (
+        mitie_ner_trainer* trainer_,
+        const mitie_training_options* options
+    )
+    {
+        checked_cast<ner_trainer>(trainer_).set_training_options(checked_cast<training_options>(options));
+    }
+
 // ----------------------------------------------------------------------------------------
 
     mitie_named_entity_extractor* mitie_train_named_entity_extractor (
@@ -1531,6 +2219,16 @@ extern "C"
         return checked_cast<binary_relation_detector_trainer>(trainer_).get_num_threads();
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void mitie_binary_relation_trainer_set_training_options (
+        mitie_binary_relation_trainer* trainer_,
+        const mitie_training_options* options
+    )
+    {
+        checked_cast<binary_relation_detector_trainer>(trainer_).set_training_options(checked_cast<training_options>(options));
+    }
+
 // ----------------------------------------------------------------------------------------
 
     mitie_binary_relation_detector* mitie_train_binary_relation_detector (
@@ -1640,6 +2338,16 @@ extern "C"
         return checked_cast<text_categorizer_trainer>(trainer_).get_num_threads();
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void mitie_text_categorizer_trainer_set_training_options (
+        mitie_text_categorizer_trainer* trainer_,
+        const mitie_training_options* options
+    )
+    {
+        checked_cast<text_categorizer_trainer>(trainer_).set_training_options(checked_cast<training_options>(options));
+    }
+
 // ----------------------------------------------------------------------------------------
 
   mitie_text_categorizer* mitie_train_text_categorizer (
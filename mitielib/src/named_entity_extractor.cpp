@@ -145,6 +145,26 @@ namespace mitie
                     "Feature extractor must be same as the one used for training the model");
         }
         const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(fe, sentence);
+        predict(sentence, sent, chunks, chunk_tags, chunk_scores, fe);
+    }
+
+    void named_entity_extractor::
+    predict (
+        const std::vector<std::string>& sentence,
+        const std::vector<matrix<float,0,1> >& sent,
+        std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+        std::vector<unsigned long>& chunk_tags,
+        std::vector<double>& chunk_scores,
+        const total_word_feature_extractor& fe
+    ) const
+    {
+        if(pure_model_version != pure_model_version_0 && this->tfe_fingerprint != fe.get_fingerprint())
+        {
+            throw dlib::error(
+                    "Fingerprint mismatch. "
+                    "Feature extractor must be same as the one used for training the model");
+        }
+        DLIB_CASSERT(sent.size() == sentence.size(), "sentence_feats must contain one vector per token.");
         segmenter.segment_sequence(sent, chunks);
 
 
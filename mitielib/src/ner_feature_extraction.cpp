@@ -22,6 +22,19 @@ namespace mitie
         return temp;
     }
 
+    std::vector<matrix<float,0,1> > sentence_to_feats (
+        const total_word_feature_extractor& fe,
+        const std::vector<std::string>& sentence,
+        std::vector<dlib::uint16>& scratch
+    )
+    {
+        std::vector<matrix<float,0,1> > temp;
+        temp.resize(sentence.size());
+        for (unsigned long i = 0; i < sentence.size(); ++i)
+            fe.get_feature_vector(sentence[i], temp[i], scratch);
+        return temp;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     inline std::pair<uint64,uint64> prefix ( 
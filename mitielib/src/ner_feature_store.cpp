@@ -0,0 +1,164 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/ner_feature_store.h>
+#include <mitie/ner_feature_extraction.h>
+#include <dlib/threads.h>
+#include <dlib/error.h>
+#include <cstdio>
+#include <fstream>
+
+using namespace dlib;
+
+namespace mitie
+{
+    using namespace std;
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        class sentence_feature_filler
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the function object given to parallel_for_blocked() to fill
+                    in the features for a range of sentences.  The features of sentence i
+                    are written to dest + (offsets[i]-offsets[first_sentence])*num_dims.
+            !*/
+        public:
+            sentence_feature_filler (
+                const total_word_feature_extractor& fe_,
+                const ner_training_corpus& sentences_,
+                const std::vector<dlib::uint64>& offsets_,
+                unsigned long first_sentence_,
+                float* dest_
+            ) : fe(fe_), sentences(sentences_), offsets(offsets_), first_sentence(first_sentence_),
+                dest(dest_), num_dims(fe_.get_num_dimensions()) {}
+
+            void fill (
+                long begin,
+                long end
+            )
+            {
+                // each block gets its own scratch space so the threads can share fe.
+                std::vector<dlib::uint16> scratch;
+                std::vector<std::string> tokens;
+                for (long i = begin; i < end; ++i)
+                {
+                    sentences.get_tokens(i, tokens);
+                    const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(fe, tokens, scratch);
+                    float* out = dest + (offsets[i]-offsets[first_sentence])*num_dims;
+                    for (unsigned long j = 0; j < sent.size(); ++j)
+                    {
+                        for (unsigned long k = 0; k < num_dims; ++k)
+                            *out++ = sent[j](k);
+                    }
+                }
+            }
+
+        private:
+            const total_word_feature_extractor& fe;
+            const ner_training_corpus& sentences;
+            const std::vector<dlib::uint64>& offsets;
+            const unsigned long first_sentence;
+            float* const dest;
+            const unsigned long num_dims;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    ner_feature_store::
+    ner_feature_store (
+        const total_word_feature_extractor& fe,
+        const ner_training_corpus& sentences,
+        unsigned long num_threads,
+        const std::string& cache_filename
+    ) : num_dims(fe.get_num_dimensions()), filename(cache_filename), feats(0)
+    {
+        DLIB_CASSERT(num_threads > 0, "Invalid inputs were given to this function");
+
+        offsets.resize(sentences.size()+1);
+        offsets[0] = 0;
+        for (unsigned long i = 0; i < sentences.size(); ++i)
+            offsets[i+1] = offsets[i] + sentences.num_tokens(i);
+
+        if (filename.size() == 0)
+        {
+            mem.resize(offsets.back()*num_dims);
+            if (mem.size() != 0)
+                feats = &mem[0];
+            sentence_feature_filler filler(fe, sentences, offsets, 0, mem.size() != 0 ? &mem[0] : 0);
+            parallel_for_blocked(num_threads, 0, (long)sentences.size(), filler, &sentence_feature_filler::fill);
+            return;
+        }
+
+        // Write the features to disk a batch of sentences at a time so we never need
+        // RAM for more than one batch.
+        ofstream fout(filename.c_str(), ios::binary);
+        if (!fout)
+            throw dlib::error("Unable to create feature cache file " + filename);
+        const dlib::uint64 max_batch_floats = 16*1024*1024;
+        std::vector<float> buf;
+        unsigned long begin = 0;
+        while (begin < sentences.size())
+        {
+            unsigned long end = begin+1;
+            while (end < sentences.size() && (offsets[end+1]-offsets[begin])*num_dims <= max_batch_floats)
+                ++end;
+
+            buf.resize((offsets[end]-offsets[begin])*num_dims);
+            sentence_feature_filler filler(fe, sentences, offsets, begin, buf.size() != 0 ? &buf[0] : 0);
+            parallel_for_blocked(num_threads, (long)begin, (long)end, filler, &sentence_feature_filler::fill);
+            fout.write((const char*)(buf.size() != 0 ? &buf[0] : 0), buf.size()*sizeof(float));
+            begin = end;
+        }
+        fout.close();
+        if (!fout)
+        {
+            std::remove(filename.c_str());
+            throw dlib::error("Error while writing feature cache file " + filename);
+        }
+
+        file.reset(new mapped_file(filename));
+        feats = reinterpret_cast<const float*>(file->data());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    ner_feature_store::
+    ~ner_feature_store (
+    )
+    {
+        if (file)
+        {
+            file.reset();
+            std::remove(filename.c_str());
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_feature_store::
+    get_sentence_feats (
+        unsigned long i,
+        std::vector<matrix<float,0,1> >& sent
+    ) const
+    {
+        const ner_sentence_feats s = (*this)[i];
+        sent.resize(s.size());
+        for (unsigned long j = 0; j < s.size(); ++j)
+        {
+            const float* f = s[j];
+            sent[j].set_size(num_dims);
+            for (unsigned long k = 0; k < num_dims; ++k)
+                sent[j](k) = f[k];
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
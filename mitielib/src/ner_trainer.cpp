@@ -3,6 +3,9 @@
 // Authors: Davis E. King (davis@dlib.net)
 
 #include <mitie/ner_trainer.h>
+#include <mitie/parallel_parameter_search.h>
+#include <mitie/warm_start_trainers.h>
+#include <mitie/averaged_perceptron_trainers.h>
 #include <dlib/svm_threaded.h>
 #include <dlib/optimization.h>
 #include <dlib/misc_api.h>
@@ -119,7 +122,8 @@ namespace mitie
     ner_trainer::
     ner_trainer (
         const std::string& filename
-    ) : beta(0.5), num_threads(4)
+    ) : beta(0.5), num_threads(4), parallel_search(false), online_training_epochs(0),
+        has_base(false), base_num_tags(0), replay_ratio(1)
     {
         string classname;
         dlib::deserialize(filename) >> classname >> tfe;
@@ -130,7 +134,16 @@ namespace mitie
     unsigned long ner_trainer::
     size() const 
     {
-        return sentences.size();
+        return corpus.size();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    dlib::uint64 ner_trainer::
+    get_memory_usage (
+    ) const
+    {
+        return corpus.get_memory_usage() + replay_corpus.get_memory_usage();
     }
 
 // ----------------------------------------------------------------------------------------
@@ -140,12 +153,10 @@ namespace mitie
         const ner_training_instance& item
     )
     {
-        sentences.push_back(item.tokens);
-        chunks.push_back(item.chunks);
         std::vector<unsigned long> temp;
         for (unsigned long i = 0; i < item.chunk_labels.size(); ++i)
             temp.push_back(get_label_id(item.chunk_labels[i]));
-        chunk_labels.push_back(temp);
+        corpus.add(item.tokens, item.chunks, temp);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -160,12 +171,10 @@ namespace mitie
         // TODO, add missing asserts
         DLIB_CASSERT(ranges.size() == labels.size(),"");
 
-        sentences.push_back(tokens);
-        chunks.push_back(ranges);
         std::vector<unsigned long> temp;
         for (unsigned long i = 0; i < labels.size(); ++i)
             temp.push_back(get_label_id(labels[i]));
-        chunk_labels.push_back(temp);
+        corpus.add(tokens, ranges, temp);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -189,6 +198,106 @@ namespace mitie
             add(tokens[i], ranges[i], labels[i]);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    set_base_model (
+        const named_entity_extractor& ner
+    )
+    {
+        DLIB_CASSERT(ner.get_total_word_feature_extractor().get_fingerprint() == tfe.get_fingerprint(),
+            "The named_entity_extractor given to set_base_model() wasn't trained with this trainer's total_word_feature_extractor.");
+
+        // The base model's classifier outputs tag ids, so the trainer has to use the same
+        // ids for those tags.  Labels added before now are renumbered to come after them.
+        std::vector<std::string> old_labels = get_all_labels();
+        label_to_id.clear();
+        const std::vector<std::string>& tags = ner.get_tag_name_strings();
+        for (unsigned long i = 0; i < tags.size(); ++i)
+            get_label_id(tags[i]);
+        std::vector<unsigned long> new_ids(old_labels.size());
+        for (unsigned long i = 0; i < old_labels.size(); ++i)
+            new_ids[i] = get_label_id(old_labels[i]);
+
+        corpus.remap_labels(new_ids);
+        replay_corpus.remap_labels(new_ids);
+
+        has_base = true;
+        base_num_tags = tags.size();
+        base_segmenter_weights = ner.get_segmenter().get_weights();
+        base_df = ner.get_df();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool ner_trainer::
+    has_base_model (
+    ) const { return has_base; }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long ner_trainer::
+    replay_size (
+    ) const { return replay_corpus.size(); }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    add_replay (
+        const ner_training_instance& item
+    )
+    {
+        std::vector<unsigned long> temp;
+        for (unsigned long i = 0; i < item.chunk_labels.size(); ++i)
+            temp.push_back(get_label_id(item.chunk_labels[i]));
+        replay_corpus.add(item.tokens, item.chunks, temp);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    add_replay (
+        const std::vector<std::string>& tokens,
+        const std::vector<std::pair<unsigned long,unsigned long> >& ranges,
+        const std::vector<std::string>& labels
+    ) 
+    {
+        DLIB_CASSERT(ranges.size() == labels.size(),"");
+
+        std::vector<unsigned long> temp;
+        for (unsigned long i = 0; i < labels.size(); ++i)
+            temp.push_back(get_label_id(labels[i]));
+        replay_corpus.add(tokens, ranges, temp);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double ner_trainer::
+    get_replay_ratio (
+    ) const { return replay_ratio; }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    set_replay_ratio (
+        double ratio
+    )
+    {
+        DLIB_CASSERT(ratio >= 0, "Invalid replay ratio");
+        replay_ratio = ratio;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long ner_trainer::
+    get_perceptron_epochs (
+    ) const
+    {
+        // Updating a base model always uses the perceptron, with a default number of
+        // passes if the user didn't pick one.
+        return online_training_epochs != 0 ? online_training_epochs : 10;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     unsigned long ner_trainer::
@@ -208,6 +317,45 @@ namespace mitie
     get_beta (
     ) const { return beta; }
 
+// ----------------------------------------------------------------------------------------
+
+    bool ner_trainer::
+    get_parallel_search (
+    ) const { return parallel_search; }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    set_parallel_search (
+        bool enabled
+    ) { parallel_search = enabled; }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long ner_trainer::
+    get_online_training_epochs (
+    ) const { return online_training_epochs; }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    set_online_training_epochs (
+        unsigned long epochs
+    ) { online_training_epochs = epochs; }
+
+// ----------------------------------------------------------------------------------------
+
+    const std::string& ner_trainer::
+    get_feature_cache_file (
+    ) const { return feature_cache_file; }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    set_feature_cache_file (
+        const std::string& filename
+    ) { feature_cache_file = filename; }
+
 // ----------------------------------------------------------------------------------------
 
     void ner_trainer::
@@ -219,6 +367,19 @@ namespace mitie
         beta = new_beta;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    const training_options& ner_trainer::
+    get_training_options (
+    ) const { return options; }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    set_training_options (
+        const training_options& options_
+    ) { options = options_; }
+
 // ----------------------------------------------------------------------------------------
 
     named_entity_extractor ner_trainer::
@@ -233,6 +394,7 @@ namespace mitie
 
 	// timestaper used for printouts
 	dlib::timestamper ts;
+        training_monitor monitor(options);
 
         // Print out all the labels the user gave to the screen.
         std::vector<std::string> all_labels = get_all_labels();
@@ -245,26 +407,53 @@ namespace mitie
         }
         cout << endl;
 
+        cout << "Training data memory usage: " << get_memory_usage()/1024.0/1024.0 << " MB" << endl;
+
+        // Mix a random sample of the replay data in with the new training data.  When
+        // there isn't any we just use the corpus directly rather than copying it.
+        const unsigned long num_replay = std::min<unsigned long>(replay_size(),
+                                            static_cast<unsigned long>(replay_ratio*size()));
+        ner_training_corpus mixed;
+        if (num_replay != 0)
+        {
+            std::vector<unsigned long> idx(replay_size());
+            for (unsigned long i = 0; i < idx.size(); ++i)
+                idx[i] = i;
+            dlib::rand rnd;
+            for (unsigned long i = 0; i < num_replay; ++i)
+                std::swap(idx[i], idx[i + rnd.get_random_64bit_number()%(idx.size()-i)]);
+
+            mixed = corpus;
+            for (unsigned long i = 0; i < num_replay; ++i)
+                mixed.add(replay_corpus, idx[i]);
+            cout << "Training with " << num_replay << " replay instances." << endl;
+        }
+        const ner_training_corpus& train_data = num_replay != 0 ? mixed : corpus;
+
+        // Run the word feature extractor over all the sentences once.  Everything below
+        // reads the features from this store rather than recomputing them.
+        ner_feature_store feats(tfe, train_data, num_threads, feature_cache_file);
+
         cout << "Part I: train segmenter" << endl;
 
 	dlib::uint64 start = ts.get_timestamp();
 
-        sequence_segmenter<ner_feature_extractor> segmenter;
-        train_segmenter(segmenter);
+        sequence_segmenter<ner_store_feature_extractor> segmenter;
+        train_segmenter(feats, train_data, segmenter, monitor);
 
 	dlib::uint64 stop = ts.get_timestamp();
 
 	cout << "Part I: elapsed time: " << (stop - start)/1000/1000 << " seconds." << endl << endl;
 
-        std::vector<ner_sample_type> samples;
+        std::vector<float_sample> samples;
         std::vector<unsigned long> labels;
-        extract_ner_segment_feats(segmenter, samples, labels);
+        extract_ner_segment_feats(feats, train_data, segmenter, samples, labels);
 
         cout << "Part II: train segment classifier" << endl;
 
 	start = ts.get_timestamp();
 
-        classifier_type df = train_ner_segment_classifier(samples, labels);
+        classifier_type df = train_ner_segment_classifier(samples, labels, monitor);
 
 	stop = ts.get_timestamp();
 
@@ -272,39 +461,66 @@ namespace mitie
 
         cout << "df.number_of_classes(): "<< df.number_of_classes() << endl;
 
-        return named_entity_extractor(get_all_labels(), tfe, segmenter, df);
+        // ner_store_feature_extractor and ner_feature_extractor produce the same
+        // features, so the segmenter we trained just needs its weights moved over to
+        // one that works on the output of sentence_to_feats().
+        const sequence_segmenter<ner_feature_extractor> final_segmenter(segmenter.get_weights(),
+                                                                        ner_feature_extractor(tfe.get_num_dimensions()));
+        return named_entity_extractor(get_all_labels(), tfe, final_segmenter, df);
     }
 
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 
+    // The segment classifier is trained on float_samples, which hold the same features
+    // as ner_sample_types in much less memory.
+    typedef multiclass_linear_decision_function<sparse_linear_kernel<float_sample>,unsigned long> float_classifier_type;
+    typedef warm_start_multiclass_linear_trainer<sparse_linear_kernel<float_sample>,unsigned long> warm_start_classifier_trainer;
+    typedef fold_warm_starts<warm_start_classifier_trainer::w_type> classifier_warm_starts;
+
     class train_ner_segment_classifier_objective
     {
     public:
         train_ner_segment_classifier_objective (
-            const std::vector<ner_sample_type>& samples_,
+            const std::vector<float_sample>& samples_,
             const std::vector<unsigned long>& labels_,
             unsigned long num_threads_,
             double beta_,
             unsigned long num_labels_,
-            unsigned long max_iterations_
+            unsigned long max_iterations_,
+            classifier_warm_starts& warm_starts_,
+            bool parallel_folds_ = false
         ) : samples(samples_), labels(labels_), num_threads(num_threads_), beta(beta_), num_labels(num_labels_),
-            max_iterations(max_iterations_)
+            max_iterations(max_iterations_), warm_starts(warm_starts_), parallel_folds(parallel_folds_)
         {}
 
         double operator() (
             const double C 
         ) const
         {
-            svm_multiclass_linear_trainer<sparse_linear_kernel<ner_sample_type>,unsigned long> trainer;
+            svm_multiclass_linear_trainer<sparse_linear_kernel<float_sample>,unsigned long> trainer;
 
             trainer.set_c(C);
-            trainer.set_num_threads(num_threads);
             trainer.set_max_iterations(max_iterations);
             //trainer.be_verbose();
-            matrix<double> res = cross_validate_multiclass_trainer(trainer, samples, labels, 2);
+
+            // Each fold picks up from the solution its fold found for the last C we
+            // tried, which is usually close to the solution for this C.
+            std::vector<classifier_warm_starts::warm_start_ptr> ws;
+            warm_starts.get_fold_states(ws);
+            std::vector<warm_start_classifier_trainer> fold_trainers;
+            for (unsigned long i = 0; i < ws.size(); ++i)
+            {
+                fold_trainers.push_back(warm_start_classifier_trainer(trainer, ws[i]));
+                fold_trainers.back().set_num_threads(parallel_folds ? std::max<unsigned long>(1, num_threads/ws.size()) : num_threads);
+            }
+            matrix<double> res = cross_validate_multiclass_trainer_threaded(fold_trainers, samples, labels, parallel_folds ? num_threads : 1);
             double score = compute_fscore(res, num_labels);
-            cout << "C: " << C << "   f-score: "<< score << endl;
+            warm_starts.record_fold_states(ws, score);
+            // print with one write so lines from concurrent evaluations don't get mixed up
+            std::ostringstream sout;
+            sout << "C: " << C << "   f-score: "<< score << endl;
+            cout << sout.str() << flush;
             return score;
         }
 
@@ -327,12 +543,14 @@ namespace mitie
         }
 
     private:
-        const std::vector<ner_sample_type>& samples;
+        const std::vector<float_sample>& samples;
         const std::vector<unsigned long>& labels;
         const unsigned long num_threads;
         const double beta;
         const unsigned long num_labels;
         const unsigned long max_iterations;
+        classifier_warm_starts& warm_starts;
+        const bool parallel_folds;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -359,14 +577,47 @@ namespace mitie
 
     ner_trainer::classifier_type ner_trainer::
     train_ner_segment_classifier (
-        const std::vector<ner_sample_type>& samples,
-        const std::vector<unsigned long>& labels
+        const std::vector<float_sample>& samples,
+        const std::vector<unsigned long>& labels,
+        training_monitor& monitor
     ) const
     {
         cout << "now do training" << endl;
         cout << "num training samples: " << samples.size() << endl;
 
-        svm_multiclass_linear_trainer<sparse_linear_kernel<ner_sample_type>,unsigned long> trainer;
+        if (online_training_epochs != 0 || has_base)
+        {
+            cout << "averaged perceptron epochs: " << get_perceptron_epochs() << endl;
+            monitor.begin_phase("classifier training");
+            averaged_perceptron_multiclass_trainer<float_sample,unsigned long> trainer;
+            trainer.set_num_epochs(get_perceptron_epochs());
+            if (has_base)
+            {
+                // The base model's tags have the same ids here, but its "not an entity"
+                // label has to move past any new tags.
+                float_classifier_type initial_df;
+                convert_linear_decision_function(base_df, initial_df);
+                const unsigned long not_entity = get_all_labels().size();
+                for (unsigned long i = 0; i < initial_df.labels.size(); ++i)
+                {
+                    if (initial_df.labels[i] >= base_num_tags)
+                        initial_df.labels[i] = not_entity;
+                }
+                trainer.set_initial_classifier(initial_df);
+            }
+            trainer.set_num_threads(num_threads);
+            trainer.be_verbose();
+            const float_classifier_type df = trainer.train(samples, labels);
+            matrix<double> res = test_multiclass_decision_function(df, samples, labels);
+            cout << "test on train: \n" << res << endl;
+            cout << "overall accuracy: "<< sum(diag(res))/sum(res) << endl;
+            monitor.end_phase(sum(diag(res))/sum(res));
+            classifier_type final_df;
+            convert_linear_decision_function(df, final_df);
+            return final_df;
+        }
+
+        svm_multiclass_linear_trainer<sparse_linear_kernel<float_sample>,unsigned long> trainer;
 
         trainer.set_c(300);
         trainer.set_num_threads(num_threads);
@@ -374,34 +625,81 @@ namespace mitie
         trainer.set_max_iterations(2000);
         //trainer.be_verbose();
 
+        // The final training starts from the average of the cross-validation
+        // solutions for the chosen C.
+        classifier_warm_starts::warm_start_ptr final_warm_start(new oca_warm_start<warm_start_classifier_trainer::w_type>(0));
         if (count_of_least_common_label(labels) > 1)
         {
-            train_ner_segment_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000);
-
             double C = 300;
             const double min_C = 0.01;
             const double max_C = 5000;
             const double eps = 1;
-            try
+            classifier_warm_starts warm_starts(2, 3);
+            monitor.begin_search("classifier parameter search", 100);
+            unsigned long num_concurrent, threads_per_eval;
+            if (parallel_search && split_search_threads(num_threads, 2, num_concurrent, threads_per_eval))
             {
-                find_max_single_variable(obj, C, min_C, max_C, eps, 100, 100);
+                train_ner_segment_classifier_objective obj(samples, labels, threads_per_eval, beta, get_all_labels().size(), 2000,
+                                                           warm_starts, true);
+                monitored_objective<train_ner_segment_classifier_objective,double> mobj(obj, monitor, false);
+                double log_C = std::log(C);
+                find_max_parallel_grid(make_log_space_objective(mobj), log_C, std::log(min_C), std::log(max_C),
+                                       std::log((C+eps)/C), num_concurrent, monitor.get_max_evaluations(), &monitor);
+                C = std::exp(log_C);
             }
-            catch (optimize_single_variable_failure&)
+            else
             {
-                // if the optimization ran too long then just use a C of 300
-                C = 300;
+                train_ner_segment_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000,
+                                                           warm_starts);
+                monitored_objective<train_ner_segment_classifier_objective,double> mobj(obj, monitor, true);
+                try
+                {
+                    find_max_single_variable(mobj, C, min_C, max_C, eps, 100, 100);
+                }
+                catch (optimize_single_variable_failure&)
+                {
+                    // if the optimization ran too long then just use a C of 300
+                    C = 300;
+                }
+                catch (search_stopped&)
+                {
+                    if (!mobj.get_best(C))
+                        C = 300;
+                }
             }
 
             cout << "best C: "<< C << endl;
             trainer.set_c(C);
+
+            std::vector<warm_start_classifier_trainer::w_type> solutions;
+            warm_starts.get_best_solutions(solutions);
+            const long num_classes = select_all_distinct_labels(labels).size();
+            const long dims = max_index_plus_one(samples);
+            warm_start_classifier_trainer::w_type w;
+            unsigned long num_used = 0;
+            for (unsigned long i = 0; i < solutions.size(); ++i)
+            {
+                if (solutions[i].size() == 0 || solutions[i].size()%num_classes != 0)
+                    continue;
+                if (num_used++ == 0)
+                    w = resize_multiclass_weights(solutions[i], num_classes, dims);
+                else
+                    w += resize_multiclass_weights(solutions[i], num_classes, dims);
+            }
+            if (num_used != 0)
+                final_warm_start->set_solution(w/num_used);
         }
 
-        classifier_type df = trainer.train(samples, labels);
+        monitor.begin_phase("classifier training");
+        const float_classifier_type df = warm_start_classifier_trainer(trainer, final_warm_start).train(samples, labels);
         matrix<double> res = test_multiclass_decision_function(df, samples, labels);
         cout << "test on train: \n" << res << endl;
         cout << "overall accuracy: "<< sum(diag(res))/sum(res) << endl;
+        monitor.end_phase(sum(diag(res))/sum(res));
 
-        return df;
+        classifier_type final_df;
+        convert_linear_decision_function(df, final_df);
+        return final_df;
     }
 
 // ----------------------------------------------------------------------------------------
@@ -425,8 +723,10 @@ namespace mitie
 
     void ner_trainer::
     extract_ner_segment_feats (
-        const sequence_segmenter<ner_feature_extractor>& segmenter,
-        std::vector<ner_sample_type>& samples,
+        const ner_feature_store& feats,
+        const ner_training_corpus& train_data,
+        const sequence_segmenter<ner_store_feature_extractor>& segmenter,
+        std::vector<float_sample>& samples,
         std::vector<unsigned long>& labels
     ) const
     {
@@ -434,16 +734,23 @@ namespace mitie
         labels.clear();
         const std::vector<std::string> ner_labels = get_all_labels();
 
-        for (unsigned long i = 0; i < sentences.size(); ++i)
+        std::vector<matrix<float,0,1> > sent;
+        std::vector<std::string> tokens;
+        std::vector<std::pair<unsigned long, unsigned long> > chunks;
+        std::vector<unsigned long> chunk_labels;
+        for (unsigned long i = 0; i < train_data.size(); ++i)
         {
-            const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(tfe, sentences[i]);
+            feats.get_sentence_feats(i, sent);
+            train_data.get_tokens(i, tokens);
+            train_data.get_chunks(i, chunks);
+            train_data.get_chunk_labels(i, chunk_labels);
             std::set<std::pair<unsigned long, unsigned long> > ranges;
             // put all the true chunks into ranges
-            ranges.insert(chunks[i].begin(), chunks[i].end());
+            ranges.insert(chunks.begin(), chunks.end());
 
             // now get all the chunks our segmenter finds
             std::vector<std::pair<unsigned long, unsigned long> > temp;
-            temp = segmenter(sent);
+            temp = segmenter(feats[i]);
             ranges.insert(temp.begin(), temp.end());
 
             // now go over all the chunks we found and label them with their appropriate NER
@@ -451,8 +758,8 @@ namespace mitie
             std::set<std::pair<unsigned long,unsigned long> >::const_iterator j;
             for (j = ranges.begin(); j != ranges.end(); ++j)
             {
-                samples.push_back(extract_ner_chunk_features(sentences[i], sent, *j));
-                labels.push_back(get_label(chunks[i], chunk_labels[i], *j, ner_labels.size()));
+                samples.push_back(make_float_sample(extract_ner_chunk_features(tokens, sent, *j), MAX_FEAT));
+                labels.push_back(get_label(chunks, chunk_labels, *j, ner_labels.size()));
             }
         }
 
@@ -462,14 +769,20 @@ namespace mitie
 // ----------------------------------------------------------------------------------------
 
     const static double LOSS_SCALE = 10;
+    typedef warm_start_segmentation_trainer<ner_store_feature_extractor> warm_start_segmenter_trainer;
+    typedef fold_warm_starts<matrix<double,0,1> > segmenter_warm_starts;
+
     class train_segmenter_bobyqa_objective
     {
     public:
         train_segmenter_bobyqa_objective (
-            structural_sequence_segmentation_trainer<ner_feature_extractor>& trainer_,
-            const std::vector<std::vector<matrix<float,0,1> > >& samples_,
-            const std::vector<std::vector<std::pair<unsigned long, unsigned long> > >& local_chunks_
-        ) : trainer(trainer_), samples(samples_), local_chunks(local_chunks_)
+            structural_sequence_segmentation_trainer<ner_store_feature_extractor>& trainer_,
+            const std::vector<ner_sentence_feats>& samples_,
+            const std::vector<std::vector<std::pair<unsigned long, unsigned long> > >& local_chunks_,
+            segmenter_warm_starts& warm_starts_,
+            const unsigned long cv_threads_ = 0
+        ) : trainer(trainer_), samples(samples_), local_chunks(local_chunks_), warm_starts(warm_starts_),
+            cv_threads(cv_threads_)
         {}
 
         double operator() (
@@ -479,44 +792,93 @@ namespace mitie
             const double C = params(0);
             const double loss = params(1)/LOSS_SCALE;
 
+            // Work on a copy of the trainer so it's safe to evaluate several parameters
+            // at once.
+            structural_sequence_segmentation_trainer<ner_store_feature_extractor> trainer(this->trainer);
             trainer.set_c(C);
             trainer.set_loss_per_missed_segment(loss);
-            matrix<double> res = cross_validate_sequence_segmenter(trainer, samples, local_chunks, 2);
+
+            // Each fold picks up from the solution its fold found for the last
+            // parameters we tried, which are usually close to these ones.
+            std::vector<segmenter_warm_starts::warm_start_ptr> ws;
+            warm_starts.get_fold_states(ws);
+            std::vector<warm_start_segmenter_trainer> fold_trainers;
+            for (unsigned long i = 0; i < ws.size(); ++i)
+            {
+                fold_trainers.push_back(warm_start_segmenter_trainer(trainer, ws[i]));
+                if (cv_threads != 0)
+                    fold_trainers.back().set_num_threads(std::max<unsigned long>(1, cv_threads/ws.size()));
+            }
+            matrix<double> res = cross_validate_sequence_segmenter_threaded(fold_trainers, samples, local_chunks,
+                                                                            std::max<unsigned long>(1, cv_threads));
             double score = res(1); // use the recall as the measure of goodness
-            cout << "C: "<< C << "   loss: " << loss << " \t" << score << endl;
+            warm_starts.record_fold_states(ws, score);
+            std::ostringstream sout;
+            sout << "C: "<< C << "   loss: " << loss << " \t" << score << endl;
+            cout << sout.str() << flush;
             return score;
         }
 
     private:
-        structural_sequence_segmentation_trainer<ner_feature_extractor>& trainer;
-        const std::vector<std::vector<matrix<float,0,1> > >& samples;
+        const structural_sequence_segmentation_trainer<ner_store_feature_extractor>& trainer;
+        const std::vector<ner_sentence_feats>& samples;
         const std::vector<std::vector<std::pair<unsigned long, unsigned long> > >& local_chunks;
+        segmenter_warm_starts& warm_starts;
+        const unsigned long cv_threads;
     };
 
 // ----------------------------------------------------------------------------------------
 
     void ner_trainer::
     train_segmenter (
-        sequence_segmenter<ner_feature_extractor>& segmenter
+        const ner_feature_store& feats,
+        const ner_training_corpus& train_data,
+        sequence_segmenter<ner_store_feature_extractor>& segmenter,
+        training_monitor& monitor
     ) const
     {
         cout << "words in dictionary: " << tfe.get_num_words_in_dictionary() << endl;
         cout << "num features: " << tfe.get_num_dimensions() << endl;
 
 
-        // do the feature extraction for all the sentences
-        std::vector<std::vector<matrix<float,0,1> > > samples;
-        samples.reserve(sentences.size());
-        for (unsigned long i = 0; i < sentences.size(); ++i)
-            samples.push_back(sentence_to_feats(tfe, sentences[i]));
+        // These just refer to the features in feats, so shuffling them and splitting
+        // them into cross-validation folds doesn't copy any feature vectors.
+        std::vector<ner_sentence_feats> samples;
+        samples.reserve(feats.size());
+        for (unsigned long i = 0; i < feats.size(); ++i)
+            samples.push_back(feats[i]);
 
-        std::vector<std::vector<std::pair<unsigned long, unsigned long> > > local_chunks(chunks);
+        std::vector<std::vector<std::pair<unsigned long, unsigned long> > > local_chunks(train_data.size());
+        for (unsigned long i = 0; i < train_data.size(); ++i)
+            train_data.get_chunks(i, local_chunks[i]);
         randomize_samples(samples, local_chunks);
 
         cout << "now do training" << endl;
 
-        ner_feature_extractor nfe(tfe.get_num_dimensions());
-        structural_sequence_segmentation_trainer<ner_feature_extractor> trainer(nfe);
+        ner_store_feature_extractor nfe(tfe.get_num_dimensions());
+        if (online_training_epochs != 0 || has_base)
+        {
+            const double loss_per_missed_segment = 3.0;
+            cout << "averaged perceptron epochs: " << get_perceptron_epochs() << endl;
+            cout << "num threads: "<< num_threads << endl;
+            cout << "loss per missed segment:  "<< loss_per_missed_segment << endl;
+            monitor.begin_phase("segmenter training");
+            averaged_perceptron_segmentation_trainer<ner_store_feature_extractor> trainer(nfe);
+            trainer.set_num_epochs(get_perceptron_epochs());
+            trainer.set_num_threads(num_threads);
+            trainer.set_loss_per_missed_segment(loss_per_missed_segment);
+            if (has_base)
+                trainer.set_initial_weights(base_segmenter_weights);
+            trainer.be_verbose();
+            segmenter = trainer.train(samples, local_chunks);
+            cout << "num feats in chunker model: "<< segmenter.get_weights().size() << endl;
+            const matrix<double,1,3> res = test_sequence_segmenter(segmenter, samples, local_chunks);
+            cout << "train: precision, recall, f1-score: "<< res;
+            monitor.end_phase(res(2));
+            return;
+        }
+
+        structural_sequence_segmentation_trainer<ner_store_feature_extractor> trainer(nfe);
 
         const double C = 20.0; 
         const double eps = 0.01;
@@ -537,8 +899,12 @@ namespace mitie
         trainer.set_loss_per_missed_segment(loss_per_missed_segment);
         //trainer.be_verbose();
 
+        // The final training starts from the average of the cross-validation
+        // solutions for the chosen parameters.
+        segmenter_warm_starts::warm_start_ptr final_warm_start(new oca_warm_start<matrix<double,0,1> >(0));
         if (samples.size() > 1)
         {
+            segmenter_warm_starts warm_starts(2, 40);
             matrix<double,2,1> params;
             params = C, loss_per_missed_segment*LOSS_SCALE;
 
@@ -546,29 +912,70 @@ namespace mitie
             min_params = 0.1, 1*LOSS_SCALE;
             max_params = 100, 10*LOSS_SCALE;
 
-            train_segmenter_bobyqa_objective obj(trainer, samples, local_chunks);
-            try
+            monitor.begin_search("segmenter parameter search", 100);
+            unsigned long num_concurrent, threads_per_eval;
+            if (parallel_search && split_search_threads(num_threads, 2, num_concurrent, threads_per_eval))
             {
-                find_max_bobyqa(obj, params, params.size()*2+1, min_params, max_params, 15, 1, 100);
+                // Search over the log of the parameters since C spans 3 orders of
+                // magnitude.  The smallest grid step is about the same as the final
+                // trust region radius BOBYQA uses below.
+                train_segmenter_bobyqa_objective obj(trainer, samples, local_chunks, warm_starts, threads_per_eval);
+                monitored_objective<train_segmenter_bobyqa_objective,matrix<double,2,1> > mobj(obj, monitor, false);
+                matrix<double,2,1> log_params = log(params);
+                matrix<double,2,1> min_step;
+                min_step = std::log(1.1), std::log(1.1);
+                find_max_parallel_grid(make_log_space_objective(mobj), log_params, matrix<double,2,1>(log(min_params)),
+                                       matrix<double,2,1>(log(max_params)), min_step, num_concurrent,
+                                       monitor.get_max_evaluations(), &monitor);
+                params = exp(log_params);
             }
-            catch (bobyqa_failure&)
+            else
             {
-                // if the optimization ran too long then just use the default
-                // parameters
-                params = C, loss_per_missed_segment*LOSS_SCALE;
+                train_segmenter_bobyqa_objective obj(trainer, samples, local_chunks, warm_starts);
+                monitored_objective<train_segmenter_bobyqa_objective,matrix<double,2,1> > mobj(obj, monitor, true);
+                try
+                {
+                    // BOBYQA gets one more evaluation than the monitor allows so that
+                    // running out of evaluations keeps the best parameters found.
+                    find_max_bobyqa(mobj, params, params.size()*2+1, min_params, max_params, 15, 1,
+                                    monitor.get_max_evaluations()+1);
+                }
+                catch (bobyqa_failure&)
+                {
+                    // if the optimization ran too long then just use the default
+                    // parameters
+                    params = C, loss_per_missed_segment*LOSS_SCALE;
+                }
+                catch (search_stopped&)
+                {
+                    if (!mobj.get_best(params))
+                        params = C, loss_per_missed_segment*LOSS_SCALE;
+                }
             }
 
             cout << "best C: "<< params(0) << endl;
             cout << "best loss: "<< params(1)/LOSS_SCALE << endl;
             trainer.set_c(params(0));
             trainer.set_loss_per_missed_segment(params(1)/LOSS_SCALE);
-        }
 
+            std::vector<matrix<double,0,1> > solutions;
+            warm_starts.get_best_solutions(solutions);
+            if (solutions.size() != 0 && solutions[0].size() != 0)
+            {
+                matrix<double,0,1> w = solutions[0];
+                for (unsigned long i = 1; i < solutions.size(); ++i)
+                    w += solutions[i];
+                final_warm_start->set_solution(w/solutions.size());
+            }
+        }
 
-        segmenter = trainer.train(samples, local_chunks);
+        monitor.begin_phase("segmenter training");
+        segmenter = warm_start_segmenter_trainer(trainer, final_warm_start).train(samples, local_chunks);
 
         cout << "num feats in chunker model: "<< segmenter.get_weights().size() << endl;
-        cout << "train: precision, recall, f1-score: "<< test_sequence_segmenter(segmenter, samples, local_chunks);
+        const matrix<double,1,3> res = test_sequence_segmenter(segmenter, samples, local_chunks);
+        cout << "train: precision, recall, f1-score: "<< res;
+        monitor.end_phase(res(2));
     }
 
 // ----------------------------------------------------------------------------------------
@@ -0,0 +1,227 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/ner_training_corpus.h>
+#include <dlib/hash.h>
+#include <dlib/assert.h>
+#include <cstring>
+
+using namespace dlib;
+
+namespace mitie
+{
+    using namespace std;
+
+// ----------------------------------------------------------------------------------------
+
+    const dlib::uint32 ner_training_corpus::EMPTY_SLOT;
+
+// ----------------------------------------------------------------------------------------
+
+    ner_training_corpus::
+    ner_training_corpus (
+    )
+    {
+        pool_offsets.push_back(0);
+        hash_table.assign(1024, EMPTY_SLOT);
+        token_offsets.push_back(0);
+        chunk_offsets.push_back(0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    add (
+        const std::vector<std::string>& tokens,
+        const std::vector<std::pair<unsigned long,unsigned long> >& chunks_,
+        const std::vector<unsigned long>& chunk_labels
+    )
+    {
+        DLIB_CASSERT(chunks_.size() == chunk_labels.size(), "Invalid inputs");
+
+        for (unsigned long i = 0; i < tokens.size(); ++i)
+            token_ids.push_back(intern(tokens[i]));
+        token_offsets.push_back(token_ids.size());
+
+        for (unsigned long i = 0; i < chunks_.size(); ++i)
+        {
+            DLIB_CASSERT(chunks_[i].first < chunks_[i].second && chunks_[i].second <= tokens.size(), "Invalid inputs");
+            chunks.push_back(chunk(chunks_[i].first, chunks_[i].second, chunk_labels[i]));
+        }
+        chunk_offsets.push_back(chunks.size());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    add (
+        const ner_training_corpus& other,
+        unsigned long i
+    )
+    {
+        DLIB_CASSERT(i < other.size(), "Invalid inputs");
+
+        // The two corpora have their own string pools, so the tokens have to be
+        // interned again here.
+        for (uint64 j = other.token_offsets[i]; j < other.token_offsets[i+1]; ++j)
+        {
+            const uint32 id = other.token_ids[j];
+            const std::string token(other.pool.begin() + other.pool_offsets[id],
+                                    other.pool.begin() + other.pool_offsets[id+1]);
+            token_ids.push_back(intern(token));
+        }
+        token_offsets.push_back(token_ids.size());
+
+        chunks.insert(chunks.end(), other.chunks.begin() + other.chunk_offsets[i],
+                      other.chunks.begin() + other.chunk_offsets[i+1]);
+        chunk_offsets.push_back(chunks.size());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    get_tokens (
+        unsigned long i,
+        std::vector<std::string>& tokens
+    ) const
+    {
+        tokens.resize(num_tokens(i));
+        for (unsigned long j = 0; j < tokens.size(); ++j)
+        {
+            const uint32 id = token_ids[token_offsets[i]+j];
+            tokens[j].assign(pool.begin() + pool_offsets[id], pool.begin() + pool_offsets[id+1]);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    get_chunks (
+        unsigned long i,
+        std::vector<std::pair<unsigned long,unsigned long> >& chunks_
+    ) const
+    {
+        chunks_.clear();
+        for (uint64 j = chunk_offsets[i]; j < chunk_offsets[i+1]; ++j)
+            chunks_.push_back(std::make_pair(chunks[j].begin, chunks[j].end));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    get_chunk_labels (
+        unsigned long i,
+        std::vector<unsigned long>& chunk_labels
+    ) const
+    {
+        chunk_labels.clear();
+        for (uint64 j = chunk_offsets[i]; j < chunk_offsets[i+1]; ++j)
+            chunk_labels.push_back(chunks[j].label);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    remap_labels (
+        const std::vector<unsigned long>& new_labels
+    )
+    {
+        for (unsigned long i = 0; i < chunks.size(); ++i)
+        {
+            DLIB_CASSERT(chunks[i].label < new_labels.size(), "Invalid inputs");
+            chunks[i].label = new_labels[chunks[i].label];
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    dlib::uint64 ner_training_corpus::
+    get_memory_usage (
+    ) const
+    {
+        return pool.capacity()*sizeof(char) +
+               pool_offsets.capacity()*sizeof(uint64) +
+               hash_table.capacity()*sizeof(uint32) +
+               token_ids.capacity()*sizeof(uint32) +
+               token_offsets.capacity()*sizeof(uint64) +
+               chunks.capacity()*sizeof(chunk) +
+               chunk_offsets.capacity()*sizeof(uint64);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    swap (
+        ner_training_corpus& item
+    )
+    {
+        pool.swap(item.pool);
+        pool_offsets.swap(item.pool_offsets);
+        hash_table.swap(item.hash_table);
+        token_ids.swap(item.token_ids);
+        token_offsets.swap(item.token_offsets);
+        chunks.swap(item.chunks);
+        chunk_offsets.swap(item.chunk_offsets);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    dlib::uint32 ner_training_corpus::
+    hash_token (
+        const char* str,
+        unsigned long len
+    ) const
+    {
+        return murmur_hash3(str, len) & (hash_table.size()-1);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    dlib::uint32 ner_training_corpus::
+    intern (
+        const std::string& token
+    )
+    {
+        uint32 slot = hash_token(token.data(), token.size());
+        while (hash_table[slot] != EMPTY_SLOT)
+        {
+            const uint32 id = hash_table[slot];
+            const uint64 len = pool_offsets[id+1]-pool_offsets[id];
+            if (len == token.size() && (len == 0 || std::memcmp(&pool[0] + pool_offsets[id], token.data(), len) == 0))
+                return id;
+            slot = (slot+1) & (hash_table.size()-1);
+        }
+
+        const uint32 id = get_num_unique_tokens();
+        pool.insert(pool.end(), token.begin(), token.end());
+        pool_offsets.push_back(pool.size());
+        hash_table[slot] = id;
+
+        if (get_num_unique_tokens()*2 > hash_table.size())
+            grow_hash_table();
+        return id;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_training_corpus::
+    grow_hash_table (
+    )
+    {
+        hash_table.assign(hash_table.size()*2, EMPTY_SLOT);
+        for (uint32 id = 0; id < get_num_unique_tokens(); ++id)
+        {
+            // pool is empty if the only token seen so far is the empty string.
+            const char* text = pool.size() != 0 ? &pool[0] + pool_offsets[id] : 0;
+            uint32 slot = hash_token(text, pool_offsets[id+1]-pool_offsets[id]);
+            while (hash_table[slot] != EMPTY_SLOT)
+                slot = (slot+1) & (hash_table.size()-1);
+            hash_table[slot] = id;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
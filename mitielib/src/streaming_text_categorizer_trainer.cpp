@@ -0,0 +1,348 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/streaming_text_categorizer_trainer.h>
+#include <mitie/text_feature_store.h>
+#include <mitie/text_feature_extraction.h>
+#include <mitie/averaged_perceptron_trainers.h>
+#include <mitie/conll_span_tokenizer.h>
+#include <dlib/threads.h>
+#include <dlib/misc_api.h>
+#include <dlib/rand.h>
+#include <fstream>
+#include <sstream>
+#include <map>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace dlib;
+
+namespace mitie
+{
+    using namespace std;
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        // The feature extraction reads this many documents, or this many bytes of text,
+        // at a time.
+        const unsigned long max_batch_documents = 10000;
+        const unsigned long max_batch_bytes = 16*1024*1024;
+
+        // Each training chunk is this many of the feature store's blocks, which are
+        // about 1MB each.
+        const unsigned long blocks_per_chunk = 64;
+
+        class document_feature_filler
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the function object given to parallel_for_blocked() to
+                    compute the features for a range of documents in a batch.
+            !*/
+        public:
+            document_feature_filler (
+                const total_word_feature_extractor& fe_,
+                const std::vector<std::vector<std::string> >& documents_,
+                std::vector<float_sample>& samples_
+            ) : fe(fe_), documents(documents_), samples(samples_) {}
+
+            void fill (
+                long begin,
+                long end
+            )
+            {
+                // each block gets its own scratch space so the threads can share fe.
+                std::vector<dlib::uint16> scratch;
+                for (long i = begin; i < end; ++i)
+                {
+                    // Use the same features text_categorizer::predict() does.
+                    if (fe.get_num_dimensions() == 0)
+                    {
+                        samples[i] = make_float_sample(extract_BoW_features(documents[i]), MAX_FEAT);
+                    }
+                    else
+                    {
+                        const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(fe, documents[i], scratch);
+                        samples[i] = make_float_sample(extract_combined_features(documents[i], sent), MAX_FEAT);
+                    }
+                }
+            }
+
+        private:
+            const total_word_feature_extractor& fe;
+            const std::vector<std::vector<std::string> >& documents;
+            std::vector<float_sample>& samples;
+        };
+
+        void add_batch_to_store (
+            const total_word_feature_extractor& fe,
+            const unsigned long num_threads,
+            std::vector<std::vector<std::string> >& documents,
+            std::vector<unsigned long>& labels,
+            text_feature_store& store
+        )
+        /*!
+            ensures
+                - Adds the features of the given documents to store, and then clears
+                  documents and labels.
+        !*/
+        {
+            std::vector<float_sample> samples(documents.size());
+            document_feature_filler filler(fe, documents, samples);
+            parallel_for_blocked(num_threads, 0, (long)documents.size(), filler, &document_feature_filler::fill);
+            for (unsigned long i = 0; i < samples.size(); ++i)
+                store.add(samples[i], labels[i]);
+            documents.clear();
+            labels.clear();
+        }
+
+        dlib::mutex feature_store_name_mutex;
+        unsigned long num_feature_store_names = 0;
+
+        std::string make_feature_store_name (
+        )
+        /*!
+            ensures
+                - returns a file name that no other call to this function, in this or any
+                  other running process, returns.
+        !*/
+        {
+            unsigned long count;
+            {
+                auto_mutex lock(feature_store_name_mutex);
+                count = num_feature_store_names++;
+            }
+#ifdef _WIN32
+            const long pid = _getpid();
+#else
+            const long pid = getpid();
+#endif
+            std::ostringstream sout;
+            sout << "mitie_text_feature_store_" << pid << "_" << count << ".tmp";
+            return sout.str();
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    streaming_text_categorizer_trainer::
+    streaming_text_categorizer_trainer (
+    ) : num_threads(4), num_epochs(10)
+    {
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    streaming_text_categorizer_trainer::
+    streaming_text_categorizer_trainer (
+        const std::string& filename
+    ) : num_threads(4), num_epochs(10)
+    {
+        string classname;
+        dlib::deserialize(filename) >> classname >> tfe;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_text_categorizer_trainer::
+    add_file (
+        const std::string& filename
+    )
+    {
+        filenames.push_back(filename);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_text_categorizer_trainer::
+    set_num_threads (
+        unsigned long num
+    )
+    {
+        DLIB_CASSERT(num > 0, "Invalid number of threads");
+        num_threads = num;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_text_categorizer_trainer::
+    set_num_epochs (
+        unsigned long num
+    )
+    {
+        DLIB_CASSERT(num > 0, "Invalid number of epochs");
+        num_epochs = num;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_text_categorizer_trainer::
+    set_feature_store_file (
+        const std::string& filename
+    )
+    {
+        feature_store_file = filename;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    text_categorizer streaming_text_categorizer_trainer::
+    train (
+    ) const
+    {
+        DLIB_CASSERT(get_num_files() > 0, "You can't train a text_categorizer if you don't give any training data.");
+
+        // timestaper used for printouts
+        dlib::timestamper ts;
+        dlib::uint64 start = ts.get_timestamp();
+
+        // Stream the documents into the feature store, a batch at a time.
+        cout << "extracting text features" << endl;
+        text_feature_store store(feature_store_file.size() != 0 ? feature_store_file : make_feature_store_name());
+        std::map<std::string,unsigned long> label_to_id;
+        std::vector<std::vector<std::string> > documents;
+        std::vector<unsigned long> labels;
+        unsigned long batch_bytes = 0;
+        unsigned long num_skipped = 0;
+        std::string line, token;
+        for (unsigned long f = 0; f < filenames.size(); ++f)
+        {
+            ifstream fin(filenames[f].c_str(), ios::binary);
+            if (!fin)
+                throw dlib::error("Unable to open training file " + filenames[f]);
+
+            while (getline(fin, line))
+            {
+                const std::string::size_type tab = line.find('\t');
+                if (tab == std::string::npos)
+                {
+                    ++num_skipped;
+                    continue;
+                }
+
+                documents.resize(documents.size()+1);
+                conll_span_tokenizer tok(line.c_str()+tab+1, line.size()-tab-1);
+                while (tok(token))
+                    documents.back().push_back(token);
+                if (documents.back().size() == 0)
+                {
+                    documents.pop_back();
+                    ++num_skipped;
+                    continue;
+                }
+
+                const std::string label = line.substr(0, tab);
+                std::map<std::string,unsigned long>::iterator i = label_to_id.find(label);
+                if (i == label_to_id.end())
+                {
+                    const unsigned long next_id = label_to_id.size();
+                    i = label_to_id.insert(std::make_pair(label, next_id)).first;
+                }
+                labels.push_back(i->second);
+
+                batch_bytes += line.size();
+                if (documents.size() >= max_batch_documents || batch_bytes >= max_batch_bytes)
+                {
+                    add_batch_to_store(tfe, num_threads, documents, labels, store);
+                    batch_bytes = 0;
+                }
+            }
+        }
+        add_batch_to_store(tfe, num_threads, documents, labels, store);
+        store.finish();
+
+        if (store.size() == 0)
+            throw dlib::error("The training files don't contain any documents.");
+
+        std::vector<std::string> all_labels(label_to_id.size());
+        for (std::map<std::string,unsigned long>::const_iterator i = label_to_id.begin(); i != label_to_id.end(); ++i)
+            all_labels[i->second] = i->first;
+
+        cout << "num training documents: " << store.size() << endl;
+        if (num_skipped != 0)
+            cout << "skipped " << num_skipped << " lines without a label or text" << endl;
+        cout << "Training to recognize " << all_labels.size() << " categories: ";
+        for (unsigned long i = 0; i < all_labels.size(); ++i)
+        {
+            cout << "'" << all_labels[i] << "'";
+            if (i+1 < all_labels.size())
+                cout << ", ";
+        }
+        cout << endl;
+        cout << "feature extraction time: " << (ts.get_timestamp() - start)/1000/1000 << " seconds." << endl;
+
+        // Now run the averaged perceptron over the store.  Each chunk of blocks gets
+        // one step of iterative parameter mixing, like an epoch of
+        // averaged_perceptron_multiclass_trainer on just that chunk.  The label ids
+        // are already 0 through all_labels.size()-1, so they are also the indices the
+        // learner wants.
+        const unsigned long num_labels = all_labels.size();
+        const long dims = store.max_index_plus_one();
+        matrix<double,0,1> w = zeros_matrix<double>(num_labels*(dims+1),1);
+        matrix<double,0,1> avg = zeros_matrix(w);
+        unsigned long num_averaged = 0;
+
+        std::vector<unsigned long> block_order(store.num_blocks());
+        for (unsigned long i = 0; i < block_order.size(); ++i)
+            block_order[i] = i;
+        std::vector<float_sample> samples;
+        std::vector<unsigned long> order;
+        dlib::rand rnd;
+        for (unsigned long epoch = 0; epoch < num_epochs; ++epoch)
+        {
+            for (unsigned long i = block_order.size()-1; i > 0; --i)
+                std::swap(block_order[i], block_order[rnd.get_random_64bit_number()%(i+1)]);
+
+            dlib::uint64 mistakes = 0;
+            for (unsigned long b = 0; b < block_order.size(); b += blocks_per_chunk)
+            {
+                samples.clear();
+                labels.clear();
+                for (unsigned long j = b; j < std::min(b+blocks_per_chunk, (unsigned long)block_order.size()); ++j)
+                    store.read_block(block_order[j], samples, labels);
+
+                order.resize(samples.size());
+                for (unsigned long i = 0; i < order.size(); ++i)
+                    order[i] = i;
+                for (unsigned long i = order.size()-1; i > 0; --i)
+                    std::swap(order[i], order[rnd.get_random_64bit_number()%(i+1)]);
+
+                const unsigned long num_shards = std::max<unsigned long>(1, std::min<unsigned long>(num_threads, samples.size()));
+                std::vector<std::vector<unsigned long> > shards(num_shards);
+                for (unsigned long i = 0; i < order.size(); ++i)
+                    shards[i%num_shards].push_back(order[i]);
+
+                impl::multiclass_perceptron_learner<float_sample,unsigned long> learner(samples, labels, num_labels, dims);
+                mistakes += impl::parameter_mixing_step(learner, shards, num_threads, w, avg);
+                num_averaged += num_shards;
+            }
+
+            cout << "epoch " << epoch+1 << " of " << num_epochs << ", training errors: "
+                 << mistakes << " of " << store.size() << endl;
+        }
+        w = avg/num_averaged;
+
+        // multiclass_linear_decision_function subtracts b, so negate the bias.
+        multiclass_linear_decision_function<sparse_linear_kernel<text_sample_type>,unsigned long> df;
+        for (unsigned long i = 0; i < num_labels; ++i)
+            df.labels.push_back(i);
+        df.weights = colm(reshape(w, num_labels, dims+1), range(0,dims-1));
+        df.b       = -colm(reshape(w, num_labels, dims+1), dims);
+
+        cout << "Training time: " << (ts.get_timestamp() - start)/1000/1000 << " seconds." << endl;
+        cout << "df.number_of_classes(): "<< df.number_of_classes() << endl << endl;
+
+        return text_categorizer(all_labels, tfe, df);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
@@ -155,6 +155,38 @@ namespace mitie
         text_score = temp.second;
     }
 
+    void text_categorizer::
+    predict (
+        const std::vector<std::string>& sentence,
+        const std::vector<matrix<float,0,1> >& sent,
+        string& text_tag,
+        double& text_score,
+        const total_word_feature_extractor& fe
+    ) const
+    {
+        if(pure_model_version != pure_model_version_0 && this->tfe_fingerprint != fe.get_fingerprint())
+        {
+            throw dlib::error(
+                    "Fingerprint mismatch. "
+                    "Feature extractor must be same as the one used for training the model");
+        }
+
+        std::pair<unsigned long, double> temp;
+
+        if (fe.get_num_dimensions() == 0) {
+            temp = df.predict(extract_BoW_features(sentence));
+        } else {
+            DLIB_CASSERT(sent.size() == sentence.size(), "sentence_feats must contain one vector per token.");
+            temp = df.predict(extract_combined_features(sentence, sent));
+        }
+
+        // now label the document
+        unsigned long text_tag_id = temp.first;
+        if(text_tag_id < tag_name_strings.size()) text_tag = tag_name_strings[text_tag_id];
+        else text_tag = "Unseen";
+        text_score = temp.second;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     string text_categorizer::
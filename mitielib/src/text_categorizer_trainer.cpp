@@ -3,6 +3,8 @@
 // Authors: Davis E. King (davis@dlib.net)
 
 #include <mitie/text_categorizer_trainer.h>
+#include <mitie/parallel_parameter_search.h>
+#include <mitie/float_sample.h>
 #include <dlib/svm_threaded.h>
 
 using namespace dlib;
@@ -13,7 +15,7 @@ namespace mitie
 
 // ----------------------------------------------------------------------------------------
     text_categorizer_trainer::
-    text_categorizer_trainer ( ) : beta(0.5), num_threads(4)
+    text_categorizer_trainer ( ) : beta(0.5), num_threads(4), parallel_search(false)
     {
 
     }
@@ -23,7 +25,7 @@ namespace mitie
     text_categorizer_trainer::
     text_categorizer_trainer (
         const std::string& filename
-    ) : beta(0.5), num_threads(4)
+    ) : beta(0.5), num_threads(4), parallel_search(false)
     {
         string classname;
         dlib::deserialize(filename) >> classname >> tfe;
@@ -84,6 +86,19 @@ namespace mitie
         unsigned long num
     ) { num_threads = num; }
 
+// ----------------------------------------------------------------------------------------
+
+    bool text_categorizer_trainer::
+    get_parallel_search (
+    ) const { return parallel_search; }
+
+// ----------------------------------------------------------------------------------------
+
+    void text_categorizer_trainer::
+    set_parallel_search (
+        bool enabled
+    ) { parallel_search = enabled; }
+
 // ----------------------------------------------------------------------------------------
 
     double text_categorizer_trainer::
@@ -101,6 +116,19 @@ namespace mitie
         beta = new_beta;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    const training_options& text_categorizer_trainer::
+    get_training_options (
+    ) const { return options; }
+
+// ----------------------------------------------------------------------------------------
+
+    void text_categorizer_trainer::
+    set_training_options (
+        const training_options& options_
+    ) { options = options_; }
+
 // ----------------------------------------------------------------------------------------
 
     text_categorizer text_categorizer_trainer::
@@ -115,6 +143,7 @@ namespace mitie
 
         // timestaper used for printouts
         dlib::timestamper ts;
+        training_monitor monitor(options);
 
         // Print out all the labels the user gave to the screen.
         std::vector<std::string> all_labels = get_all_labels();
@@ -130,7 +159,7 @@ namespace mitie
         cout << "Train classifier" << endl;
 
         dlib::uint64 start = ts.get_timestamp();
-        classifier_type df = train_text_categorizer_classifier();
+        classifier_type df = train_text_categorizer_classifier(monitor);
         dlib::uint64 stop = ts.get_timestamp();
         cout << "Training time: " << (stop - start)/1000/1000 << " seconds." << endl;
         cout << "df.number_of_classes(): "<< df.number_of_classes() << endl << endl;
@@ -145,28 +174,37 @@ namespace mitie
     {
     public:
         train_text_classifier_objective (
-            const std::vector<text_sample_type>& samples_,
+            const std::vector<float_sample>& samples_,
             const std::vector<unsigned long>& labels_,
             unsigned long num_threads_,
             double beta_,
             unsigned long num_labels_,
-            unsigned long max_iterations_
-        ) : samples(samples_), labels(labels_), num_threads(num_threads_), beta(beta_), num_labels(num_labels_), max_iterations(max_iterations_)
+            unsigned long max_iterations_,
+            bool parallel_folds_ = false
+        ) : samples(samples_), labels(labels_), num_threads(num_threads_), beta(beta_), num_labels(num_labels_), max_iterations(max_iterations_),
+            parallel_folds(parallel_folds_)
         {}
 
         double operator() (
             const double C 
         ) const
         {
-            svm_multiclass_linear_trainer<sparse_linear_kernel<text_sample_type>,unsigned long> trainer;
+            svm_multiclass_linear_trainer<sparse_linear_kernel<float_sample>,unsigned long> trainer;
 
             trainer.set_c(C);
             trainer.set_num_threads(num_threads);
             trainer.set_max_iterations(max_iterations);
             //trainer.be_verbose();
-            matrix<double> res = cross_validate_multiclass_trainer(trainer, samples, labels, 2);
+            matrix<double> res;
+            if (parallel_folds)
+                res = cross_validate_multiclass_trainer_threaded(trainer, samples, labels, 2, num_threads);
+            else
+                res = cross_validate_multiclass_trainer(trainer, samples, labels, 2);
             double score = compute_fscore(res, num_labels);
-            cout << "C: " << C << "   f-score: "<< score << endl;
+            // print with one write so lines from concurrent evaluations don't get mixed up
+            std::ostringstream sout;
+            sout << "C: " << C << "   f-score: "<< score << endl;
+            cout << sout.str() << flush;
             return score;
         }
 
@@ -189,12 +227,13 @@ namespace mitie
         }
 
     private:
-        const std::vector<text_sample_type>& samples;
+        const std::vector<float_sample>& samples;
         const std::vector<unsigned long>& labels;
         const unsigned long num_threads;
         const double beta;
         const unsigned long num_labels;
         const unsigned long max_iterations;
+        const bool parallel_folds;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -221,17 +260,20 @@ namespace mitie
 
     text_categorizer_trainer::classifier_type text_categorizer_trainer::
     train_text_categorizer_classifier (
+        training_monitor& monitor
     ) const
     {
         cout << "extracting text features" << endl;
         // do the feature extraction for all the texts
-        std::vector<text_sample_type> samples;
+        // The samples are stored as float_samples, which hold the same features in
+        // much less memory.
+        std::vector<float_sample> samples;
         std::vector<unsigned long> labels;
         samples.reserve(contents.size());
         labels.reserve(text_labels.size());
         for (unsigned long i = 0; i < contents.size(); ++i) {
             const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(tfe, contents[i]);
-            samples.push_back( extract_combined_features(contents[i], sent) );
+            samples.push_back( make_float_sample(extract_combined_features(contents[i], sent), MAX_FEAT) );
             labels.push_back( text_labels[i] );
         }
         randomize_samples(samples, labels);
@@ -239,7 +281,7 @@ namespace mitie
         cout << "now do training" << endl;
         cout << "num training samples: " << samples.size() << endl;
 
-        svm_multiclass_linear_trainer<sparse_linear_kernel<text_sample_type>,unsigned long> trainer;
+        svm_multiclass_linear_trainer<sparse_linear_kernel<float_sample>,unsigned long> trainer;
 
         trainer.set_c(300);
         trainer.set_num_threads(num_threads);
@@ -249,32 +291,55 @@ namespace mitie
 
         if (count_of_least_common_label(labels) > 1)
         {
-            train_text_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000);
-
             double C = 300;
             const double min_C = 0.01;
             const double max_C = 5000;
             const double eps = 1;
-            try
+            monitor.begin_search("classifier parameter search", 100);
+            unsigned long num_concurrent, threads_per_eval;
+            if (parallel_search && split_search_threads(num_threads, 2, num_concurrent, threads_per_eval))
             {
-                find_max_single_variable(obj, C, min_C, max_C, eps, 100, 100);
+                train_text_classifier_objective obj(samples, labels, threads_per_eval, beta, get_all_labels().size(), 2000, true);
+                monitored_objective<train_text_classifier_objective,double> mobj(obj, monitor, false);
+                double log_C = std::log(C);
+                find_max_parallel_grid(make_log_space_objective(mobj), log_C, std::log(min_C), std::log(max_C),
+                                       std::log((C+eps)/C), num_concurrent, monitor.get_max_evaluations(), &monitor);
+                C = std::exp(log_C);
             }
-            catch (optimize_single_variable_failure&)
+            else
             {
-                // if the optimization ran too long then just use a C of 300
-                C = 300;
+                train_text_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000);
+                monitored_objective<train_text_classifier_objective,double> mobj(obj, monitor, true);
+                try
+                {
+                    find_max_single_variable(mobj, C, min_C, max_C, eps, 100, 100);
+                }
+                catch (optimize_single_variable_failure&)
+                {
+                    // if the optimization ran too long then just use a C of 300
+                    C = 300;
+                }
+                catch (search_stopped&)
+                {
+                    if (!mobj.get_best(C))
+                        C = 300;
+                }
             }
 
             cout << "best C: "<< C << endl;
             trainer.set_c(C);
         }
 
-        classifier_type df = trainer.train(samples, labels);
+        monitor.begin_phase("classifier training");
+        const multiclass_linear_decision_function<sparse_linear_kernel<float_sample>,unsigned long> df = trainer.train(samples, labels);
         matrix<double> res = test_multiclass_decision_function(df, samples, labels);
         cout << "test on train: \n" << res << endl;
         cout << "overall accuracy: "<< sum(diag(res))/sum(res) << endl;
+        monitor.end_phase(sum(diag(res))/sum(res));
 
-        return df;
+        classifier_type final_df;
+        convert_linear_decision_function(df, final_df);
+        return final_df;
     }
 
 // ----------------------------------------------------------------------------------------
@@ -0,0 +1,189 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/text_feature_store.h>
+#include <dlib/error.h>
+#include <dlib/assert.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace dlib;
+
+namespace mitie
+{
+    using namespace std;
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        /*
+            Each sample is stored as the following sequence of 4 byte values, all in the
+            machine's native byte order since the file never outlives the store:
+                label, dense_offset, number of sparse elements, number of dense elements,
+                the sparse elements as (index, value) pairs,
+                the dense elements.
+        */
+
+        template <typename T>
+        void put (
+            char*& out,
+            const T& val
+        )
+        {
+            std::memcpy(out, &val, sizeof(T));
+            out += sizeof(T);
+        }
+
+        template <typename T>
+        void get (
+            const char*& in,
+            T& val
+        )
+        {
+            std::memcpy(&val, in, sizeof(T));
+            in += sizeof(T);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    text_feature_store::
+    text_feature_store (
+        const std::string& filename_,
+        unsigned long block_size_
+    ) : filename(filename_), block_size(block_size_), num_samples(0), dims(0), finished(false)
+    {
+        DLIB_CASSERT(block_size > 0, "Invalid inputs were given to this function");
+
+        file.open(filename.c_str(), ios::in | ios::out | ios::trunc | ios::binary);
+        if (!file)
+            throw dlib::error("Unable to create feature store file " + filename);
+        block_offsets.push_back(0);
+        buf.reserve(block_size);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    text_feature_store::
+    ~text_feature_store (
+    )
+    {
+        file.close();
+        std::remove(filename.c_str());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void text_feature_store::
+    add (
+        const float_sample& x,
+        unsigned long label
+    )
+    {
+        DLIB_CASSERT(!is_finished(), "You can't add samples to a finished text_feature_store.");
+
+        const unsigned long pos = buf.size();
+        buf.resize(pos + 4*sizeof(dlib::uint32) + x.sparse.size()*2*sizeof(dlib::uint32) + x.dense.size()*sizeof(float));
+        char* out = &buf[pos];
+        put(out, (dlib::uint32)label);
+        put(out, (dlib::uint32)x.dense_offset);
+        put(out, (dlib::uint32)x.sparse.size());
+        put(out, (dlib::uint32)x.dense.size());
+        for (unsigned long i = 0; i < x.sparse.size(); ++i)
+        {
+            put(out, x.sparse[i].first);
+            put(out, x.sparse[i].second);
+            dims = std::max<unsigned long>(dims, x.sparse[i].first+1);
+        }
+        if (x.dense.size() != 0)
+        {
+            std::memcpy(out, &x.dense[0], x.dense.size()*sizeof(float));
+            dims = std::max<unsigned long>(dims, x.dense_offset + x.dense.size());
+        }
+
+        ++num_samples;
+        if (buf.size() >= block_size)
+            write_block();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void text_feature_store::
+    finish (
+    )
+    {
+        DLIB_CASSERT(!is_finished(), "finish() has already been called.");
+        if (buf.size() != 0)
+            write_block();
+        file.flush();
+        if (!file)
+            throw dlib::error("Error while writing feature store file " + filename);
+        finished = true;
+        buf.clear();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void text_feature_store::
+    write_block (
+    )
+    {
+        file.write(&buf[0], buf.size());
+        if (!file)
+            throw dlib::error("Error while writing feature store file " + filename);
+        block_offsets.push_back(block_offsets.back() + buf.size());
+        buf.clear();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void text_feature_store::
+    read_block (
+        unsigned long i,
+        std::vector<float_sample>& samples,
+        std::vector<unsigned long>& labels
+    )
+    {
+        DLIB_CASSERT(is_finished() && i < num_blocks(), "Invalid inputs were given to this function");
+
+        buf.resize(block_offsets[i+1] - block_offsets[i]);
+        file.seekg(block_offsets[i]);
+        file.read(&buf[0], buf.size());
+        if (!file)
+            throw dlib::error("Error while reading feature store file " + filename);
+
+        const char* in = &buf[0];
+        const char* const end = in + buf.size();
+        while (in < end)
+        {
+            dlib::uint32 label, dense_offset, num_sparse, num_dense;
+            get(in, label);
+            get(in, dense_offset);
+            get(in, num_sparse);
+            get(in, num_dense);
+
+            samples.resize(samples.size()+1);
+            float_sample& x = samples.back();
+            x.dense_offset = dense_offset;
+            x.sparse.resize(num_sparse);
+            for (unsigned long j = 0; j < num_sparse; ++j)
+            {
+                get(in, x.sparse[j].first);
+                get(in, x.sparse[j].second);
+            }
+            x.dense.resize(num_dense);
+            if (num_dense != 0)
+            {
+                std::memcpy(&x.dense[0], in, num_dense*sizeof(float));
+                in += num_dense*sizeof(float);
+            }
+            labels.push_back(label);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
@@ -0,0 +1,245 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/training_options.h>
+#include <dlib/assert.h>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+using namespace dlib;
+
+namespace mitie
+{
+    using namespace std;
+
+// ----------------------------------------------------------------------------------------
+
+    training_options::
+    training_options (
+    ) : max_wall_time(0), max_search_evaluations(0), patience(0), tolerance(0)
+    {
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void training_options::
+    set_max_wall_time (
+        double seconds
+    )
+    {
+        DLIB_CASSERT(seconds >= 0, "Invalid wall time");
+        max_wall_time = seconds;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void training_options::
+    set_early_stopping (
+        unsigned long patience_,
+        double tolerance_
+    )
+    {
+        DLIB_CASSERT(tolerance_ >= 0, "Invalid early stopping tolerance");
+        patience = patience_;
+        tolerance = tolerance_;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    dlib::uint64 get_process_memory_usage (
+    )
+    {
+#if defined(__linux__)
+        // The second field of statm is the resident set size in pages.
+        std::ifstream fin("/proc/self/statm");
+        dlib::uint64 size = 0, resident = 0;
+        if (fin >> size >> resident)
+            return resident*sysconf(_SC_PAGESIZE);
+        return 0;
+#elif defined(__APPLE__)
+        task_basic_info info;
+        mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+            return info.resident_size;
+        return 0;
+#else
+        return 0;
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    training_monitor::
+    training_monitor (
+        const training_options& options_
+    ) : options(options_), start(ts.get_timestamp()), phase_start(start), max_evals(0),
+        num_started(0), num_finished(0), since_improvement(0),
+        best_score(-std::numeric_limits<double>::infinity()), over(false)
+    {
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void training_monitor::
+    begin_search (
+        const std::string& phase_,
+        unsigned long default_max_evaluations
+    )
+    {
+        auto_mutex lock(m);
+        phase = phase_;
+        phase_start = ts.get_timestamp();
+        max_evals = options.get_max_search_evaluations() != 0 ? options.get_max_search_evaluations() : default_max_evaluations;
+        num_started = 0;
+        num_finished = 0;
+        since_improvement = 0;
+        best_score = -std::numeric_limits<double>::infinity();
+        over = false;
+        report(0, 0, -1);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long training_monitor::
+    get_max_evaluations (
+    ) const
+    {
+        auto_mutex lock(m);
+        return max_evals;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool training_monitor::
+    begin_evaluation (
+    )
+    {
+        auto_mutex lock(m);
+        if (over)
+            return false;
+
+        const char* reason = 0;
+        if (options.get_max_wall_time() != 0 && (ts.get_timestamp()-start)/1e6 >= options.get_max_wall_time())
+            reason = "the wall time limit was reached";
+        else if (num_started >= max_evals)
+            reason = "it made the maximum number of evaluations";
+        else if (options.get_early_stopping_patience() != 0 && since_improvement >= options.get_early_stopping_patience())
+            reason = "the cross-validation score stopped improving";
+
+        if (reason)
+        {
+            over = true;
+            cout << "stopping the " << phase << " because " << reason << endl;
+            return false;
+        }
+
+        ++num_started;
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void training_monitor::
+    end_evaluation (
+        double score
+    )
+    {
+        auto_mutex lock(m);
+        ++num_finished;
+        if (num_finished == 1 || score > best_score + options.get_early_stopping_tolerance())
+            since_improvement = 0;
+        else
+            ++since_improvement;
+        best_score = std::max(best_score, score);
+
+        // Assume each remaining evaluation takes as long as the average one so far.
+        // That already accounts for evaluations running in parallel since it's based
+        // on the wall clock time of the phase.
+        const double phase_seconds = (ts.get_timestamp()-phase_start)/1e6;
+        double eta = phase_seconds/num_finished*(max_evals - std::min(max_evals, num_finished));
+        if (options.get_max_wall_time() != 0)
+            eta = std::min(eta, std::max(0.0, options.get_max_wall_time() - (ts.get_timestamp()-start)/1e6));
+        report(num_finished, score, eta);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool training_monitor::
+    search_is_over (
+    ) const
+    {
+        auto_mutex lock(m);
+        return over;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void training_monitor::
+    begin_phase (
+        const std::string& phase_
+    )
+    {
+        auto_mutex lock(m);
+        phase = phase_;
+        phase_start = ts.get_timestamp();
+        best_score = -std::numeric_limits<double>::infinity();
+        report(0, 0, -1);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void training_monitor::
+    end_phase (
+        double objective
+    )
+    {
+        auto_mutex lock(m);
+        best_score = objective;
+        report(1, objective, 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double training_monitor::
+    get_elapsed_seconds (
+    ) const
+    {
+        return (ts.get_timestamp()-start)/1e6;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void training_monitor::
+    report (
+        unsigned long iteration,
+        double objective,
+        double eta_seconds
+    ) const
+    {
+        // This is only called with m locked, so the callback never runs concurrently.
+        if (!options.get_progress_callback())
+            return;
+
+        training_progress p;
+        p.phase = phase;
+        p.iteration = iteration;
+        p.objective = objective;
+        p.best_objective = iteration == 0 ? 0 : best_score;
+        p.elapsed_seconds = (ts.get_timestamp()-start)/1e6;
+        p.eta_seconds = eta_seconds;
+        p.memory_usage = get_process_memory_usage();
+        (*options.get_progress_callback())(p);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
@@ -7,7 +7,7 @@
 #include <mitie.h>
 #include <mitie/binary_relation_detector.h>
 #include <mitie/binary_relation_detector_trainer.h>
-#include <mitie/conll_tokenizer.h>
+#include <mitie/conll_span_tokenizer.h>
 #include <mitie/named_entity_extractor.h>
 #include <mitie/ner_trainer.h>
 
@@ -47,8 +47,7 @@ RcppExport SEXP mitie_tokenize_R (
 {
     BEGIN_RCPP
     string text = Rcpp::as<string>(_text);
-    istringstream sin(text);
-    conll_tokenizer tok(sin);
+    conll_span_tokenizer tok(text.data(), text.size());
     vector<string> tokens;
     string token;
     while (tok(token))
@@ -65,8 +64,7 @@ RcppExport SEXP mitie_tokenize_with_offsets_R (
 {
     BEGIN_RCPP
     string text = Rcpp::as<string>(_text);
-    istringstream sin(text);
-    conll_tokenizer tok(sin);
+    conll_span_tokenizer tok(text.data(), text.size());
     vector<string> tokens;
     vector<unsigned long> offsets;
     string token;
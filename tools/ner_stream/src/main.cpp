@@ -6,11 +6,17 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <map>
 #include <mitie/named_entity_extractor.h>
-#include <mitie/conll_tokenizer.h>
+#include <mitie/ner_feature_extraction.h>
+#include <mitie/conll_span_tokenizer.h>
 #include <dlib/time_this.h>
 #include <dlib/cmd_line_parser.h>
 #include <dlib/serialize.h>
+#include <dlib/pipe.h>
+#include <dlib/threads.h>
+#include <dlib/misc_api.h>
+#include <dlib/smart_pointers.h>
 
 using namespace std;
 using namespace dlib;
@@ -20,8 +26,7 @@ std::vector<std::string> tokenize (
     const std::string& line
 )
 {
-    istringstream sin(line);
-    conll_tokenizer tok(sin);
+    conll_span_tokenizer tok(line.data(), line.size());
     std::vector<std::string> words;
     string word;
     while(tok(word))
@@ -32,6 +37,339 @@ std::vector<std::string> tokenize (
 
 // ----------------------------------------------------------------------------------------
 
+struct line_batch
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            A block of consecutive input lines.  id is the position of the block in
+            the input stream and is used to put the output back in order.
+    !*/
+    line_batch() : id(0) {}
+
+    unsigned long id;
+    std::vector<std::string> lines;
+};
+
+void swap (line_batch& a, line_batch& b)
+{
+    std::swap(a.id, b.id);
+    a.lines.swap(b.lines);
+}
+
+struct output_batch
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            The output produced for the line_batch with the same id.  text is exactly
+            what should be written to the output stream for those lines.
+    !*/
+    output_batch() : id(0), num_lines(0), num_tokens(0) {}
+
+    unsigned long id;
+    std::string text;
+    unsigned long num_lines;
+    unsigned long num_tokens;
+};
+
+void swap (output_batch& a, output_batch& b)
+{
+    std::swap(a.id, b.id);
+    a.text.swap(b.text);
+    std::swap(a.num_lines, b.num_lines);
+    std::swap(a.num_tokens, b.num_tokens);
+}
+
+// ----------------------------------------------------------------------------------------
+
+void process_batch (
+    const named_entity_extractor& ner,
+    const std::vector<std::string>& tags,
+    bool binary_output,
+    std::vector<dlib::uint16>& scratch,
+    const line_batch& batch,
+    output_batch& result
+)
+/*!
+    ensures
+        - Runs the NER on each line in batch and stores the formatted results into
+          result.  If binary_output is true this is the dlib serialization format used
+          by the -o option, otherwise it's the human readable [TAG word word] format.
+        - This function is safe to call from multiple threads at the same time with the
+          same ner so long as each thread uses its own scratch vector.
+!*/
+{
+    const total_word_feature_extractor& fe = ner.get_total_word_feature_extractor();
+    ostringstream sout;
+
+    result.id = batch.id;
+    result.num_lines = batch.lines.size();
+    result.num_tokens = 0;
+    for (unsigned long j = 0; j < batch.lines.size(); ++j)
+    {
+        const std::vector<std::string> tokens = tokenize(batch.lines[j]);
+        std::vector<std::pair<unsigned long, unsigned long> > chunks;
+        std::vector<unsigned long> chunk_tags;
+        std::vector<double> chunk_scores;
+        // Computing the word vectors ourselves with our own scratch space is what lets
+        // all the worker threads share a single copy of the model.
+        ner.predict(tokens, sentence_to_feats(fe, tokens, scratch), chunks, chunk_tags, chunk_scores, fe);
+        result.num_tokens += tokens.size();
+
+        if (binary_output)
+        {
+            dlib::serialize(chunks, sout);
+            dlib::serialize(chunk_tags, sout);
+            continue;
+        }
+
+        // Push an empty chunk onto the end so we can avoid complicated bounds checking in
+        // the following loop.
+        chunks.push_back(make_pair(tokens.size()+1, tokens.size()+1));
+
+        unsigned long next = 0;
+        for (unsigned long i = 0; i <= tokens.size(); ++i)
+        {
+            if (i == chunks[next].second)
+            {
+                sout << "] ";
+                ++next;
+            }
+            if (i == tokens.size())
+                break;
+
+            if (i == chunks[next].first)
+                sout << "[" << tags[chunk_tags[next]] << " ";
+            sout << tokens[i];
+            if (i+1 != chunks[next].second)
+                sout << " ";
+        }
+        sout << "\n";
+    }
+    result.text = sout.str();
+}
+
+// ----------------------------------------------------------------------------------------
+
+struct stream_state
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            The state shared by the stages of the threaded pipeline.  The reader fills
+            in_queue, the workers move batches from in_queue to out_queue, and the
+            writer empties out_queue.  Both pipes are bounded so a fast reader can't run
+            ahead of the workers and use unbounded amounts of memory.
+
+            The pipes alone don't bound the writer's reorder buffer though.  If one
+            worker is stuck on a slow batch the others keep finishing batches that the
+            writer must hold until the slow one is done.  So the reader also takes one
+            of max_in_flight slots before sending each batch, and the writer gives it
+            back once the batch has been written.  That caps the number of batches
+            anywhere in the pipeline, including the ones waiting to be written.
+    !*/
+    stream_state (
+        const named_entity_extractor& ner_,
+        bool binary_output_,
+        std::ostream& out_,
+        unsigned long queue_size,
+        unsigned long num_threads
+    ) : ner(ner_), tags(ner_.get_tag_name_strings()), binary_output(binary_output_), out(out_),
+        in_queue(queue_size), out_queue(queue_size),
+        max_in_flight(2*queue_size + num_threads), num_in_flight(0), slot_signal(slot_mutex),
+        num_lines(0), num_tokens(0) {}
+
+    void take_slot (
+    )
+    /*!
+        ensures
+            - blocks until fewer than max_in_flight batches are in the pipeline and then
+              counts one more.
+    !*/
+    {
+        auto_mutex lock(slot_mutex);
+        while (num_in_flight >= max_in_flight)
+            slot_signal.wait();
+        ++num_in_flight;
+    }
+
+    void give_back_slot (
+    )
+    {
+        auto_mutex lock(slot_mutex);
+        --num_in_flight;
+        slot_signal.signal();
+    }
+
+    const named_entity_extractor& ner;
+    const std::vector<std::string> tags;
+    const bool binary_output;
+    std::ostream& out;
+
+    dlib::pipe<line_batch> in_queue;
+    dlib::pipe<output_batch> out_queue;
+
+    const unsigned long max_in_flight;
+    unsigned long num_in_flight;
+    dlib::mutex slot_mutex;
+    dlib::signaler slot_signal;
+
+    dlib::mutex error_mutex;
+    std::string error_message;
+
+    // These are only touched by the writer until it has finished.
+    unsigned long num_lines;
+    unsigned long num_tokens;
+};
+
+void worker_thread (
+    stream_state* state
+)
+{
+    std::vector<dlib::uint16> scratch;
+    line_batch batch;
+    output_batch result;
+    while (state->in_queue.dequeue(batch))
+    {
+        try
+        {
+            process_batch(state->ner, state->tags, state->binary_output, scratch, batch, result);
+        }
+        catch (std::exception& e)
+        {
+            // Keep going so the writer isn't left waiting on this batch forever.  The
+            // error is reported once everything has finished.
+            auto_mutex lock(state->error_mutex);
+            if (state->error_message.size() == 0)
+                state->error_message = e.what();
+            result = output_batch();
+            result.id = batch.id;
+        }
+        state->out_queue.enqueue(result);
+    }
+}
+
+void writer_thread (
+    stream_state* state
+)
+{
+    // Batches can come out of the workers in any order, so hold onto the early ones
+    // until everything before them has been written.
+    std::map<unsigned long, output_batch> pending;
+    unsigned long next_id = 0;
+    output_batch result;
+    while (state->out_queue.dequeue(result))
+    {
+        swap(pending[result.id], result);
+        std::map<unsigned long, output_batch>::iterator i;
+        while ((i = pending.find(next_id)) != pending.end())
+        {
+            state->out << i->second.text;
+            state->num_lines += i->second.num_lines;
+            state->num_tokens += i->second.num_tokens;
+            pending.erase(i);
+            ++next_id;
+            state->give_back_slot();
+        }
+        state->out.flush();
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void run_ner (
+    const named_entity_extractor& ner,
+    std::istream& in,
+    std::ostream& out,
+    bool binary_output,
+    unsigned long num_threads,
+    unsigned long batch_size
+)
+/*!
+    requires
+        - num_threads > 0
+        - batch_size > 0
+    ensures
+        - Reads lines from in until EOF, runs the NER on each of them, and writes the
+          results to out in the same order as the input.
+        - if (num_threads > 1) then
+            - This is done with a pipeline made of this thread reading the input,
+              num_threads worker threads running the NER, and another thread writing
+              the output.
+        - prints throughput statistics to cerr when finished.
+!*/
+{
+    timestamper ts;
+    const dlib::uint64 start = ts.get_timestamp();
+    unsigned long num_lines = 0;
+    unsigned long num_tokens = 0;
+
+    if (num_threads == 1)
+    {
+        const std::vector<std::string> tags = ner.get_tag_name_strings();
+        std::vector<dlib::uint16> scratch;
+        line_batch batch;
+        output_batch result;
+        batch.lines.resize(1);
+        while (getline(in, batch.lines[0]))
+        {
+            process_batch(ner, tags, binary_output, scratch, batch, result);
+            out << result.text << flush;
+            num_lines += result.num_lines;
+            num_tokens += result.num_tokens;
+        }
+    }
+    else
+    {
+        stream_state state(ner, binary_output, out, 2*num_threads, num_threads);
+
+        std::vector<dlib::shared_ptr<thread_function> > workers;
+        for (unsigned long i = 0; i < num_threads; ++i)
+            workers.push_back(dlib::shared_ptr<thread_function>(new thread_function(worker_thread, &state)));
+        thread_function writer(writer_thread, &state);
+
+        line_batch batch;
+        unsigned long next_id = 0;
+        std::string line;
+        while (true)
+        {
+            batch.id = next_id;
+            batch.lines.clear();
+            while (batch.lines.size() < batch_size && getline(in, line))
+            {
+                batch.lines.push_back(line);
+            }
+            if (batch.lines.size() == 0)
+                break;
+            state.take_slot();
+            state.in_queue.enqueue(batch);
+            ++next_id;
+        }
+
+        // Let the workers drain the input queue and exit, then do the same for the
+        // writer.
+        state.in_queue.wait_until_empty();
+        state.in_queue.disable();
+        for (unsigned long i = 0; i < workers.size(); ++i)
+            workers[i]->wait();
+        state.out_queue.wait_until_empty();
+        state.out_queue.disable();
+        writer.wait();
+
+        if (state.error_message.size() != 0)
+            throw dlib::error(state.error_message);
+
+        num_lines = state.num_lines;
+        num_tokens = state.num_tokens;
+    }
+
+    const double seconds = std::max<double>(1e-6, (ts.get_timestamp() - start)/1e6);
+    cerr << "processed " << num_lines << " lines (" << num_tokens << " tokens) in "
+         << seconds << " seconds" << endl;
+    cerr << "lines/sec:  " << num_lines/seconds << endl;
+    cerr << "tokens/sec: " << num_tokens/seconds << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
 int main(int argc, char** argv)
 {
     try
@@ -40,10 +378,16 @@ int main(int argc, char** argv)
         parser.add_option("h", "Display this help information.");
         parser.add_option("o", "Output the results to a file named <arg>.  The contents will be saved "
             "using dlib's serialization format. ",1);
+        parser.add_option("threads", "Run the NER using <arg> worker threads (default: 1).  The output "
+            "is still written in the same order as the input.",1);
+        parser.add_option("batch-size", "When using more than one thread, give each worker <arg> lines "
+            "at a time (default: 64).",1);
 
         parser.parse(argc, argv);
-        const char* one_time_ops[] = {"o", "h"};
+        const char* one_time_ops[] = {"o", "h", "threads", "batch-size"};
         parser.check_one_time_options(one_time_ops);
+        parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_option_arg_range("batch-size", 1, 1000000);
         if (parser.option("h"))
         {
             cout << "Usage: cat input_file.txt | ner_stream <options> MITIE-models/english/ner_model.dat" << endl;
@@ -56,6 +400,8 @@ int main(int argc, char** argv)
             return 1;
         }
 
+        const unsigned long num_threads = get_option(parser, "threads", 1);
+        const unsigned long batch_size = get_option(parser, "batch-size", 64);
 
         string classname;
         named_entity_extractor ner;
@@ -73,52 +419,11 @@ int main(int argc, char** argv)
             const string filename = parser.option("o").argument();
             cerr << "saving results to file " << filename << endl;
             ofstream fout(filename.c_str(), ios::binary);
-            std::string line;
-            while (getline(cin, line))
-            {
-                std::vector<std::pair<unsigned long, unsigned long> > chunks;
-                std::vector<unsigned long> chunk_tags;
-
-                ner(tokenize(line), chunks, chunk_tags);
-                dlib::serialize(chunks, fout);
-                dlib::serialize(chunk_tags, fout);
-            }
+            run_ner(ner, cin, fout, true, num_threads, batch_size);
         }
         else
         {
-            const std::vector<std::string> tags = ner.get_tag_name_strings();
-
-            string line;
-            while (getline(cin, line))
-            {
-                std::vector<std::string> tokens = tokenize(line);
-                std::vector<std::pair<unsigned long, unsigned long> > chunks;
-                std::vector<unsigned long> chunk_tags;
-                ner(tokens, chunks, chunk_tags);
-
-                // Push an empty chunk onto the end so we can avoid complicated bounds checking in
-                // the following loop.
-                chunks.push_back(make_pair(tokens.size()+1, tokens.size()+1));
-
-                unsigned long next = 0;
-                for (unsigned long i = 0; i <= tokens.size(); ++i)
-                {
-                    if (i == chunks[next].second)
-                    {
-                        cout << "] ";
-                        ++next;
-                    }
-                    if (i == tokens.size())
-                        break;
-
-                    if (i == chunks[next].first)
-                        cout << "[" << tags[chunk_tags[next]] << " ";
-                    cout << tokens[i];
-                    if (i+1 != chunks[next].second)
-                        cout << " ";
-                }
-                cout << endl;
-            }
+            run_ner(ner, cin, cout, false, num_threads, batch_size);
         }
 
     }
@@ -128,4 +433,3 @@ int main(int argc, char** argv)
         return 1;
     }
 }
-
@@ -3,11 +3,14 @@
 // Authors: Davis E. King (davis@dlib.net)
 
 #include "basic_morph.h"
-#include <mitie/count_min_sketch.h>
+#include "stage_manifest.h"
 #include <string>
 #include <vector>
 #include <map>
-#include <dlib/set.h>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <dlib/threads.h>
 #include <mitie/approximate_substring_set.h>
 
 using namespace std;
@@ -44,83 +47,220 @@ inline void populate_substr (
 
 // ----------------------------------------------------------------------------------------
 
-void get_most_common_substrings (
-    const std::map<std::string, unsigned long>& words,
-    std::vector<std::pair<unsigned long, std::string> >& substrs,
-    const unsigned long max_num_parts 
+inline dlib::uint64 pack_substr (
+    const std::string& substr
 )
 /*!
+    requires
+        - substr.size() <= 8
+        - substr doesn't contain any '\0' characters.
     ensures
-        - #substrs.size() <= max_num_parts
-        - for all valid i:
-            - #substrs[i].first == the number of times the substring #substrs[i].second was observed.
+        - returns substr packed into an integer, one character per byte.  Since the
+          substrings made by populate_substr() are never longer than 7 characters this
+          lets us count them by sorting integers rather than strings.
 !*/
 {
-    substrs.clear();
-    mitie::count_min_sketch counts(10000000);
+    dlib::uint64 key = 0;
+    for (unsigned long i = 0; i < substr.size(); ++i)
+        key |= static_cast<dlib::uint64>(static_cast<unsigned char>(substr[i])) << (8*i);
+    return key;
+}
+
+inline std::string unpack_substr (
+    dlib::uint64 key
+)
+/*!
+    ensures
+        - returns the string s such that pack_substr(s) == key.
+!*/
+{
+    std::string substr;
+    while (key != 0)
+    {
+        substr += static_cast<char>(key&0xFF);
+        key >>= 8;
+    }
+    return substr;
+}
+
+// ----------------------------------------------------------------------------------------
+
+class substring_counter
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object finds the most common substrings of a set of words using several
+            threads.  It works in two data parallel stages:
+                - count_shard() enumerates the substrings of one contiguous shard of the
+                  words.  The substrings are packed into integers with pack_substr() and
+                  each one is put into one of get_num_shards() buckets based on a hash
+                  of its value.  So every occurrence of a given substring ends up in the
+                  same bucket, no matter which shard it came from.
+                - select_bucket() merges one bucket across all the shards, sorts it so
+                  the copies of each substring are adjacent, and then counts them.  Each
+                  bucket keeps its own top max_num_parts substrings.
+            Since each bucket holds all the occurrences of its substrings, the counts are
+            exact and the overall most common substrings are just the most common of the
+            per bucket winners.
+
+            Ties are broken by the packed substring value so the output doesn't depend
+            on the number of threads.
+    !*/
+
+public:
+
+    typedef std::pair<unsigned long, dlib::uint64> count_type;
+
+    substring_counter (
+        const std::vector<std::string>& words_,
+        const unsigned long num_shards,
+        const unsigned long max_num_parts_
+    ) : words(words_), max_num_parts(max_num_parts_), keys(num_shards), best(num_shards)
+    {
+        for (unsigned long i = 0; i < num_shards; ++i)
+            keys[i].resize(num_shards);
+    }
 
-    // Note that we use * to denote the start or end of a string.
+    unsigned long get_num_shards (
+    ) const { return keys.size(); }
 
-    std::string temp;
-    for (std::map<std::string, unsigned long>::const_iterator i = words.begin(); i != words.end(); ++i)
+    void count_shard (
+        long idx
+    )
     {
-        for (unsigned long k = 0; k < i->first.size(); ++k)
+        // Note that we use * to denote the start or end of a string.
+        std::vector<std::vector<dlib::uint64> >& buckets = keys[idx];
+        const unsigned long begin = words.size()*idx/get_num_shards();
+        const unsigned long end = words.size()*(idx+1)/get_num_shards();
+        std::string temp;
+        for (unsigned long i = begin; i < end; ++i)
         {
-            for (unsigned long l = 1; l <= 5; ++l)
+            for (unsigned long k = 0; k < words[i].size(); ++k)
             {
-                if (k+l > i->first.size())
-                    break;
+                for (unsigned long l = 1; l <= 5; ++l)
+                {
+                    if (k+l > words[i].size())
+                        break;
 
-                populate_substr(i->first, temp, k, l);
-                if (temp.size() <= 1)
-                    continue;
+                    populate_substr(words[i], temp, k, l);
+                    if (temp.size() <= 1)
+                        continue;
 
-                counts.increment(temp);
+                    const dlib::uint64 key = pack_substr(temp);
+                    buckets[get_bucket(key)].push_back(key);
+                }
             }
         }
     }
 
-    dlib::set<std::string>::kernel_1a cur_words;
-
-    std::priority_queue<std::pair<long,std::string> > best_parts;
-    for (std::map<std::string, unsigned long>::const_iterator i = words.begin(); i != words.end(); ++i)
+    void select_bucket (
+        long idx
+    )
+    /*!
+        requires
+            - all the shards have been counted.
+    !*/
     {
-        for (unsigned long k = 0; k < i->first.size(); ++k)
+        std::vector<dlib::uint64> bucket;
+        for (unsigned long i = 0; i < keys.size(); ++i)
         {
-            for (unsigned long l = 1; l <= 5; ++l)
-            {
-                if (k+l > i->first.size())
-                    break;
-
-                populate_substr(i->first, temp, k, l);
-                if (temp.size() <= 1)
-                    continue;
+            bucket.insert(bucket.end(), keys[i][idx].begin(), keys[i][idx].end());
+            // free RAM
+            std::vector<dlib::uint64>().swap(keys[i][idx]);
+        }
+        std::sort(bucket.begin(), bucket.end());
 
-                if (cur_words.is_member(temp))
-                    continue;
+        // a min-heap of the best substrings seen so far
+        std::priority_queue<count_type, std::vector<count_type>, std::greater<count_type> > best_parts;
+        for (unsigned long i = 0; i < bucket.size(); )
+        {
+            unsigned long j = i+1;
+            while (j < bucket.size() && bucket[j] == bucket[i])
+                ++j;
 
-                const long hits = counts.get_count(temp);
-                if (best_parts.size() < max_num_parts || hits > -best_parts.top().first)
-                {
-                    if (best_parts.size() >= max_num_parts)
-                    {
-                        cur_words.destroy(best_parts.top().second);
-                        best_parts.pop();
-                    }
-
-                    best_parts.push(std::make_pair(-hits, temp));
-                    cur_words.add(temp);
-                }
+            const count_type item(j-i, bucket[i]);
+            if (best_parts.size() < max_num_parts)
+            {
+                best_parts.push(item);
+            }
+            else if (best_parts.top() < item)
+            {
+                best_parts.pop();
+                best_parts.push(item);
             }
+            i = j;
+        }
+
+        while (best_parts.size() != 0)
+        {
+            best[idx].push_back(best_parts.top());
+            best_parts.pop();
         }
     }
 
-    while (best_parts.size() != 0)
+    void get_most_common_substrings (
+        std::vector<std::pair<unsigned long, std::string> >& substrs
+    ) const
+    /*!
+        requires
+            - all the buckets have been selected.
+    !*/
     {
-        substrs.push_back(make_pair(-best_parts.top().first, best_parts.top().second));
-        best_parts.pop();
+        std::vector<count_type> all;
+        for (unsigned long i = 0; i < best.size(); ++i)
+            all.insert(all.end(), best[i].begin(), best[i].end());
+        std::sort(all.rbegin(), all.rend());
+
+        substrs.clear();
+        for (unsigned long i = 0; i < all.size() && i < max_num_parts; ++i)
+            substrs.push_back(make_pair(all[i].first, unpack_substr(all[i].second)));
     }
 
+private:
+
+    unsigned long get_bucket (
+        dlib::uint64 key
+    ) const
+    {
+        // mix the bits since the low bytes of a key are just its first few characters.
+        return ((key*0x9E3779B97F4A7C15ULL)>>32)%get_num_shards();
+    }
+
+    const std::vector<std::string>& words;
+    const unsigned long max_num_parts;
+    // keys[shard][bucket] == the substrings from shard which hash to bucket
+    std::vector<std::vector<std::vector<dlib::uint64> > > keys;
+    std::vector<std::vector<count_type> > best;
+};
+
+// ----------------------------------------------------------------------------------------
+
+void get_most_common_substrings (
+    const std::map<std::string, unsigned long>& words,
+    std::vector<std::pair<unsigned long, std::string> >& substrs,
+    const unsigned long max_num_parts,
+    const unsigned long num_threads
+)
+/*!
+    requires
+        - num_threads > 0
+    ensures
+        - #substrs.size() <= max_num_parts
+        - for all valid i:
+            - #substrs[i].first == the number of times the substring #substrs[i].second was observed.
+        - #substrs is sorted from most to least common substring.
+        - The work is split over num_threads threads.
+!*/
+{
+    std::vector<std::string> word_list;
+    word_list.reserve(words.size());
+    for (std::map<std::string, unsigned long>::const_iterator i = words.begin(); i != words.end(); ++i)
+        word_list.push_back(i->first);
+
+    substring_counter counter(word_list, num_threads, max_num_parts);
+    parallel_for(num_threads, 0, num_threads, counter, &substring_counter::count_shard, 1);
+    parallel_for(num_threads, 0, num_threads, counter, &substring_counter::select_bucket, 1);
+    counter.get_most_common_substrings(substrs);
 }
 
 // ----------------------------------------------------------------------------------------
@@ -171,12 +311,13 @@ void measure_substring_set_approximation_error(
 void basic_morph(const command_line_parser& parser)
 {
     std::map<std::string, unsigned long> words;
-    ifstream fin("top_word_counts.dat", ios::binary);
+    ifstream fin(get_work_file(parser, "top_word_counts.dat").c_str(), ios::binary);
     deserialize(words, fin);
     cout << "num words: "<< words.size() << endl;
 
+    const unsigned long num_threads = get_option(parser, "threads", 4);
     std::vector<std::pair<unsigned long,std::string> > substrs;
-    get_most_common_substrings(words, substrs, 20000);
+    get_most_common_substrings(words, substrs, 20000, num_threads);
     // sort the substrings so the least frequently used ones come first.  This way, when we
     // use the approximate substring set object it will most accurately represent the more
     // frequent substrings.
@@ -186,7 +327,7 @@ void basic_morph(const command_line_parser& parser)
     // always look to see if a string has a single number anywhere in it.
     substrs.push_back(make_pair(1, "#"));
 
-    ofstream fout_log("substrings.txt");
+    ofstream fout_log(get_work_file(parser, "substrings.txt").c_str());
     approximate_substring_set substrs_set;
     std::vector<dlib::uint16> substr_ids;
     for (unsigned long i = 0; i < substrs.size(); ++i)
@@ -198,7 +339,7 @@ void basic_morph(const command_line_parser& parser)
 
     //measure_substring_set_approximation_error(substrs, substr_ids, substrs_set);
 
-    ofstream fout("substring_set.dat", ios::binary);
+    ofstream fout(get_work_file(parser, "substring_set.dat").c_str(), ios::binary);
     serialize(substrs_set, fout);
 }
 
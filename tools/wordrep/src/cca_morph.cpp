@@ -3,9 +3,11 @@
 // Authors: Davis E. King (davis@dlib.net)
 
 #include "cca_morph.h"
+#include "stage_manifest.h"
 #include <map>
 #include <dlib/matrix.h>
 #include <dlib/statistics.h>
+#include <dlib/threads.h>
 #include <mitie/approximate_substring_set.h>
 #include <mitie/total_word_feature_extractor.h>
 
@@ -29,32 +31,76 @@ sparse_vector_type dense_to_sparse (
 
 // ----------------------------------------------------------------------------------------
 
+class morphology_vector_builder
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object makes the inputs to the word <-> morphology CCA using several
+            threads.  For each word it converts the word's vector into a sparse vector
+            and finds the substrings of the word that are in the substring set.  Each
+            word only writes to its own slot of the outputs, so the words can be
+            processed in any order by any thread.
+    !*/
+
+public:
+
+    morphology_vector_builder (
+        const approximate_substring_set& substrs_,
+        const std::map<std::string, matrix<float,0,1> >& word_vectors,
+        std::vector<sparse_vector_type>& L_,
+        std::vector<sparse_vector_type>& R_
+    ) : substrs(substrs_), L(L_), R(R_)
+    {
+        std::map<std::string, matrix<float,0,1> >::const_iterator i;
+        for (i = word_vectors.begin(); i != word_vectors.end(); ++i)
+            words.push_back(i);
+        L.assign(words.size(), sparse_vector_type());
+        R.assign(words.size(), sparse_vector_type());
+    }
+
+    unsigned long size (
+    ) const { return words.size(); }
+
+    void build_range (
+        long begin,
+        long end
+    )
+    {
+        std::vector<dlib::uint16> hits;
+        for (long i = begin; i < end; ++i)
+        {
+            L[i] = dense_to_sparse(words[i]->second);
+            substrs.find_substrings(words[i]->first, hits);
+            sparse_vector_type& temp = R[i];
+            for (unsigned long j = 0; j < hits.size(); ++j)
+                temp.push_back(make_pair(hits[j],1));
+            make_sparse_vector_inplace(temp);
+        }
+    }
+
+private:
+
+    const approximate_substring_set& substrs;
+    std::vector<std::map<std::string, matrix<float,0,1> >::const_iterator> words;
+    std::vector<sparse_vector_type>& L;
+    std::vector<sparse_vector_type>& R;
+};
+
+// ----------------------------------------------------------------------------------------
+
 void learn_morphological_dimension_reduction (
     const approximate_substring_set& substrs,
     const std::map<std::string, matrix<float,0,1> >& word_vectors,
     const long num_correlations,
+    const unsigned long num_threads,
     matrix<float>& morph_trans
 )
 {
-    std::map<std::string, matrix<float,0,1> >::const_iterator i;
-
-
     std::vector<sparse_vector_type> L, R;
 
-    sparse_vector_type temp;
-    std::vector<dlib::uint16> hits;
-    
     cout << "building morphological vectors" << endl;
-    for (i = word_vectors.begin(); i != word_vectors.end(); ++i)
-    {
-        L.push_back(dense_to_sparse(i->second));
-        substrs.find_substrings(i->first, hits);
-        temp.clear();
-        for (unsigned long i = 0; i < hits.size(); ++i)
-            temp.push_back(make_pair(hits[i],1));
-        make_sparse_vector_inplace(temp);
-        R.push_back(temp);
-    }
+    morphology_vector_builder builder(substrs, word_vectors, L, R);
+    parallel_for_blocked(num_threads, 0, builder.size(), builder, &morphology_vector_builder::build_range);
     cout << "L.size(): " << L.size() << endl;
     cout << "R.size(): " << R.size() << endl;
 
@@ -70,19 +116,20 @@ void cca_morph(const dlib::command_line_parser& parser)
 {
     const long num_morph_correlations = 90;
 
-    std::ifstream fin("word_vects.dat", ios::binary);
+    std::ifstream fin(get_work_file(parser, "word_vects.dat").c_str(), ios::binary);
     std::map<std::string, matrix<float,0,1> > word_vectors;
     deserialize(word_vectors, fin);
     cout << "num word vectors loaded: " << word_vectors.size() << endl;
     cout << "got word vectors, now learn how they correlate with morphological features." << endl;
 
     fin.close();
-    fin.open("substring_set.dat", ios::binary);
+    fin.open(get_work_file(parser, "substring_set.dat").c_str(), ios::binary);
     approximate_substring_set substring_set;
     deserialize(substring_set, fin);
 
+    const unsigned long num_threads = get_option(parser, "threads", 4);
     matrix<float> morph_trans;
-    learn_morphological_dimension_reduction(substring_set, word_vectors, num_morph_correlations, morph_trans);
+    learn_morphological_dimension_reduction(substring_set, word_vectors, num_morph_correlations, num_threads, morph_trans);
 
     // morph_trans should have a row for every possible output from substring_set.  But
     // since we work with sparse vectors and some outputs might not have been observed in
@@ -98,12 +145,12 @@ void cca_morph(const dlib::command_line_parser& parser)
     word_morphology_feature_extractor fe(substring_set, morph_trans);
     cout << "morphological feature dimensionality: "<< fe.get_num_dimensions() << endl;
 
-    ofstream fout("word_morph_feature_extractor.dat", ios::binary);
+    ofstream fout(get_work_file(parser, "word_morph_feature_extractor.dat").c_str(), ios::binary);
     serialize(fe, fout);
 
     total_word_feature_extractor tfe(word_vectors, fe);
     cout << "total word feature dimensionality: "<< tfe.get_num_dimensions() << endl;
-    serialize("total_word_feature_extractor.dat") << "mitie::total_word_feature_extractor" << tfe;
+    serialize(get_work_file(parser, "total_word_feature_extractor.dat")) << "mitie::total_word_feature_extractor" << tfe;
 }
 
 // ----------------------------------------------------------------------------------------
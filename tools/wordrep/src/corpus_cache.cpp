@@ -0,0 +1,272 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "corpus_cache.h"
+#include "word_vects.h"
+#include "stage_manifest.h"
+#include <dlib/dir_nav.h>
+#include <dlib/serialize.h>
+#include <dlib/vectorstream.h>
+#include <mitie/parallel_group_tokenizer.h>
+#include <mitie/unigram_tokenizer.h>
+#include <fstream>
+#include <cstdio>
+#include <map>
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+namespace
+{
+    void get_corpus_files (
+        const command_line_parser& parser,
+        std::vector<dlib::file>& files,
+        std::vector<std::string>& names,
+        std::vector<uint64>& sizes
+    )
+    {
+        files = get_files_in_directory_tree(directory(parser[0]), match_all());
+        names.clear();
+        sizes.clear();
+        for (unsigned long i = 0; i < files.size(); ++i)
+        {
+            names.push_back(files[i].full_name());
+            sizes.push_back(files[i].size());
+        }
+    }
+
+    void get_cache_vocabulary (
+        const command_line_parser& parser,
+        std::vector<std::string>& vocab,
+        std::map<std::string, unsigned long>& words
+    )
+    {
+        ifstream fin(get_work_file(parser, "top_word_counts.dat").c_str(), ios::binary);
+        deserialize(words, fin);
+
+        // Give the most common word ID 0, the next most common ID 1, and so on.
+        words = make_word_to_int_mapping(words, words.size());
+        vocab.assign(words.size(), std::string());
+        for (std::map<std::string,unsigned long>::iterator i = words.begin(); i != words.end(); ++i)
+            vocab[i->second] = i->first;
+    }
+
+    void write_cache_header (
+        std::ostream& out,
+        const std::vector<std::string>& names,
+        const std::vector<uint64>& sizes,
+        const std::vector<std::string>& vocab
+    )
+    {
+        serialize(std::string("wordrep::corpus_cache"), out);
+        serialize(1, out);
+        serialize(names, out);
+        serialize(sizes, out);
+        serialize(vocab, out);
+    }
+
+    bool read_cache_header (
+        std::istream& in,
+        std::vector<std::string>& names,
+        std::vector<uint64>& sizes,
+        std::vector<std::string>& vocab
+    )
+    {
+        std::string classname;
+        int version = 0;
+        deserialize(classname, in);
+        if (classname != "wordrep::corpus_cache")
+            return false;
+        deserialize(version, in);
+        if (version != 1)
+            return false;
+        deserialize(names, in);
+        deserialize(sizes, in);
+        deserialize(vocab, in);
+        return true;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void cache_corpus(const command_line_parser& parser)
+{
+    std::vector<std::string> vocab;
+    std::map<std::string, unsigned long> words;
+    get_cache_vocabulary(parser, vocab, words);
+
+    std::vector<dlib::file> files;
+    std::vector<std::string> names;
+    std::vector<uint64> sizes;
+    get_corpus_files(parser, files, names, sizes);
+    cout << "Caching token IDs for " << files.size() << " files" << endl;
+
+    const unsigned long num_threads = get_option(parser, "threads", 4);
+    const unsigned long checkpoint_every = get_option(parser, "checkpoint-every", 1000);
+    const std::string checkpoint_file = get_work_file(parser, "corpus_tokens.checkpoint");
+    const std::string tokens_file = get_work_file(parser, "corpus_tokens.dat");
+    const std::string vocab_file = get_work_file(parser, "corpus_vocab.dat");
+
+    // Remove the old header first so a partially written cache is never mistaken for a
+    // complete one.
+    std::remove(vocab_file.c_str());
+
+    // If a previous call for the same files and vocabulary was interrupted then pick up
+    // after the last batch of files it finished.
+    unsigned long files_done = 0;
+    uint64 num_tokens = 0;
+    {
+        ifstream fin(checkpoint_file.c_str(), ios::binary);
+        std::vector<std::string> saved_names, saved_vocab;
+        std::vector<uint64> saved_sizes;
+        try
+        {
+            if (fin && read_cache_header(fin, saved_names, saved_sizes, saved_vocab) &&
+                saved_names == names && saved_sizes == sizes && saved_vocab == vocab)
+            {
+                deserialize(files_done, fin);
+                deserialize(num_tokens, fin);
+            }
+        }
+        catch (serialization_error&)
+        {
+            files_done = 0;
+            num_tokens = 0;
+        }
+    }
+
+    std::fstream fout;
+    if (files_done != 0)
+    {
+        // The tokens for the files after the checkpoint get written over whatever an
+        // interrupted run left there.  Since they are the same tokens the file never ends
+        // up longer than it should be.
+        fout.open(tokens_file.c_str(), ios::binary|ios::in|ios::out);
+        // make sure the tokens the checkpoint counts are really in the file.
+        fout.seekg(0, ios::end);
+        if (fout && static_cast<uint64>(fout.tellg()) >= num_tokens*sizeof(uint32))
+            fout.seekp(num_tokens*sizeof(uint32));
+        else
+            fout.close();
+    }
+    if (!fout.is_open() || !fout)
+    {
+        files_done = 0;
+        num_tokens = 0;
+        fout.close();
+        fout.clear();
+        fout.open(tokens_file.c_str(), ios::binary|ios::out|ios::trunc);
+    }
+    else
+    {
+        cout << "Resuming from " << checkpoint_file << " after " << files_done << " files" << endl;
+    }
+
+    std::vector<uint32> buf;
+    buf.reserve(1024*1024);
+    std::string token;
+    while (files_done < files.size())
+    {
+        const unsigned long end = std::min<unsigned long>(files.size(), files_done + checkpoint_every);
+        const std::vector<dlib::file> batch(files.begin()+files_done, files.begin()+end);
+        parallel_group_tokenizer<text_file_tokenizer<unigram_tokenizer> > tok(batch, num_threads);
+        while (tok(token))
+        {
+            std::map<std::string,unsigned long>::const_iterator i = words.find(token);
+            buf.push_back(i != words.end() ? i->second : corpus_oov_id);
+            if (buf.size() == buf.capacity())
+            {
+                fout.write((const char*)&buf[0], buf.size()*sizeof(uint32));
+                num_tokens += buf.size();
+                buf.clear();
+            }
+        }
+        if (buf.size() != 0)
+            fout.write((const char*)&buf[0], buf.size()*sizeof(uint32));
+        num_tokens += buf.size();
+        buf.clear();
+        files_done = end;
+
+        if (files_done < files.size())
+        {
+            fout.flush();
+            if (!fout)
+                throw dlib::error("Error writing " + tokens_file);
+            std::vector<char> temp;
+            vectorstream sout(temp);
+            write_cache_header(sout, names, sizes, vocab);
+            serialize(files_done, sout);
+            serialize(num_tokens, sout);
+            save_checkpoint_file(checkpoint_file, temp);
+            cout << "Cached " << files_done << " of " << files.size() << " files, saved " << checkpoint_file << endl;
+        }
+    }
+    fout.close();
+    if (!fout)
+        throw dlib::error("Error writing " + tokens_file);
+
+    // Write this last so that if we are interrupted the cache won't be used.
+    ofstream fvocab(vocab_file.c_str(), ios::binary);
+    write_cache_header(fvocab, names, sizes, vocab);
+    fvocab.close();
+    std::remove(checkpoint_file.c_str());
+    cout << "Cached " << num_tokens << " tokens with a vocabulary of " << vocab.size() << " words." << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+corpus_cache::
+corpus_cache (
+    const command_line_parser& parser
+)
+{
+    std::vector<dlib::file> files;
+    std::vector<std::string> names, cached_names;
+    std::vector<uint64> sizes, cached_sizes;
+    get_corpus_files(parser, files, names, sizes);
+    std::vector<std::string> expected_vocab;
+    std::map<std::string, unsigned long> words;
+    get_cache_vocabulary(parser, expected_vocab, words);
+    const std::string tokens_file = get_work_file(parser, "corpus_tokens.dat");
+    const std::string vocab_file = get_work_file(parser, "corpus_vocab.dat");
+
+    // Only reuse the cache if it was made from the same files and word counts.
+    bool valid = false;
+    {
+        ifstream fin(vocab_file.c_str(), ios::binary);
+        try
+        {
+            if (fin)
+                valid = read_cache_header(fin, cached_names, cached_sizes, vocab) &&
+                        cached_names == names && cached_sizes == sizes && vocab == expected_vocab;
+        }
+        catch (serialization_error&)
+        {
+            valid = false;
+        }
+    }
+
+    if (!valid)
+    {
+        cache_corpus(parser);
+        ifstream fin(vocab_file.c_str(), ios::binary);
+        read_cache_header(fin, cached_names, cached_sizes, vocab);
+    }
+    else
+    {
+        cout << "Using existing corpus cache in " << tokens_file << endl;
+    }
+
+    tokens.reset(new mapped_file(tokens_file));
+    num_files = cached_names.size();
+    // The header holds the file names and sizes and the vocabulary, which determine the
+    // token IDs, so it's enough to identify the cache.
+    signature = get_file_hash(vocab_file);
+}
+
+// ----------------------------------------------------------------------------------------
+
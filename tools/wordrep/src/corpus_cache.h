@@ -0,0 +1,127 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_CORPUS_CaCHE_H_
+#define MIT_LL_CORPUS_CaCHE_H_
+
+#include <dlib/cmd_line_parser.h>
+#include <dlib/uintn.h>
+#include <dlib/smart_pointers.h>
+#include <mitie/mapped_file.h>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------------------
+
+// The ID used in the corpus cache for words that aren't in its vocabulary.
+const dlib::uint32 corpus_oov_id = 0xFFFFFFFF;
+
+inline unsigned long get_word_id (
+    const unsigned long vocab_size,
+    const dlib::uint32 id
+)
+/*!
+    ensures
+        - returns the index of a corpus cache token ID within a vocabulary made of the
+          vocab_size most common words.  IDs outside that vocabulary, including
+          corpus_oov_id, all map to vocab_size.
+!*/
+{
+    if (id < vocab_size)
+        return id;
+    else
+        return vocab_size;
+}
+
+void cache_corpus(const dlib::command_line_parser& parser);
+/*!
+    requires
+        - top_word_counts.dat exists (i.e. count_words() has been run).  This file, and
+          all the files below, are in the --work-dir folder.
+    ensures
+        - Tokenizes the folder of text files given by parser[0] and saves it as a
+          corpus cache.  That is, the vocabulary in top_word_counts.dat is sorted from
+          most to least common word and each word is given its position in that list as
+          its ID.  Then the corpus is written to corpus_tokens.dat as a flat array of
+          native endian uint32 IDs, with words outside the vocabulary written as
+          corpus_oov_id.  The vocabulary itself, along with the list of input files, is
+          saved to corpus_vocab.dat.
+!*/
+
+// ----------------------------------------------------------------------------------------
+
+class corpus_cache : dlib::noncopyable
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object provides read only access to a corpus saved by cache_corpus().
+            The token IDs are memory mapped, so walking the whole corpus is a linear scan
+            over an array of integers rather than a pass over the raw text that
+            tokenizes it and looks up each word in a std::map.
+
+            Since IDs are assigned from most to least common word, the IDs of the N most
+            common words are 0 through N-1.  So restricting the vocabulary to the top N
+            words is just a matter of treating every ID >= N as out of vocabulary.
+    !*/
+
+public:
+
+    explicit corpus_cache (
+        const dlib::command_line_parser& parser
+    );
+    /*!
+        ensures
+            - Opens the corpus cache for the folder of text files given by parser[0].
+              If the cache doesn't exist, or it was made from a different set of files,
+              then it is first rebuilt by calling cache_corpus(parser).
+    !*/
+
+    const dlib::uint32* begin (
+    ) const { return reinterpret_cast<const dlib::uint32*>(tokens->data()); }
+
+    const dlib::uint32* end (
+    ) const { return begin() + size(); }
+
+    dlib::uint64 size (
+    ) const { return tokens->size()/sizeof(dlib::uint32); }
+    /*!
+        ensures
+            - returns the number of tokens in the corpus.
+    !*/
+
+    const std::vector<std::string>& get_vocabulary (
+    ) const { return vocab; }
+    /*!
+        ensures
+            - returns the words in the cache vocabulary.  In particular, the word with ID
+              i is get_vocabulary()[i].
+    !*/
+
+    unsigned long get_num_files (
+    ) const { return num_files; }
+    /*!
+        ensures
+            - returns the number of text files the corpus was made from.
+    !*/
+
+    const std::string& get_signature (
+    ) const { return signature; }
+    /*!
+        ensures
+            - returns a hash identifying the cache's contents, i.e. the files it was
+              made from and its vocabulary.  Checkpoints of passes over the cache store
+              this so they aren't resumed on a different corpus.
+    !*/
+
+private:
+
+    std::vector<std::string> vocab;
+    unsigned long num_files;
+    std::string signature;
+    dlib::scoped_ptr<mitie::mapped_file> tokens;
+};
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MIT_LL_CORPUS_CaCHE_H_
+
@@ -2,11 +2,11 @@
 // License: Boost Software License   See LICENSE.txt for the full license.
 // Authors: Davis E. King (davis@dlib.net)
 #include "doc_vects.h"
+#include "stage_manifest.h"
 #include <dlib/matrix.h>
 #include <dlib/statistics.h>
 #include <map>
-#include <mitie/group_tokenizer.h>
-#include <mitie/gigaword_reader.h>
+#include <mitie/parallel_group_tokenizer.h>
 #include <mitie/unigram_tokenizer.h>
 
 using namespace std;
@@ -59,7 +59,7 @@ static std::map<std::string, unsigned long> make_word_to_int_mapping (
 
 void gigaword_doc_to_vects (
     const std::map<std::string, unsigned long>& words,
-    const gigaword_document& doc,
+    const std::string& doc,
     sparse_vector_type& lhs,
     sparse_vector_type& rhs,
     dlib::rand& rnd
@@ -67,7 +67,7 @@ void gigaword_doc_to_vects (
 {
     lhs.clear();
     rhs.clear();
-    istringstream sin(doc.text + " " + doc.headline);
+    istringstream sin(doc);
     unigram_tokenizer tok(sin);
     string word;
     while (tok(word))
@@ -95,7 +95,7 @@ void make_doc_vects(const dlib::command_line_parser& parser)
     const long num_contexts = 40000000;
     const long num_correlations = get_option(parser, "dims", 500);
 
-    ifstream fin("top_word_counts.dat", ios::binary);
+    ifstream fin(get_work_file(parser, "top_word_counts.dat").c_str(), ios::binary);
     std::map<std::string, unsigned long> words;
     deserialize(words, fin);
     cout << "num words in dictionary: " << words.size() << endl;
@@ -104,14 +104,17 @@ void make_doc_vects(const dlib::command_line_parser& parser)
 
     std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
     cout << "number of gigaword XML files found: " << files.size() << endl;
-    gigaword_reader reader(files);
+    // Each "token" is the text and headline of one whole document.  The XML parsing
+    // is the slow part, so it's done on several threads.
+    parallel_group_tokenizer<gigaword_file_document_tokenizer> reader(files,
+        gigaword_file_document_tokenizer(true), get_option(parser, "threads", 4));
 
     random_subset_selector<sparse_vector_type> L, R;
     L.set_max_size(num_contexts);
     R.set_max_size(num_contexts);
 
     // read a bunch of document vectors out of the gigaword corpus
-    gigaword_document doc;
+    std::string doc;
     sparse_vector_type lhs, rhs;
     dlib::rand rnd;
     while (reader(doc))
@@ -137,8 +140,9 @@ void make_doc_vects(const dlib::command_line_parser& parser)
         word_vectors[i->first] = trans(rowm(Ltrans, get_word_id(words, i->first)));
     }
 
-    cout << "Saving word to vector map to doc_vects.dat file..." << endl;
-    std::ofstream fout("doc_vects.dat", ios::binary);
+    const std::string out_file = get_work_file(parser, "doc_vects.dat");
+    cout << "Saving word to vector map to " << out_file << " file..." << endl;
+    std::ofstream fout(out_file.c_str(), ios::binary);
     serialize(word_vectors, fout);
 }
 
@@ -0,0 +1,185 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "extend_vocab.h"
+#include "word_vects.h"
+#include "stage_manifest.h"
+#include <dlib/dir_nav.h>
+#include <dlib/statistics.h>
+#include <mitie/parallel_group_tokenizer.h>
+#include <mitie/unigram_tokenizer.h>
+#include <mitie/total_word_feature_extractor.h>
+#include <fstream>
+#include <map>
+#include <set>
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+namespace
+{
+    typedef parallel_group_tokenizer<text_file_tokenizer<unigram_tokenizer> > tokenizer_type;
+
+    double get_word_vector_scale (
+        const std::map<std::string, matrix<float,0,1> >& word_vectors
+    )
+    /*!
+        ensures
+            - returns the scale the total_word_feature_extractor constructor applies
+              to word_vectors.
+    !*/
+    {
+        running_stats<double> rs_word;
+        std::map<std::string, matrix<float,0,1> >::const_iterator i;
+        for (i = word_vectors.begin(); i != word_vectors.end(); ++i)
+            rs_word.add(mean(abs(i->second)));
+        return 1/rs_word.mean();
+    }
+
+    void find_new_words (
+        const std::vector<dlib::file>& files,
+        const unsigned long num_threads,
+        const total_word_feature_extractor& fe,
+        const unsigned long min_count,
+        std::map<std::string, unsigned long>& new_words
+    )
+    /*!
+        ensures
+            - #new_words == a map from each word in files which isn't in fe's
+              dictionary and appears at least min_count times to an integer ID.  The
+              IDs are 0, 1, 2, etc.
+    !*/
+    {
+        const std::vector<std::string> dict = fe.get_words_in_dictionary();
+        const std::set<std::string> known(dict.begin(), dict.end());
+
+        std::map<std::string, unsigned long> counts;
+        tokenizer_type tok(files, num_threads);
+        std::string token;
+        while (tok(token))
+        {
+            if (known.count(token) == 0)
+                counts[token] += 1;
+        }
+
+        new_words.clear();
+        for (std::map<std::string, unsigned long>::iterator i = counts.begin(); i != counts.end(); ++i)
+        {
+            if (i->second >= min_count)
+            {
+                const unsigned long id = new_words.size();
+                new_words[i->first] = id;
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void extend_vocab(const command_line_parser& parser)
+{
+    const std::string fe_filename = parser.option("extend-vocab").argument();
+    const unsigned long min_count = get_option(parser, "extend-min-count", 10);
+    const unsigned long num_threads = get_option(parser, "threads", 4);
+
+    string classname;
+    total_word_feature_extractor fe;
+    deserialize(fe_filename) >> classname >> fe;
+    cout << "words in dictionary: " << fe.get_num_words_in_dictionary() << endl;
+
+    long window_size;
+    std::vector<std::string> vocab;
+    matrix<float> Ltrans, Rtrans;
+    load_word_vects_cca(get_work_file(parser, "word_vects_cca.dat"), window_size, vocab, Ltrans, Rtrans);
+    const unsigned long vocab_size = vocab.size();
+
+    // The new vectors have to be scaled the same way the originals were when the
+    // extractor was made.
+    double scale;
+    {
+        std::map<std::string, matrix<float,0,1> > word_vectors;
+        ifstream fin(get_work_file(parser, "word_vects.dat").c_str(), ios::binary);
+        if (!fin)
+            throw dlib::error("Unable to open word_vects.dat.  It is made by --word-vects.");
+        deserialize(word_vectors, fin);
+        scale = get_word_vector_scale(word_vectors);
+    }
+
+    std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
+    cout << "number of raw ASCII files found: " << files.size() << endl;
+
+    std::map<std::string, unsigned long> new_words;
+    find_new_words(files, num_threads, fe, min_count, new_words);
+    cout << "new words seen at least " << min_count << " times: " << new_words.size() << endl;
+    if (new_words.size() == 0)
+    {
+        cout << "Nothing to add, so no extended extractor was saved." << endl;
+        return;
+    }
+
+    std::map<std::string, unsigned long> word_ids;
+    for (unsigned long i = 0; i < vocab_size; ++i)
+        word_ids[vocab[i]] = i;
+
+    // Now stream the corpus again and add up the projected context vectors of the new
+    // words.  window holds the last window_size tokens as (CCA word ID, new word ID)
+    // pairs and is used as a ring buffer with pos the slot of the oldest token.
+    const unsigned long no_word = new_words.size();
+    std::vector<std::pair<unsigned long, unsigned long> > window(window_size);
+    matrix<float> sums = zeros_matrix<float>(new_words.size(), Ltrans.nc()+Rtrans.nc());
+    std::vector<unsigned long> hits(new_words.size(), 0);
+    tokenizer_type tok(files, num_threads);
+    std::string token;
+    unsigned long num_tokens = 0;
+    unsigned long pos = 0;
+    while (tok(token))
+    {
+        std::map<std::string,unsigned long>::const_iterator i = word_ids.find(token);
+        std::map<std::string,unsigned long>::const_iterator j = new_words.find(token);
+        window[pos].first = (i != word_ids.end()) ? i->second : vocab_size;
+        window[pos].second = (j != new_words.end()) ? j->second : no_word;
+        pos = (pos+1)%window_size;
+        if (++num_tokens < (unsigned long)window_size)
+            continue;
+
+        const unsigned long center_word = window[(pos+window_size/2)%window_size].second;
+        if (center_word == no_word)
+            continue;
+
+        for (long s = 0; s < window_size/2; ++s)
+        {
+            const unsigned long w = window[(pos+s)%window_size].first;
+            set_subm(sums, center_word, 0, 1, Ltrans.nc()) += rowm(Ltrans, s*(vocab_size+1)+w);
+        }
+        long k = 0;
+        for (long s = window_size/2+1; s < window_size; ++s, ++k)
+        {
+            const unsigned long w = window[(pos+s)%window_size].first;
+            set_subm(sums, center_word, Ltrans.nc(), 1, Rtrans.nc()) += rowm(Rtrans, k*(vocab_size+1)+w);
+        }
+        hits[center_word] += 1;
+    }
+
+    std::map<std::string, matrix<float,0,1> > word_vectors;
+    for (std::map<std::string, unsigned long>::iterator i = new_words.begin(); i != new_words.end(); ++i)
+    {
+        if (hits[i->second] != 0)
+            word_vectors[i->first] = trans(rowm(sums, i->second))/hits[i->second];
+    }
+
+    const dlib::uint64 old_fingerprint = fe.get_fingerprint();
+    const unsigned long num_added = fe.add_words(word_vectors, scale);
+    cout << "added " << num_added << " words, the dictionary now has " << fe.get_num_words_in_dictionary() << " words." << endl;
+    cout << "NOTE: the fingerprint changed from " << old_fingerprint << " to " << fe.get_fingerprint()
+         << ".  Models trained with " << fe_filename << " must be retrained to use the extended extractor." << endl;
+    const std::string out_file = get_work_file(parser, "extended_total_word_feature_extractor.dat");
+    serialize(out_file) << "mitie::total_word_feature_extractor" << fe;
+    cout << "saved " << out_file << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
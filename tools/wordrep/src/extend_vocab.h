@@ -0,0 +1,29 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_EXTEND_VoCAB_H_
+#define MIT_LL_EXTEND_VoCAB_H_
+
+#include <dlib/cmd_line_parser.h>
+
+void extend_vocab(const dlib::command_line_parser& parser);
+/*!
+    requires
+        - word_vects_cca.dat and word_vects.dat exist in the --work-dir folder (i.e.
+          word_vects() has been run on the original corpus).
+    ensures
+        - Loads the total_word_feature_extractor in the file given by
+          parser.option("extend-vocab").argument() and adds distributional vectors for
+          the words in the folder of text files given by parser[0] that aren't in its
+          dictionary yet.  Only words seen at least extend-min-count times are added.
+        - A new word's vector is the average of the CCA projections of its context
+          windows, using the Ltrans and Rtrans saved in word_vects_cca.dat by the
+          original run.  So no CCA is done and only the new corpus is read.  The vector
+          is then scaled the same way the original word vectors were.
+        - The extended extractor is saved to extended_total_word_feature_extractor.dat.
+          Its fingerprint is different from the original extractor's, so any model
+          trained with the original extractor must be retrained to use it.
+!*/
+
+#endif // MIT_LL_EXTEND_VoCAB_H_
+
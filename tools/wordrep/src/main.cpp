@@ -4,14 +4,23 @@
 
 #include <iostream>
 #include <dlib/cmd_line_parser.h>
-#include <mitie/gigaword_reader.h>
+#include <mitie/parallel_group_tokenizer.h>
 #include <dlib/dir_nav.h>
-#include <mitie/count_min_sketch.h>
-#include <mitie/group_tokenizer.h>
+#include <mitie/concurrent_count_min_sketch.h>
+#include <mitie/space_saving.h>
+#include <dlib/threads.h>
+#include <dlib/misc_api.h>
+#include <set>
+#include <algorithm>
 #include <mitie/unigram_tokenizer.h>
+#include <dlib/vectorstream.h>
+#include <cstdio>
+#include "stage_manifest.h"
 #include "basic_morph.h"
 #include "word_vects.h"
+#include "corpus_cache.h"
 #include "cca_morph.h"
+#include "extend_vocab.h"
 #include "doc_vects.h"
 
 #include <mitie/total_word_feature_extractor.h>
@@ -26,59 +35,272 @@ using namespace mitie;
 
 // ----------------------------------------------------------------------------------------
 
-template <typename tokenizer_type>
-void get_top_word_counts (
-    tokenizer_type& tok,
-    std::map<std::string, unsigned long>& top_words,
-    const unsigned long max_top_words
-)
+class sharded_word_counter
 {
-    count_min_sketch counts(5000000);
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object counts the words in a set of text files using several threads.
+            Each thread (i.e. shard) pulls whole files off a shared list and counts their
+            words in one shared concurrent_count_min_sketch.  Each shard also keeps a
+            space_saving object holding the words it has seen with the largest counts,
+            which means the candidates for the top words are found as we go and there
+            is no need for a second pass over the corpus.
+
+            The files can be counted in several batches by calling set_file_range()
+            before each one, and the counts so far can be saved with serialize() in
+            between.  That lets a long count be resumed after it's interrupted.  The
+            saved state doesn't depend on the number of shards, so it can be resumed
+            with a different number of threads.
+    !*/
+
+public:
+
+    sharded_word_counter (
+        const std::vector<dlib::file>& files_,
+        unsigned long num_shards,
+        unsigned long num_candidates
+    ) : files(files_), next_file(0), end_file(files_.size()),
+        counts(5000000),
+        candidates(num_shards, space_saving<std::string>(num_candidates)),
+        empty_candidates(num_candidates)
+    {}
+
+    void clear (
+    )
+    /*!
+        ensures
+            - forgets all the words counted so far.
+    !*/
+    {
+        counts.set_counts_to_zero();
+        candidates.assign(candidates.size(), empty_candidates);
+        old_candidates.clear();
+    }
+
+    void set_file_range (
+        unsigned long begin,
+        unsigned long end
+    )
+    /*!
+        requires
+            - begin <= end <= the number of files
+        ensures
+            - the next calls to count_shard() will count files begin through end-1.
+    !*/
+    {
+        next_file = begin;
+        end_file = end;
+    }
+
+    void count_shard (
+        long idx
+    )
+    {
+        space_saving<std::string>& top = candidates[idx];
+        std::string token;
+        unsigned long i;
+        while (get_next_file(i))
+        {
+            ifstream fin(files[i].full_name().c_str());
+            unigram_tokenizer tok(fin);
+            while (tok(token))
+            {
+                top.update(token, counts.increment(token));
+            }
+        }
+    }
+
+    void get_top_words (
+        std::map<std::string, unsigned long>& top_words,
+        const unsigned long max_top_words
+    )
+    /*!
+        requires
+            - all the shards have been counted.
+        ensures
+            - combines the shards and stores the max_top_words most common words, along
+              with their counts, into top_words.
+    !*/
+    {
+        // Every shard tracks the words with the largest counts it has seen, so the top
+        // words are in the union of the candidates.  We rank the candidates using their
+        // final counts since a shard only knows a word's count as of the last time it saw
+        // that word.
+        std::set<std::string> words;
+        get_all_candidates(words);
+        for (unsigned long i = 0; i < candidates.size(); ++i)
+            candidates[i].clear();
+        old_candidates.clear();
+
+        std::vector<std::pair<dlib::int64, std::string> > best_words;
+        for (std::set<std::string>::iterator i = words.begin(); i != words.end(); ++i)
+            best_words.push_back(std::make_pair(-static_cast<dlib::int64>(counts.get_count(*i)), *i));
+        const unsigned long num = std::min<unsigned long>(max_top_words, best_words.size());
+        std::partial_sort(best_words.begin(), best_words.begin()+num, best_words.end());
+
+        top_words.clear();
+        for (unsigned long i = 0; i < num; ++i)
+            top_words[best_words[i].second] = -best_words[i].first;
+    }
+
+private:
 
-    // get counts on all the words first
-    std::string token;
-    while (tok(token))
+    bool get_next_file (
+        unsigned long& idx
+    )
     {
-        counts.increment(token);
+        auto_mutex lock(m);
+        if (next_file >= end_file)
+            return false;
+        idx = next_file++;
+        return true;
     }
 
-    std::priority_queue<std::pair<long, std::string> > best_words;
+    void get_all_candidates (
+        std::set<std::string>& words
+    ) const
+    /*!
+        ensures
+            - adds the union of every shard's candidates, and old_candidates, to words.
+    !*/
+    {
+        words.insert(old_candidates.begin(), old_candidates.end());
+        std::vector<std::pair<std::string, dlib::uint64> > items;
+        for (unsigned long i = 0; i < candidates.size(); ++i)
+        {
+            candidates[i].get_items(items);
+            for (unsigned long j = 0; j < items.size(); ++j)
+                words.insert(items[j].first);
+        }
+    }
 
-    dlib::set<std::string>::kernel_1a cur_words;
+    // Only the union of the shards' candidates is saved, not the shards themselves, so
+    // the counts can be loaded into a counter with a different number of shards.  Since
+    // the candidates are always ranked by their count in the shared sketch, merging
+    // them like this doesn't lose anything.
+    friend void serialize (const sharded_word_counter& item, std::ostream& out)
+    {
+        std::set<std::string> words;
+        item.get_all_candidates(words);
+        serialize(item.counts, out);
+        serialize(words, out);
+    }
 
-    // now pass over the data again and pick out only words with high counts
-    tok.reset();
-    while (tok(token))
+    friend void deserialize (sharded_word_counter& item, std::istream& in)
     {
-        if (cur_words.is_member(token))
-            continue;
+        deserialize(item.counts, in);
+        deserialize(item.old_candidates, in);
+        item.candidates.assign(item.candidates.size(), item.empty_candidates);
+    }
+
+    const std::vector<dlib::file>& files;
+    unsigned long next_file;
+    unsigned long end_file;
+    dlib::mutex m;
 
-        const long hits = counts.get_count(token);
-        if (best_words.size() < max_top_words || hits > -best_words.top().first)
+    concurrent_count_min_sketch counts;
+    std::vector<space_saving<std::string> > candidates;
+    const space_saving<std::string> empty_candidates;
+    // The candidates loaded by deserialize().
+    std::set<std::string> old_candidates;
+};
+
+// ----------------------------------------------------------------------------------------
+
+void get_top_word_counts (
+    const std::vector<dlib::file>& files,
+    std::map<std::string, unsigned long>& top_words,
+    const unsigned long max_top_words,
+    const unsigned long num_threads,
+    const unsigned long checkpoint_every,
+    const std::string& checkpoint_file
+)
+/*!
+    requires
+        - num_threads > 0
+        - checkpoint_every > 0
+    ensures
+        - counts the words in the given text files using num_threads threads and
+          stores the max_top_words most common words, along with their counts, into
+          top_words.
+        - Every checkpoint_every files the counts so far are saved to
+          checkpoint_file.  If that file holds the counts for a previous call with the
+          same files and max_top_words then counting picks up where that call left off,
+          even if it used a different number of threads.  The checkpoint is removed
+          once counting is done.
+!*/
+{
+    const std::string corpus = get_corpus_signature(files);
+
+    // There is no point in having more shards than files.
+    const unsigned long num_shards = std::max<unsigned long>(1, std::min<unsigned long>(num_threads, files.size()));
+    // With one shard the candidates are exactly the top words.  With several, a top word
+    // could in principle fall just short in every shard, so give each shard room for
+    // more candidates than we need to make that very unlikely.
+    sharded_word_counter counter(files, num_shards, 2*max_top_words);
+
+    unsigned long files_done = 0;
+    ifstream fin(checkpoint_file.c_str(), ios::binary);
+    if (fin)
+    {
+        try
         {
-            if (best_words.size() >= max_top_words)
+            std::string classname, saved_corpus;
+            int version = 0;
+            unsigned long saved_max_top_words = 0;
+            deserialize(classname, fin);
+            deserialize(version, fin);
+            if (classname == "wordrep::count_words_checkpoint" && version == 2)
             {
-                cur_words.destroy(best_words.top().second);
-                best_words.pop();
+                deserialize(saved_corpus, fin);
+                deserialize(saved_max_top_words, fin);
+                if (saved_corpus == corpus && saved_max_top_words == max_top_words)
+                {
+                    deserialize(files_done, fin);
+                    deserialize(counter, fin);
+                    cout << "Resuming word count from " << checkpoint_file << " after " << files_done << " files" << endl;
+                }
             }
-
-            best_words.push(std::make_pair(-hits, token));
-            cur_words.add(token);
+        }
+        catch (serialization_error&)
+        {
+            cout << "Ignoring unreadable " << checkpoint_file << endl;
+            files_done = 0;
+            counter.clear();
         }
     }
+    fin.close();
 
-    // now put the best words into top_words
-    top_words.clear();
-    while (best_words.size() != 0)
+    while (files_done < files.size())
     {
-        top_words[best_words.top().second] = -best_words.top().first;
-        best_words.pop();
+        const unsigned long end = std::min<unsigned long>(files.size(), files_done + checkpoint_every);
+        counter.set_file_range(files_done, end);
+        parallel_for(num_shards, 0, num_shards, counter, &sharded_word_counter::count_shard, 1);
+        files_done = end;
+
+        if (files_done < files.size())
+        {
+            std::vector<char> buf;
+            vectorstream sout(buf);
+            serialize(std::string("wordrep::count_words_checkpoint"), sout);
+            serialize(2, sout);
+            serialize(corpus, sout);
+            serialize(max_top_words, sout);
+            serialize(files_done, sout);
+            serialize(counter, sout);
+            save_checkpoint_file(checkpoint_file, buf);
+            cout << "Counted " << files_done << " of " << files.size() << " files, saved " << checkpoint_file << endl;
+        }
     }
+
+    counter.get_top_words(top_words, max_top_words);
+    std::remove(checkpoint_file.c_str());
 }
 
 // ----------------------------------------------------------------------------------------
 
 void count_words(const command_line_parser& parser);
+void make_total_word_feature_extractor(const command_line_parser& parser);
 void test(const command_line_parser& parser);
 void cluster_words(const command_line_parser& parser);
 
@@ -90,7 +312,10 @@ int main(int argc, char** argv)
         parser.add_option("h","Display this help message.");
 
         parser.add_option("e", "Make a total_word_feature_extractor from a folder of text files.   This option is a shortcut for executing"
-                               " the following options together --count-words 200000 --word-vects --basic-morph --cca-morph.");
+                               " the following options together --count-words 200000 --cache-corpus --word-vects --basic-morph --cca-morph."
+                               "  Each step saves a <step>.manifest file in the --work-dir folder and steps whose inputs haven't"
+                               " changed since they last finished are skipped, so rerunning an interrupted -e only redoes the"
+                               " unfinished work.");
 
         parser.set_group_name("Other Options");
         parser.add_option("convert-gigaword", "Take a folder of gigaword XML documents and convert them "
@@ -99,9 +324,32 @@ int main(int argc, char** argv)
         parser.add_option("basic-morph", "Make a word morphology extractor.");
         parser.add_option("cca-morph", "Make a CCA based word morphology extractor object as well as a total word "
                                         "feature extractor.");
+        parser.add_option("cache-corpus", "Save the corpus as a memory mapped file of word IDs so later passes "
+                                          "don't have to tokenize the text again.  Requires a top_word_counts.dat "
+                                          "file from --count-words.");
         parser.add_option("word-vects", "Use CCA to create distributional word vectors.");
+        parser.add_option("cca-contexts", "When making word vectors, do CCA on about <arg> randomly sampled "
+                                          "context windows (default: 50000000).",1);
+        parser.add_option("stream-cca", "When making word vectors, do the CCA out of core by streaming the "
+                                        "context windows from the corpus cache rather than holding them in RAM.  "
+                                        "The memory needed then depends only on the vocabulary size, not on "
+                                        "--cca-contexts or the size of the corpus.");
+        parser.add_option("extend-vocab", "Add the words in a folder of text files to the total_word_feature_extractor "
+                                          "in file <arg>.  This reuses the CCA projections saved by a previous --word-vects "
+                                          "run in the --work-dir folder, so only the new text is read.  The result is saved to "
+                                          "extended_total_word_feature_extractor.dat.  Note that it has a different "
+                                          "fingerprint than <arg> so models trained with <arg> won't work with it.",1);
+        parser.add_option("extend-min-count", "When doing --extend-vocab, only add words seen at least <arg> times (default: 10).",1);
         parser.add_option("test", "Print out the feature vectors for the word given on the command line.");
         parser.add_option("cluster-words", "Generate word clusters based on a saved total_word_feature_extractor.");
+        parser.add_option("checkpoint-every", "While counting words, caching the corpus, or making word vectors, save "
+                                              "progress every <arg> files so an interrupted run can pick up where it left off "
+                                              "(default: 1000).  Word vectors are made from the corpus cache, so there it "
+                                              "means every <arg> files' worth of text on average.",1);
+        parser.add_option("work-dir", "Keep the files wordrep makes and reads back (word counts, the corpus cache, "
+                                      "checkpoints, manifests, word vectors, and the final total_word_feature_extractor.dat) "
+                                      "in folder <arg> rather than the current folder.  It is created if it doesn't exist.",1);
+        parser.add_option("threads", "Use <arg> threads to count words, sample word contexts, mine word substrings, and parse gigaword XML files (default: 4).",1);
 
         parser.set_group_name("Document Vector Level Features");
         parser.add_option("doc-vects", "Generate CCA based word features where we assume the important thing about a "
@@ -113,11 +361,18 @@ int main(int argc, char** argv)
         parser.parse(argc,argv);
         parser.check_option_arg_range("count-words", 1, 1000000000);
         parser.check_option_arg_range("dims", 1, 100000);
+        parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_option_arg_range("cca-contexts", 1.0, 1e15);
+        parser.check_option_arg_range("extend-min-count", 1, 1000000000);
+        parser.check_option_arg_range("checkpoint-every", 1, 1000000000);
+        parser.check_sub_option("extend-vocab", "extend-min-count");
         parser.check_sub_option("doc-vects", "dims");
+        parser.check_incompatible_options("e", "cache-corpus");
         parser.check_incompatible_options("e", "word-vects");
         parser.check_incompatible_options("e", "count-words");
         parser.check_incompatible_options("e", "basic-morph");
         parser.check_incompatible_options("e", "cca-morph");
+        parser.check_incompatible_options("e", "extend-vocab");
 
         if (parser.option("h"))
         {
@@ -127,12 +382,17 @@ int main(int argc, char** argv)
             return 0;
         }
 
+        if (parser.option("work-dir"))
+            create_directory(get_work_dir(parser));
+
         if (parser.option("convert-gigaword"))
         {
             ofstream fout(parser.option("convert-gigaword").argument().c_str());
             std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
             cout << "number of gigaword files found: " << files.size() << endl;
-            mitie::gigaword_reader reader(files);
+            // Parse the XML files on several threads, but keep them in order so the
+            // output is the same no matter how many threads are used.
+            parallel_group_tokenizer<gigaword_file_document_tokenizer> reader(files, get_option(parser, "threads", 4));
             std::string data;
             while (reader(data))
                 fout << data << "\n\n";
@@ -141,10 +401,7 @@ int main(int argc, char** argv)
 
         if (parser.option("e"))
         {
-            count_words(parser);
-            word_vects(parser);
-            basic_morph(parser);
-            cca_morph(parser);
+            make_total_word_feature_extractor(parser);
             return 0;
         }
 
@@ -153,6 +410,11 @@ int main(int argc, char** argv)
             count_words(parser);
         }
 
+        if (parser.option("cache-corpus"))
+        {
+            cache_corpus(parser);
+        }
+
         if (parser.option("word-vects"))
         {
             word_vects(parser);
@@ -168,6 +430,11 @@ int main(int argc, char** argv)
             cca_morph(parser);
         }
 
+        if (parser.option("extend-vocab"))
+        {
+            extend_vocab(parser);
+        }
+
         if (parser.option("test"))
         {
             test(parser);
@@ -198,7 +465,7 @@ void cluster_words(const command_line_parser& parser)
 {
     string classname;
     total_word_feature_extractor fe;
-    deserialize("total_word_feature_extractor.dat") >> classname >> fe;
+    deserialize(get_work_file(parser, "total_word_feature_extractor.dat")) >> classname >> fe;
 
     cout << "words in dictionary: " << fe.get_num_words_in_dictionary() << endl;
     cout << "num features: " << fe.get_num_dimensions() << endl;
@@ -240,7 +507,7 @@ void cluster_words(const command_line_parser& parser)
         groups[labels[i]].push_back(words[i]);
     }
 
-    ofstream fout("word_clusters.txt");
+    ofstream fout(get_work_file(parser, "word_clusters.txt").c_str());
     for (unsigned long i = 0; i < groups.size(); ++i)
     {
         for (unsigned long j = 0; j < groups[i].size(); ++j)
@@ -251,7 +518,7 @@ void cluster_words(const command_line_parser& parser)
     }
 
     // also save a more machine readable copy of the clusters
-    ofstream fout2("word_clusters.dat", ios::binary);
+    ofstream fout2(get_work_file(parser, "word_clusters.dat").c_str(), ios::binary);
     serialize(groups, fout2);
 }
 
@@ -264,13 +531,16 @@ void count_words(const command_line_parser& parser)
     std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
     cout << "number of raw ASCII files found: " << files.size() << endl;
 
-    group_tokenizer<unigram_tokenizer> tok(files);
+    const unsigned long num_threads = get_option(parser, "threads", 4);
+    const unsigned long checkpoint_every = get_option(parser, "checkpoint-every", 1000);
     std::map<std::string, unsigned long> words;
-    get_top_word_counts(tok, words, num_top_words);
+    get_top_word_counts(files, words, num_top_words, num_threads, checkpoint_every,
+                        get_work_file(parser, "count_words.checkpoint"));
 
     cout << "num words: "<< words.size() << endl;
-    cout << "saving word counts to top_word_counts.dat" << endl;
-    ofstream fout("top_word_counts.dat", ios::binary);
+    const std::string counts_file = get_work_file(parser, "top_word_counts.dat");
+    cout << "saving word counts to " << counts_file << endl;
+    ofstream fout(counts_file.c_str(), ios::binary);
     serialize(words, fout);
 
     // lets also save it as a .txt file
@@ -279,7 +549,7 @@ void count_words(const command_line_parser& parser)
         temp.push_back(make_pair(i->second, i->first));
     std::sort(temp.begin(), temp.end());
     fout.close(); fout.clear();
-    fout.open("top_words.txt");
+    fout.open(get_work_file(parser, "top_words.txt").c_str());
     for (unsigned long i = 0; i < temp.size(); ++i)
     {
         fout << temp[i].first << " \t" << temp[i].second << "\n";
@@ -289,11 +559,97 @@ void count_words(const command_line_parser& parser)
 
 // ----------------------------------------------------------------------------------------
 
+void run_stage (
+    stage_manifest& manifest,
+    void (*stage)(const command_line_parser&),
+    const command_line_parser& parser,
+    std::map<std::string, std::string>& file_hashes
+)
+/*!
+    ensures
+        - calls stage(parser) unless manifest says its results are up to date.
+        - adds the hash of each of the stage's output files to file_hashes, so later
+          stages reading them don't have to hash them again.
+!*/
+{
+    if (manifest.is_up_to_date())
+    {
+        cout << "Skipping " << manifest.get_stage_name() << " since its inputs haven't changed since it last ran." << endl;
+    }
+    else
+    {
+        manifest.start();
+        stage(parser);
+        manifest.finish();
+    }
+    const std::map<std::string, std::string>& hashes = manifest.get_output_hashes();
+    for (std::map<std::string, std::string>::const_iterator i = hashes.begin(); i != hashes.end(); ++i)
+        file_hashes[i->first] = i->second;
+}
+
+void make_total_word_feature_extractor(const command_line_parser& parser)
+{
+    // Each stage reads the files made by the ones before it, so a stage is rerun when
+    // any of its inputs changed.  Note that the number of threads isn't a parameter
+    // since it doesn't change what the stages compute in any meaningful way.  That way
+    // a run killed for using too much RAM can be resumed with fewer threads.  Likewise
+    // the stages' files are named relative to the work folder, so the manifests don't
+    // depend on how that folder was named on the command line.
+    const std::string work_dir = get_work_dir(parser);
+    const std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
+    // The hashes of the files the stages have output.  Some, like corpus_tokens.dat,
+    // are huge, so each one is only hashed once.
+    std::map<std::string, std::string> file_hashes;
+    {
+        stage_manifest m("count_words", work_dir);
+        m.add_parameter("count-words", cast_to_string(get_option(parser, "count-words", 200000)));
+        m.add_corpus(files);
+        m.add_output_file("top_word_counts.dat");
+        m.add_output_file("top_words.txt");
+        run_stage(m, count_words, parser, file_hashes);
+    }
+    {
+        stage_manifest m("cache_corpus", work_dir);
+        m.add_corpus(files);
+        m.add_input_file("top_word_counts.dat", file_hashes);
+        m.add_output_file("corpus_tokens.dat");
+        m.add_output_file("corpus_vocab.dat");
+        run_stage(m, cache_corpus, parser, file_hashes);
+    }
+    {
+        stage_manifest m("word_vects", work_dir);
+        m.add_parameter("cca-contexts", cast_to_string(get_option(parser, "cca-contexts", 50000000UL)));
+        m.add_parameter("stream-cca", cast_to_string(parser.option("stream-cca").count() != 0));
+        m.add_input_file("corpus_tokens.dat", file_hashes);
+        m.add_input_file("corpus_vocab.dat", file_hashes);
+        m.add_output_file("word_vects.dat");
+        m.add_output_file("word_vects_cca.dat");
+        run_stage(m, word_vects, parser, file_hashes);
+    }
+    {
+        stage_manifest m("basic_morph", work_dir);
+        m.add_input_file("top_word_counts.dat", file_hashes);
+        m.add_output_file("substring_set.dat");
+        m.add_output_file("substrings.txt");
+        run_stage(m, basic_morph, parser, file_hashes);
+    }
+    {
+        stage_manifest m("cca_morph", work_dir);
+        m.add_input_file("word_vects.dat", file_hashes);
+        m.add_input_file("substring_set.dat", file_hashes);
+        m.add_output_file("word_morph_feature_extractor.dat");
+        m.add_output_file("total_word_feature_extractor.dat");
+        run_stage(m, cca_morph, parser, file_hashes);
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
 void test(const command_line_parser& parser)
 {
     string classname;
     total_word_feature_extractor fe;
-    deserialize("total_word_feature_extractor.dat") >> classname >> fe;
+    deserialize(get_work_file(parser, "total_word_feature_extractor.dat")) >> classname >> fe;
 
     cout << "words in dictionary: " << fe.get_num_words_in_dictionary() << endl;
     cout << "num features: " << fe.get_num_dimensions() << endl;
@@ -0,0 +1,268 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "stage_manifest.h"
+#include <dlib/serialize.h>
+#include <dlib/vectorstream.h>
+#include <dlib/general_hash/murmur_hash3.h>
+#include <mitie/mapped_file.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+namespace
+{
+    std::string to_hex (
+        const std::pair<uint64,uint64>& h
+    )
+    {
+        std::ostringstream sout;
+        sout << std::hex << std::setfill('0') << std::setw(16) << h.first << std::setw(16) << h.second;
+        return sout.str();
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+std::string join_path (
+    const std::string& folder,
+    const std::string& name
+)
+{
+    if (folder.size() == 0)
+        return name;
+    const char last = folder[folder.size()-1];
+    if (last == '/' || last == directory::get_separator())
+        return folder + name;
+    return folder + directory::get_separator() + name;
+}
+
+std::string get_work_dir (
+    const command_line_parser& parser
+)
+{
+    if (parser.option("work-dir"))
+        return parser.option("work-dir").argument();
+    return "";
+}
+
+// ----------------------------------------------------------------------------------------
+
+std::string get_file_hash (
+    const std::string& filename
+)
+{
+    {
+        ifstream fin(filename.c_str(), ios::binary);
+        if (!fin)
+            return "missing";
+    }
+
+    mapped_file file(filename);
+    const char empty = 0;
+    const char* data = (file.size() != 0) ? file.data() : &empty;
+    return to_hex(murmur_hash3_128bit(data, static_cast<size_t>(file.size())));
+}
+
+// ----------------------------------------------------------------------------------------
+
+std::string get_corpus_signature (
+    const std::vector<dlib::file>& files
+)
+{
+    std::vector<char> buf;
+    vectorstream sout(buf);
+    for (unsigned long i = 0; i < files.size(); ++i)
+    {
+        serialize(files[i].full_name(), sout);
+        serialize((uint64)files[i].size(), sout);
+    }
+    const char empty = 0;
+    return to_hex(murmur_hash3_128bit(buf.size() != 0 ? &buf[0] : &empty, buf.size()));
+}
+
+// ----------------------------------------------------------------------------------------
+
+void save_checkpoint_file (
+    const std::string& filename,
+    const std::vector<char>& data
+)
+{
+    checkpoint_file_writer writer(filename);
+    if (data.size() != 0)
+        writer.stream().write(&data[0], data.size());
+    writer.commit();
+}
+
+// ----------------------------------------------------------------------------------------
+
+checkpoint_file_writer::
+checkpoint_file_writer (
+    const std::string& filename_
+) : filename(filename_), temp(filename_ + ".tmp"), fout(temp.c_str(), ios::binary)
+{
+}
+
+// ----------------------------------------------------------------------------------------
+
+void checkpoint_file_writer::
+commit (
+)
+{
+    fout.close();
+    if (!fout)
+        throw dlib::error("Error writing " + temp);
+    std::remove(filename.c_str());
+    if (std::rename(temp.c_str(), filename.c_str()) != 0)
+        throw dlib::error("Unable to rename " + temp + " to " + filename);
+}
+
+// ----------------------------------------------------------------------------------------
+
+stage_manifest::
+stage_manifest (
+    const std::string& stage_name_,
+    const std::string& work_dir_
+) : stage_name(stage_name_), work_dir(work_dir_),
+    filename(join_path(work_dir_, stage_name_ + ".manifest"))
+{
+}
+
+// ----------------------------------------------------------------------------------------
+
+void stage_manifest::
+add_parameter (
+    const std::string& name,
+    const std::string& value
+)
+{
+    inputs["parameter " + name] = value;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void stage_manifest::
+add_corpus (
+    const std::vector<dlib::file>& files
+)
+{
+    inputs["corpus"] = get_corpus_signature(files);
+}
+
+// ----------------------------------------------------------------------------------------
+
+void stage_manifest::
+add_input_file (
+    const std::string& name
+)
+{
+    inputs["file " + name] = get_file_hash(join_path(work_dir, name));
+}
+
+// ----------------------------------------------------------------------------------------
+
+void stage_manifest::
+add_input_file (
+    const std::string& name,
+    const std::map<std::string, std::string>& known_hashes
+)
+{
+    std::map<std::string, std::string>::const_iterator i = known_hashes.find(name);
+    if (i != known_hashes.end())
+        inputs["file " + name] = i->second;
+    else
+        add_input_file(name);
+}
+
+// ----------------------------------------------------------------------------------------
+
+void stage_manifest::
+add_output_file (
+    const std::string& name
+)
+{
+    outputs.push_back(name);
+}
+
+// ----------------------------------------------------------------------------------------
+
+bool stage_manifest::
+is_up_to_date (
+)
+{
+    ifstream fin(filename.c_str(), ios::binary);
+    if (!fin)
+        return false;
+
+    std::map<std::string, std::string> saved_inputs, saved_outputs;
+    try
+    {
+        std::string classname;
+        int version = 0;
+        deserialize(classname, fin);
+        deserialize(version, fin);
+        if (classname != "wordrep::stage_manifest" || version != 1)
+            return false;
+        deserialize(saved_inputs, fin);
+        deserialize(saved_outputs, fin);
+    }
+    catch (serialization_error&)
+    {
+        return false;
+    }
+
+    if (saved_inputs != inputs || saved_outputs.size() != outputs.size())
+        return false;
+
+    output_hashes.clear();
+    for (unsigned long i = 0; i < outputs.size(); ++i)
+    {
+        std::map<std::string, std::string>::const_iterator j = saved_outputs.find(outputs[i]);
+        if (j == saved_outputs.end())
+            return false;
+        const std::string hash = get_file_hash(join_path(work_dir, outputs[i]));
+        if (j->second != hash)
+            return false;
+        output_hashes[outputs[i]] = hash;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void stage_manifest::
+start (
+) const
+{
+    std::remove(filename.c_str());
+}
+
+// ----------------------------------------------------------------------------------------
+
+void stage_manifest::
+finish (
+)
+{
+    output_hashes.clear();
+    for (unsigned long i = 0; i < outputs.size(); ++i)
+        output_hashes[outputs[i]] = get_file_hash(join_path(work_dir, outputs[i]));
+
+    std::vector<char> buf;
+    vectorstream sout(buf);
+    serialize(std::string("wordrep::stage_manifest"), sout);
+    serialize(1, sout);
+    serialize(inputs, sout);
+    serialize(output_hashes, sout);
+    save_checkpoint_file(filename, buf);
+}
+
+// ----------------------------------------------------------------------------------------
+
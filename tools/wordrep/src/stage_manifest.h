@@ -0,0 +1,250 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_STAGE_MaNIFEST_H_
+#define MIT_LL_STAGE_MaNIFEST_H_
+
+#include <dlib/dir_nav.h>
+#include <dlib/cmd_line_parser.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------------------
+
+std::string join_path (
+    const std::string& folder,
+    const std::string& name
+);
+/*!
+    ensures
+        - returns the path of the file called name in the given folder.  If folder == ""
+          then this is just name, i.e. the file is in the current folder.
+!*/
+
+std::string get_work_dir (
+    const dlib::command_line_parser& parser
+);
+/*!
+    ensures
+        - returns the folder given to --work-dir, or "" if there wasn't one.  This is
+          where wordrep keeps the files it makes and reads back, such as the word
+          counts, corpus cache, checkpoints, and stage manifests.
+!*/
+
+inline std::string get_work_file (
+    const dlib::command_line_parser& parser,
+    const std::string& name
+) { return join_path(get_work_dir(parser), name); }
+/*!
+    ensures
+        - returns the path of the file called name in the --work-dir folder.
+!*/
+
+// ----------------------------------------------------------------------------------------
+
+std::string get_file_hash (
+    const std::string& filename
+);
+/*!
+    ensures
+        - returns a hex string of the 128 bit murmur hash of the contents of the given
+          file, or "missing" if the file can't be opened.
+!*/
+
+std::string get_corpus_signature (
+    const std::vector<dlib::file>& files
+);
+/*!
+    ensures
+        - returns a hex string of a hash of the names and sizes of the given files.
+          This is what a manifest or checkpoint records about the raw text corpus, since
+          hashing all its contents would take about as long as a pass over it.
+!*/
+
+void save_checkpoint_file (
+    const std::string& filename,
+    const std::vector<char>& data
+);
+/*!
+    ensures
+        - writes data to the given file, replacing its previous contents.  The data is
+          written to a temporary file first so an interruption never leaves a partially
+          written checkpoint behind.
+!*/
+
+class checkpoint_file_writer : dlib::noncopyable
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object writes a checkpoint file the same way save_checkpoint_file()
+            does, but lets you serialize into the file directly.  That avoids holding
+            a second copy of a big checkpoint in memory.  Everything written to
+            stream() goes to a temporary file, which only replaces the checkpoint when
+            commit() is called.
+    !*/
+
+public:
+
+    explicit checkpoint_file_writer (
+        const std::string& filename
+    );
+
+    std::ostream& stream (
+    ) { return fout; }
+
+    void commit (
+    );
+    /*!
+        ensures
+            - replaces the checkpoint file with what was written to stream().
+        throws
+            - dlib::error if the data couldn't be written.
+    !*/
+
+private:
+    std::string filename;
+    std::string temp;
+    std::ofstream fout;
+};
+
+// ----------------------------------------------------------------------------------------
+
+class stage_manifest
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object records what one stage of wordrep -e was run on, so later runs
+            can skip stages whose results are still valid.  A stage's record consists of
+            its parameters, the hashes of its input files, and the hashes of the files
+            it output.  It is saved in <stage name>.manifest in the work folder given to
+            its constructor, and the input and output files are also looked up in that
+            folder.
+
+            The intended use is:
+                stage_manifest m("word_vects", get_work_dir(parser));
+                m.add_parameter(...); m.add_input_file(...); m.add_output_file(...);
+                if (!m.is_up_to_date())
+                {
+                    m.start();
+                    run the stage
+                    m.finish();
+                }
+            Since start() removes the manifest, a stage that doesn't finish is rerun the
+            next time.
+    !*/
+
+public:
+
+    stage_manifest (
+        const std::string& stage_name,
+        const std::string& work_dir
+    );
+    /*!
+        ensures
+            - #get_stage_name() == stage_name
+            - The manifest, and the files given to add_input_file() and
+              add_output_file(), are in the folder work_dir (see join_path()).
+    !*/
+
+    const std::string& get_stage_name (
+    ) const { return stage_name; }
+
+    void add_parameter (
+        const std::string& name,
+        const std::string& value
+    );
+    /*!
+        ensures
+            - the stage is considered out of date if value differs from the value of
+              the parameter called name when the stage last finished.
+    !*/
+
+    void add_corpus (
+        const std::vector<dlib::file>& files
+    );
+    /*!
+        ensures
+            - the stage is considered out of date if get_corpus_signature(files)
+              changed since the stage last finished.
+    !*/
+
+    void add_input_file (
+        const std::string& filename
+    );
+    /*!
+        ensures
+            - the stage is considered out of date if the contents of filename changed
+              since the stage last finished.  The file is hashed right away, so this
+              should be called after the stages making filename have run.
+    !*/
+
+    void add_input_file (
+        const std::string& filename,
+        const std::map<std::string, std::string>& known_hashes
+    );
+    /*!
+        ensures
+            - This function is identical to add_input_file(filename) except that if
+              known_hashes contains filename then the hash stored there is used rather
+              than hashing the file again.  This is useful since the files passed
+              between stages can be very large.
+    !*/
+
+    void add_output_file (
+        const std::string& filename
+    );
+    /*!
+        ensures
+            - the stage is considered out of date if filename was deleted or changed
+              since the stage last finished.
+    !*/
+
+    bool is_up_to_date (
+    );
+    /*!
+        ensures
+            - returns true if the manifest file exists, the parameters and inputs are
+              the same as when it was saved, and all the output files are unchanged.
+            - if (this function returns true) then
+                - #get_output_hashes() contains the hash of every output file.
+    !*/
+
+    void start (
+    ) const;
+    /*!
+        ensures
+            - removes the manifest file.
+    !*/
+
+    void finish (
+    );
+    /*!
+        ensures
+            - saves the manifest file, hashing the output files.
+            - #get_output_hashes() contains the hash of every output file.
+    !*/
+
+    const std::map<std::string, std::string>& get_output_hashes (
+    ) const { return output_hashes; }
+    /*!
+        ensures
+            - returns a map from output file names to the get_file_hash() values
+              computed for them by is_up_to_date() or finish().
+    !*/
+
+private:
+
+    std::string stage_name;
+    std::string work_dir;
+    std::string filename;
+    std::map<std::string, std::string> inputs;
+    std::vector<std::string> outputs;
+    std::map<std::string, std::string> output_hashes;
+};
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MIT_LL_STAGE_MaNIFEST_H_
+
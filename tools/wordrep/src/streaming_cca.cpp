@@ -0,0 +1,728 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "streaming_cca.h"
+#include "stage_manifest.h"
+#include <dlib/threads.h>
+#include <dlib/rand.h>
+#include <dlib/string.h>
+#include <dlib/serialize.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+namespace
+{
+    class window_sample
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object defines which context windows of a corpus_cache are used by
+                streaming_cca_on_windows() and how they map to sparse feature vectors.
+
+                The windows are grouped into blocks of consecutive windows.  Within a
+                block each window is kept with probability get_rate(), which is done by
+                jumping between kept windows with geometrically distributed skips drawn
+                from a random number generator seeded with the block number.  So every
+                pass over the blocks sees exactly the same windows without us having to
+                store which ones they were.
+        !*/
+
+    public:
+
+        window_sample (
+            const corpus_cache& corpus_,
+            const unsigned long vocab_size_,
+            const unsigned long window_size_,
+            const uint64 num_contexts
+        ) : corpus(corpus_), vocab_size(vocab_size_), window_size(window_size_)
+        {
+            // A rate of 0 would make log_skip 0 and skip() divide by it.
+            DLIB_CASSERT(num_contexts > 0, "A window_sample must keep some windows.");
+            // window i is made of the tokens i through i+window_size-1
+            num_windows = corpus.size() >= window_size ? corpus.size()-window_size+1 : 0;
+            rate = num_windows > num_contexts ? (double)num_contexts/num_windows : 1;
+            log_skip = std::log(1-rate);
+        }
+
+        double get_rate (
+        ) const { return rate; }
+
+        uint64 num_blocks (
+        ) const { return (num_windows + block_size-1)/block_size; }
+
+        static uint64 get_block_size (
+        ) { return block_size; }
+
+        unsigned long num_left_features (
+        ) const { return num_left_slots()*(vocab_size+1); }
+
+        unsigned long num_right_features (
+        ) const { return num_right_slots()*(vocab_size+1); }
+
+        unsigned long num_slots (
+            bool left
+        ) const { return left ? num_left_slots() : num_right_slots(); }
+
+        void get_block (
+            uint64 block,
+            std::vector<const uint32*>& windows
+        ) const
+        /*!
+            ensures
+                - #windows == pointers to the first token of each window kept from the
+                  given block.
+        !*/
+        {
+            windows.clear();
+            const uint64 begin = block*block_size;
+            const uint64 end = std::min(begin+block_size, num_windows);
+            if (rate >= 1)
+            {
+                for (uint64 i = begin; i < end; ++i)
+                    windows.push_back(corpus.begin()+i);
+                return;
+            }
+
+            dlib::rand rnd(cast_to_string(block));
+            for (uint64 i = begin + skip(rnd, end-begin); i < end; i += 1 + skip(rnd, end-begin))
+                windows.push_back(corpus.begin()+i);
+        }
+
+        void get_features (
+            const uint32* window,
+            bool left,
+            unsigned long* features
+        ) const
+        /*!
+            ensures
+                - stores the indices of the non-zero features of the left (or right)
+                  context vector of the given window into features.  This is the same
+                  feature mapping used by get_left_and_right_context_vectors() in
+                  word_vects.cpp.  Each context vector has num_slots(left) non-zero
+                  features, all with a value of 1.
+        !*/
+        {
+            const unsigned long offset = left ? 0 : num_left_slots()+1;
+            for (unsigned long i = 0; i < num_slots(left); ++i)
+                features[i] = i*(vocab_size+1) + get_word_id(vocab_size, window[offset+i]);
+        }
+
+    private:
+
+        unsigned long num_left_slots (
+        ) const { return window_size/2; }
+
+        unsigned long num_right_slots (
+        ) const { return window_size - window_size/2 - 1; }
+
+        uint64 skip (
+            dlib::rand& rnd,
+            uint64 max_skip
+        ) const
+        /*!
+            ensures
+                - returns the number of windows to skip before the next kept window,
+                  capped at max_skip.
+        !*/
+        {
+            const double val = std::log(1-rnd.get_random_double())/log_skip;
+            if (val >= max_skip)
+                return max_skip;
+            return static_cast<uint64>(val);
+        }
+
+        const static uint64 block_size = 100000;
+
+        const corpus_cache& corpus;
+        const unsigned long vocab_size;
+        const unsigned long window_size;
+        uint64 num_windows;
+        double rate;
+        double log_skip;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    struct cca_progress
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object records how far streaming_cca_on_windows() has gotten.  Its
+                passes over the corpus are numbered 0 through 2*q+4.  The first q+2
+                find the left singular vectors, the next q+2 the right ones, and the
+                last is the cross pass.
+        !*/
+
+        cca_progress (
+        ) : passes_done(0), blocks_done(0), windows_done(0) {}
+
+        // The number of passes that have finished.
+        unsigned long passes_done;
+        // How many blocks of the current pass are done, how many windows were kept in
+        // them, and what the pass has accumulated from them so far.
+        uint64 blocks_done;
+        uint64 windows_done;
+        matrix<double> partial;
+        // The input of the current range finder pass.
+        matrix<float> Q;
+        // The singular vectors and values of each side, once its passes are done.
+        matrix<float> Vl, Vr;
+        matrix<double,0,1> Dl, Dr;
+    };
+
+    void serialize (const cca_progress& item, std::ostream& out)
+    {
+        dlib::serialize(item.passes_done, out);
+        dlib::serialize(item.blocks_done, out);
+        dlib::serialize(item.windows_done, out);
+        dlib::serialize(item.partial, out);
+        dlib::serialize(item.Q, out);
+        dlib::serialize(item.Vl, out);
+        dlib::serialize(item.Dl, out);
+        dlib::serialize(item.Vr, out);
+        dlib::serialize(item.Dr, out);
+    }
+
+    void deserialize (cca_progress& item, std::istream& in)
+    {
+        dlib::deserialize(item.passes_done, in);
+        dlib::deserialize(item.blocks_done, in);
+        dlib::deserialize(item.windows_done, in);
+        dlib::deserialize(item.partial, in);
+        dlib::deserialize(item.Q, in);
+        dlib::deserialize(item.Vl, in);
+        dlib::deserialize(item.Dl, in);
+        dlib::deserialize(item.Vr, in);
+        dlib::deserialize(item.Dr, in);
+    }
+
+    class cca_checkpoint
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object saves a cca_progress to a file at the end of every pass and
+                every blocks_per_save blocks within a pass, and loads it back when a
+                later call is for the same problem.  The problem is identified by a
+                string made from the corpus signature and the arguments of
+                streaming_cca_on_windows().  If the filename is "" nothing is saved.
+        !*/
+
+    public:
+
+        cca_checkpoint (
+            const std::string& filename_,
+            const std::string& problem_,
+            uint64 blocks_per_save_
+        ) : filename(filename_), problem(problem_), blocks_per_save(std::max<uint64>(1, blocks_per_save_)) {}
+
+        bool load (
+            cca_progress& progress
+        ) const
+        /*!
+            ensures
+                - if (the file holds the progress of the same problem) then
+                    - #progress == the saved progress
+                    - returns true
+                - else
+                    - returns false
+        !*/
+        {
+            if (filename.size() == 0)
+                return false;
+            ifstream fin(filename.c_str(), ios::binary);
+            if (!fin)
+                return false;
+            try
+            {
+                std::string classname, saved_problem;
+                int version = 0;
+                dlib::deserialize(classname, fin);
+                dlib::deserialize(version, fin);
+                if (classname != "wordrep::streaming_cca_checkpoint" || version != 1)
+                    return false;
+                dlib::deserialize(saved_problem, fin);
+                if (saved_problem != problem)
+                    return false;
+                deserialize(progress, fin);
+                return true;
+            }
+            catch (serialization_error&)
+            {
+                progress = cca_progress();
+                return false;
+            }
+        }
+
+        bool is_due (
+            uint64 blocks_done,
+            uint64 num_blocks
+        ) const
+        /*!
+            ensures
+                - returns true if the progress should be saved now that blocks_done of the
+                  num_blocks blocks of a pass are done.  The end of a pass isn't included
+                  since the pass's result is saved once it has been used.
+        !*/
+        {
+            return filename.size() != 0 && blocks_done < num_blocks && blocks_done%blocks_per_save == 0;
+        }
+
+        void save (
+            const cca_progress& progress
+        ) const
+        {
+            if (filename.size() == 0)
+                return;
+            checkpoint_file_writer writer(filename);
+            dlib::serialize(std::string("wordrep::streaming_cca_checkpoint"), writer.stream());
+            dlib::serialize(1, writer.stream());
+            dlib::serialize(problem, writer.stream());
+            serialize(progress, writer.stream());
+            writer.commit();
+        }
+
+        void finish_pass (
+            cca_progress& progress
+        ) const
+        /*!
+            requires
+                - the pass progress.passes_done is done and its result has been moved
+                  into progress.Q, or progress.Vl and Dl, or progress.Vr and Dr.
+            ensures
+                - moves progress on to the next pass and saves it.
+        !*/
+        {
+            progress.passes_done += 1;
+            progress.blocks_done = 0;
+            progress.windows_done = 0;
+            progress.partial.set_size(0,0);
+            save(progress);
+        }
+
+        void remove (
+        ) const
+        {
+            if (filename.size() != 0)
+                std::remove(filename.c_str());
+        }
+
+    private:
+        const std::string filename;
+        const std::string problem;
+        const uint64 blocks_per_save;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class streaming_cca_solver
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object makes the passes over a window_sample needed by
+                streaming_cca_on_windows().  Let M be the matrix whose rows are the left
+                (or right) context vectors of all the windows in the sample.  Each pass
+                goes through the sample one block at a time.  For each block it first
+                computes Z = M_block*Q, where each row of Z is just the sum of a few rows
+                of Q since the context vectors are sparse and binary.  Then it either
+                adds trans(M_block)*Z into a features by dimensions matrix or adds
+                trans(Z)*Z into a small dimensions by dimensions matrix.
+
+                The rows of Z are computed in parallel.  When adding trans(M_block)*Z
+                each thread handles a range of feature rows, so no two threads ever
+                write to the same memory and we don't need any locks or per thread
+                copies of the big output matrix.
+
+                Each pass accumulates into progress.partial, starting at block
+                progress.blocks_done, so a pass can be resumed from a checkpoint taken
+                part way through it.
+        !*/
+
+    public:
+
+        streaming_cca_solver (
+            const window_sample& sample_,
+            unsigned long num_threads
+        ) : sample(sample_), tp(num_threads), num_parts(num_threads)
+        {}
+
+        void multiply_by_gram (
+            bool left,
+            const matrix<float>& Q,
+            cca_progress& progress,
+            const cca_checkpoint& checkpoint
+        )
+        /*!
+            ensures
+                - #progress.partial == trans(M)*M*Q
+        !*/
+        {
+            if (progress.blocks_done == 0)
+            {
+                progress.partial.set_size(Q.nr(), Q.nc());
+                progress.partial = 0;
+            }
+            out = &progress.partial;
+            for (uint64 b = progress.blocks_done; b < sample.num_blocks(); ++b)
+            {
+                project_block(b, left, Q, Z);
+                parallel_for(tp, 0, num_parts, *this, &streaming_cca_solver::scatter_part, 1);
+                finish_block(progress, checkpoint);
+            }
+        }
+
+        void gram (
+            bool left,
+            const matrix<float>& Q,
+            cca_progress& progress,
+            const cca_checkpoint& checkpoint
+        )
+        /*!
+            ensures
+                - #progress.partial == trans(M*Q)*(M*Q)
+        !*/
+        {
+            if (progress.blocks_done == 0)
+                progress.partial = zeros_matrix<double>(Q.nc(), Q.nc());
+            partials.assign(num_parts, zeros_matrix<double>(Q.nc(), Q.nc()));
+            Zr = matrix<double>();
+            for (uint64 b = progress.blocks_done; b < sample.num_blocks(); ++b)
+            {
+                project_block(b, left, Q, Z);
+                parallel_for(tp, 0, num_parts, *this, &streaming_cca_solver::accumulate_part, 1);
+                finish_block(progress, checkpoint);
+            }
+            sum_partials(progress.partial);
+        }
+
+        void cross (
+            const matrix<float>& Ql,
+            const matrix<float>& Qr,
+            cca_progress& progress,
+            const cca_checkpoint& checkpoint
+        )
+        /*!
+            ensures
+                - #progress.partial == trans(L*Ql)*(R*Qr)
+                - #progress.windows_done == the number of windows in the sample.
+        !*/
+        {
+            if (progress.blocks_done == 0)
+                progress.partial = zeros_matrix<double>(Ql.nc(), Qr.nc());
+            partials.assign(num_parts, zeros_matrix<double>(Ql.nc(), Qr.nc()));
+            for (uint64 b = progress.blocks_done; b < sample.num_blocks(); ++b)
+            {
+                project_block(b, false, Qr, Zr);
+                project_block(b, true, Ql, Z);
+                parallel_for(tp, 0, num_parts, *this, &streaming_cca_solver::accumulate_part, 1);
+                finish_block(progress, checkpoint);
+            }
+            Zr = matrix<double>();
+            sum_partials(progress.partial);
+        }
+
+    private:
+
+        void finish_block (
+            cca_progress& progress,
+            const cca_checkpoint& checkpoint
+        )
+        /*!
+            ensures
+                - records that the block in windows is done and saves the progress if a
+                  checkpoint is due.
+        !*/
+        {
+            progress.blocks_done += 1;
+            progress.windows_done += windows.size();
+            if (checkpoint.is_due(progress.blocks_done, sample.num_blocks()))
+            {
+                // The per thread partial sums aren't saved, so add them in first.
+                if (partials.size() != 0)
+                    sum_partials(progress.partial);
+                checkpoint.save(progress);
+            }
+        }
+
+        void sum_partials (
+            matrix<double>& result
+        )
+        /*!
+            ensures
+                - adds all the partial sums into result and sets them to 0.
+        !*/
+        {
+            for (unsigned long i = 0; i < partials.size(); ++i)
+            {
+                result += partials[i];
+                partials[i] = 0;
+            }
+        }
+
+        void project_block (
+            uint64 b,
+            bool left,
+            const matrix<float>& Q,
+            matrix<double>& dest
+        )
+        /*!
+            ensures
+                - loads the windows of block b and sets #dest to M_block*Q.
+        !*/
+        {
+            sample.get_block(b, windows);
+            cur_left = left;
+            cur_Q = &Q;
+            num_slots = sample.num_slots(left);
+            features.resize(windows.size()*num_slots);
+            dest.set_size(windows.size(), Q.nc());
+            cur_Z = &dest;
+            parallel_for(tp, 0, windows.size(), *this, &streaming_cca_solver::project_window);
+        }
+
+        void project_window (
+            long j
+        )
+        {
+            unsigned long* f = &features[j*num_slots];
+            sample.get_features(windows[j], cur_left, f);
+            const matrix<float>& Q = *cur_Q;
+            double* z = &(*cur_Z)(j,0);
+            for (long c = 0; c < Q.nc(); ++c)
+                z[c] = 0;
+            for (unsigned long s = 0; s < num_slots; ++s)
+            {
+                const float* q = &Q(f[s],0);
+                for (long c = 0; c < Q.nc(); ++c)
+                    z[c] += q[c];
+            }
+        }
+
+        void scatter_part (
+            long part
+        )
+        {
+            matrix<double>& Y = *out;
+            const unsigned long begin = Y.nr()*part/num_parts;
+            const unsigned long end = Y.nr()*(part+1)/num_parts;
+            for (unsigned long j = 0; j < windows.size(); ++j)
+            {
+                const double* z = &Z(j,0);
+                for (unsigned long s = 0; s < num_slots; ++s)
+                {
+                    const unsigned long f = features[j*num_slots+s];
+                    if (f < begin || f >= end)
+                        continue;
+                    double* y = &Y(f,0);
+                    for (long c = 0; c < Y.nc(); ++c)
+                        y[c] += z[c];
+                }
+            }
+        }
+
+        void accumulate_part (
+            long part
+        )
+        {
+            const long begin = Z.nr()*part/num_parts;
+            const long end = Z.nr()*(part+1)/num_parts;
+            if (begin == end)
+                return;
+            // Zr is empty unless we are doing a cross pass.
+            if (Zr.size() == 0)
+                partials[part] += trans(rowm(Z,range(begin,end-1)))*rowm(Z,range(begin,end-1));
+            else
+                partials[part] += trans(rowm(Z,range(begin,end-1)))*rowm(Zr,range(begin,end-1));
+        }
+
+        const window_sample& sample;
+        thread_pool tp;
+        const unsigned long num_parts;
+
+        // The state of the block currently being processed.
+        std::vector<const uint32*> windows;
+        std::vector<unsigned long> features;
+        unsigned long num_slots;
+        bool cur_left;
+        const matrix<float>* cur_Q;
+        matrix<double>* cur_Z;
+        matrix<double> Z, Zr;
+        matrix<double>* out;
+        std::vector<matrix<double> > partials;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    void find_singular_vectors (
+        streaming_cca_solver& solver,
+        bool left,
+        unsigned long num_features,
+        unsigned long rank,
+        unsigned long q,
+        cca_progress& progress,
+        const cca_checkpoint& checkpoint
+    )
+    /*!
+        ensures
+            - Finds approximations of the top rank right singular vectors and singular
+              values of the left (or right) context matrix M using a randomized range
+              finder on trans(M)*M.  This is the streaming equivalent of the svd_fast()
+              calls in dlib::cca().
+            - #progress.Vl (or Vr) == the singular vectors, one per column.
+            - #progress.Dl (or Dr) == the singular values.
+            - Picks up from wherever progress says the passes for this side got to.
+    !*/
+    {
+        const unsigned long first_pass = left ? 0 : q+2;
+        if (progress.passes_done >= first_pass+q+2)
+            return;
+
+        if (progress.passes_done == first_pass && progress.blocks_done == 0)
+            progress.Q = matrix_cast<float>(gaussian_randm(num_features, rank, left ? 0 : 1));
+        // Frequent words add into the same rows of Y millions of times, so
+        // progress.partial accumulates in double to avoid losing the small increments.
+        while (progress.passes_done < first_pass+q+1)
+        {
+            const unsigned long iter = progress.passes_done - first_pass;
+            cout << "  " << (left ? "left" : "right") << " range finder pass " << iter+1 << " of " << q+2 << endl;
+            solver.multiply_by_gram(left, progress.Q, progress, checkpoint);
+            progress.Q = matrix_cast<float>(progress.partial);
+            orthogonalize(progress.Q);
+            checkpoint.finish_pass(progress);
+        }
+
+        cout << "  " << (left ? "left" : "right") << " range finder pass " << q+2 << " of " << q+2 << endl;
+        matrix<double> W, W2;
+        matrix<double,0,1> D;
+        solver.gram(left, progress.Q, progress, checkpoint);
+        // The gram matrix is symmetric positive semi-definite so its SVD is also its
+        // eigendecomposition.
+        svd3(progress.partial, W, D, W2);
+        D = sqrt(D);
+        if (left)
+        {
+            progress.Vl = progress.Q*matrix_cast<float>(W);
+            progress.Dl = D;
+        }
+        else
+        {
+            progress.Vr = progress.Q*matrix_cast<float>(W);
+            progress.Dr = D;
+        }
+        progress.Q.set_size(0,0);
+        checkpoint.finish_pass(progress);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    matrix<double,0,1> safe_reciprocal (
+        const matrix<double,0,1>& D
+    )
+    {
+        matrix<double,0,1> temp(D.size());
+        for (long i = 0; i < D.size(); ++i)
+            temp(i) = D(i) != 0 ? 1/D(i) : 0;
+        return temp;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+matrix<float,0,1> streaming_cca_on_windows (
+    const corpus_cache& corpus,
+    const unsigned long vocab_size,
+    const unsigned long window_size,
+    const uint64 num_contexts,
+    const unsigned long num_correlations,
+    const unsigned long num_threads,
+    matrix<float>& Ltrans,
+    matrix<float>& Rtrans,
+    const std::string& checkpoint_file,
+    const uint64 checkpoint_every,
+    const unsigned long extra_rank,
+    const unsigned long q
+)
+{
+    DLIB_CASSERT(window_size >= 3 && num_contexts > 0 && num_correlations > 0 && num_threads > 0,
+        "Invalid inputs were given to this function.");
+
+    window_sample sample(corpus, vocab_size, window_size, num_contexts);
+    streaming_cca_solver solver(sample, num_threads);
+    cout << "Doing streaming CCA, using each context window with probability " << sample.get_rate() << endl;
+
+    const unsigned long rank_l = std::min(num_correlations+extra_rank, sample.num_left_features());
+    const unsigned long rank_r = std::min(num_correlations+extra_rank, sample.num_right_features());
+
+    // The number of threads isn't part of the problem since it doesn't change which
+    // windows are used.
+    std::ostringstream sout;
+    sout << corpus.get_signature() << " " << corpus.size() << " " << vocab_size << " " << window_size
+         << " " << num_contexts << " " << num_correlations << " " << extra_rank << " " << q;
+    const uint64 block_size = window_sample::get_block_size();
+    const cca_checkpoint checkpoint(checkpoint_file, sout.str(),
+                                    checkpoint_every == 0 ? sample.num_blocks() : (checkpoint_every+block_size-1)/block_size);
+    cca_progress progress;
+    if (checkpoint.load(progress))
+    {
+        cout << "Resuming streaming CCA from " << checkpoint_file << " after " << progress.passes_done
+             << " passes and " << progress.blocks_done << " of " << sample.num_blocks() << " blocks" << endl;
+    }
+
+    find_singular_vectors(solver, true, sample.num_left_features(), rank_l, q, progress, checkpoint);
+    find_singular_vectors(solver, false, sample.num_right_features(), rank_r, q, progress, checkpoint);
+    // The singular vectors stay in progress since the checkpoints taken during the
+    // cross pass need them.
+    const matrix<float>& Vl = progress.Vl;
+    const matrix<float>& Vr = progress.Vr;
+    matrix<double,0,1> Dl = progress.Dl;
+    matrix<double,0,1> Dr = progress.Dr;
+
+    // From here on this mirrors dlib::impl_cca().  Zero out singular values that are
+    // essentially zero so they don't cause numerical difficulties.
+    const double eps = std::numeric_limits<float>::epsilon()*std::max(max(Dr),max(Dl))*100;
+    Dl = round_zeros(Dl,eps);
+    Dr = round_zeros(Dr,eps);
+    const matrix<double,0,1> invDl = safe_reciprocal(Dl);
+    const matrix<double,0,1> invDr = safe_reciprocal(Dr);
+
+    // trans(Ul)*Ur where Ul and Ur are the left singular vectors of L and R.  Those are
+    // as big as the corpus so we never form them, but trans(Ul)*Ur is just
+    // inv(Dl)*trans(L*Vl)*(R*Vr)*inv(Dr), which we can get in one more pass.
+    cout << "  final pass" << endl;
+    solver.cross(Vl, Vr, progress, checkpoint);
+    const matrix<double> C = diagm(invDl)*progress.partial*diagm(invDr);
+    const uint64 num_used = progress.windows_done;
+    cout << "  number of context windows used: " << num_used << endl;
+
+    matrix<double> U, V;
+    matrix<double,0,1> D;
+    svd3(C, U, D, V);
+
+    // now throw away extra columns of the transformations.  We do this in a way that
+    // keeps the directions that have the highest correlations.
+    matrix<double,0,1> temp = D;
+    rsort_columns(U, temp);
+    rsort_columns(V, D);
+    const long num_output_correlations = std::min<uint64>(num_correlations, std::min<uint64>(num_used, std::min(rank_l, rank_r)));
+    U = colm(U, range(0, num_output_correlations-1));
+    V = colm(V, range(0, num_output_correlations-1));
+    D = rowm(D, range(0, num_output_correlations-1));
+
+    Ltrans = Vl*matrix_cast<float>(diagm(invDl)*U);
+    Rtrans = Vr*matrix_cast<float>(diagm(invDr)*V);
+
+    checkpoint.remove();
+    return matrix_cast<float>(D);
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,63 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_STREAMING_CcA_H_
+#define MIT_LL_STREAMING_CcA_H_
+
+#include <dlib/matrix.h>
+#include <dlib/uintn.h>
+#include <string>
+#include "corpus_cache.h"
+
+dlib::matrix<float,0,1> streaming_cca_on_windows (
+    const corpus_cache& corpus,
+    const unsigned long vocab_size,
+    const unsigned long window_size,
+    const dlib::uint64 num_contexts,
+    const unsigned long num_correlations,
+    const unsigned long num_threads,
+    dlib::matrix<float>& Ltrans,
+    dlib::matrix<float>& Rtrans,
+    const std::string& checkpoint_file = "",
+    const dlib::uint64 checkpoint_every = 0,
+    const unsigned long extra_rank = 40,
+    const unsigned long q = 5
+);
+/*!
+    requires
+        - window_size >= 3
+        - num_contexts > 0
+        - num_correlations > 0
+        - num_threads > 0
+    ensures
+        - This function does the same thing as calling dlib::cca() on the left and right
+          context vectors of a random sample of about num_contexts of the context windows
+          in corpus (i.e. what do_cca_on_windows() in word_vects.cpp does).  However, it
+          never holds the context vectors in memory.  Instead it makes several passes
+          over the memory mapped corpus and builds up the randomized range finder
+          sketches of L'*L and R'*R incrementally, where L and R are the matrices of
+          left and right context vectors.  So the RAM needed is proportional to the
+          number of features (i.e. vocab_size*window_size) times num_correlations and
+          doesn't depend on the number of contexts or the size of the corpus.
+        - The same windows are used in every pass.  Each window is picked independently
+          with probability num_contexts/(number of windows in corpus), or all the
+          windows are used if there are fewer than num_contexts of them.
+        - extra_rank and q have the same meaning as in dlib::cca().  That is, the range
+          finder uses num_correlations+extra_rank dimensions and q power iterations.
+          Each power iteration is one pass over the corpus for each of L and R.
+        - The passes are split over num_threads threads.
+        - If checkpoint_file != "" then the progress is saved to checkpoint_file at the
+          end of every pass, and also every checkpoint_every corpus windows within a pass
+          if checkpoint_every != 0.  If checkpoint_file holds the progress of a previous
+          call with the same corpus and arguments, other than num_threads, then this
+          call picks up where that one left off.  The checkpoint is removed once the
+          CCA is done.
+        - #Ltrans.nr() == the number of left context features
+        - #Rtrans.nr() == the number of right context features
+        - #Ltrans.nc() == #Rtrans.nc() == the number of correlations found, which is at
+          most num_correlations.
+        - returns the estimated correlations of the output directions.
+!*/
+
+#endif // MIT_LL_STREAMING_CcA_H_
+
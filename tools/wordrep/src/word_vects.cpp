@@ -5,10 +5,17 @@
 #include "word_vects.h"
 #include <dlib/matrix.h>
 #include <dlib/statistics.h>
-#include <dlib/sliding_buffer.h>
+#include <dlib/threads.h>
+#include <dlib/rand.h>
+#include <dlib/string.h>
 #include <map>
-#include <mitie/group_tokenizer.h>
-#include <mitie/unigram_tokenizer.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include "corpus_cache.h"
+#include "streaming_cca.h"
+#include "stage_manifest.h"
 
 using namespace std;
 using namespace dlib;
@@ -18,34 +25,25 @@ typedef std::vector<std::pair<dlib::uint32, float> > sparse_vector_type;
 
 // ----------------------------------------------------------------------------------------
 
-unsigned long get_word_id (
-    const std::map<std::string, unsigned long>& vocab,
-    const std::string& word
-)
-{
-    std::map<std::string, unsigned long>::const_iterator i;
-    i = vocab.find(word);
-    if (i != vocab.end())
-        return i->second;
-    else
-        return vocab.size();
-}
-
-// ----------------------------------------------------------------------------------------
-
 template <typename sparse_vector_type>
 void get_left_and_right_context_vectors (
-    const std::map<std::string, unsigned long>& vocab,
-    const dlib::circular_buffer<std::string>& buf,
+    const unsigned long vocab_size,
+    const dlib::uint32* window,
+    const unsigned long window_size,
     sparse_vector_type& left_context,
     sparse_vector_type& right_context
 )
+/*!
+    ensures
+        - computes the left and right context vectors of the window of window_size
+          token IDs starting at window.  The center word is window[window_size/2].
+!*/
 {
     // get the left context vector
     left_context.clear();
-    for (unsigned long i = 0; i < buf.size()/2; ++i)
+    for (unsigned long i = 0; i < window_size/2; ++i)
     {
-        left_context.push_back(make_pair(i*(vocab.size()+1) + get_word_id(vocab, buf[i]), 1));
+        left_context.push_back(make_pair(i*(vocab_size+1) + get_word_id(vocab_size, window[i]), 1));
     }
     make_sparse_vector_inplace(left_context);
 
@@ -53,9 +51,9 @@ void get_left_and_right_context_vectors (
     // get the right context vector
     right_context.clear();
     long k = 0;
-    for (unsigned long i = buf.size()/2+1; i < buf.size(); ++i)
+    for (unsigned long i = window_size/2+1; i < window_size; ++i)
     {
-        right_context.push_back(make_pair(k*(vocab.size()+1) + get_word_id(vocab, buf[i]), 1));
+        right_context.push_back(make_pair(k*(vocab_size+1) + get_word_id(vocab_size, window[i]), 1));
         ++k;
     }
     make_sparse_vector_inplace(right_context);
@@ -63,119 +61,462 @@ void get_left_and_right_context_vectors (
 
 // ----------------------------------------------------------------------------------------
 
-template <typename tokenizer_type>
+class context_sampler
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object draws a uniform random sample of the context windows in a
+            corpus_cache using several threads.  The windows are split into contiguous
+            shards and each shard is reservoir sampled by its own thread with its own
+            random_subset_selector.
+
+            To make the union of the shard samples a uniform sample of the whole corpus,
+            each shard has to contribute the number of windows a uniform sample would
+            have drawn from it.  Since we know the size of every shard up front, we draw
+            those numbers before sampling, by simulating the draws of a uniform sample
+            without replacement.  Each shard's reservoir is then sized to exactly its
+            share.  This also means the reservoirs together never hold more than the
+            requested number of contexts.
+    !*/
+
+public:
+
+    typedef std::pair<sparse_vector_type, sparse_vector_type> context_type;
+
+    context_sampler (
+        const unsigned long vocab_size_,
+        const unsigned long window_size_,
+        const corpus_cache& corpus_,
+        const unsigned long num_contexts,
+        const unsigned long num_shards
+    ) : vocab_size(vocab_size_), window_size(window_size_), corpus(corpus_),
+        shards(num_shards)
+    {
+        // window i is the window ending at token i+window_size-1
+        const uint64 num_windows = corpus.size() >= window_size ? corpus.size()-window_size+1 : 0;
+        std::vector<uint64> remaining(num_shards);
+        for (unsigned long i = 0; i < num_shards; ++i)
+        {
+            shard_begin.push_back(num_windows*i/num_shards);
+            remaining[i] = num_windows*(i+1)/num_shards - shard_begin[i];
+        }
+        shard_begin.push_back(num_windows);
+
+        std::vector<unsigned long> quota(num_shards, 0);
+        if (num_windows <= num_contexts)
+        {
+            // everything gets used
+            for (unsigned long i = 0; i < num_shards; ++i)
+                quota[i] = remaining[i];
+        }
+        else
+        {
+            dlib::rand rnd;
+            uint64 total = num_windows;
+            for (unsigned long k = 0; k < num_contexts; ++k)
+            {
+                uint64 r = rnd.get_random_64bit_number()%total;
+                unsigned long j = 0;
+                while (r >= remaining[j])
+                {
+                    r -= remaining[j];
+                    ++j;
+                }
+                --remaining[j];
+                --total;
+                ++quota[j];
+            }
+        }
+
+        for (unsigned long i = 0; i < num_shards; ++i)
+        {
+            shards[i].set_seed(cast_to_string(i));
+            shards[i].set_max_size(quota[i]);
+        }
+    }
+
+    void sample_shard (
+        long idx
+    )
+    {
+        random_subset_selector<context_type>& contexts = shards[idx];
+        context_type temp;
+        for (uint64 i = shard_begin[idx]; i < shard_begin[idx+1]; ++i)
+        {
+            if (contexts.next_add_accepts())
+            {
+                get_left_and_right_context_vectors(vocab_size, corpus.begin()+i, window_size, temp.first, temp.second);
+                contexts.add(temp);
+            }
+            else
+            {
+                contexts.add();
+            }
+        }
+    }
+
+    void get_contexts (
+        std::vector<sparse_vector_type>& left,
+        std::vector<sparse_vector_type>& right
+    )
+    /*!
+        requires
+            - all the shards have been sampled.
+        ensures
+            - moves the sampled contexts into left and right.
+    !*/
+    {
+        left.clear();
+        right.clear();
+        for (unsigned long i = 0; i < shards.size(); ++i)
+        {
+            for (unsigned long j = 0; j < shards[i].size(); ++j)
+            {
+                left.push_back(sparse_vector_type());
+                right.push_back(sparse_vector_type());
+                left.back().swap(shards[i][j].first);
+                right.back().swap(shards[i][j].second);
+            }
+            // free RAM
+            shards[i].set_max_size(0);
+        }
+    }
+
+private:
+
+    const unsigned long vocab_size;
+    const unsigned long window_size;
+    const corpus_cache& corpus;
+    std::vector<uint64> shard_begin;
+    std::vector<random_subset_selector<context_type> > shards;
+};
+
+// ----------------------------------------------------------------------------------------
+
 void do_cca_on_windows (
-    const std::map<std::string, unsigned long>& vocab,
+    const unsigned long vocab_size,
     const long window_size,
-    const long num_contexts,
+    const unsigned long num_contexts,
     const long num_correlations,
-    tokenizer_type& tok,
+    const unsigned long num_threads,
+    const corpus_cache& corpus,
     matrix<float>& Ltrans,
     matrix<float>& Rtrans
 )
 {
-    tok.reset();
+    cout << "Sample " << num_contexts << " random context vectors using " << num_threads << " threads" << endl;
+    std::vector<sparse_vector_type> left, right;
+    {
+        context_sampler sampler(vocab_size, window_size, corpus, num_contexts, num_threads);
+        parallel_for(num_threads, 0, num_threads, sampler, &context_sampler::sample_shard, 1);
+        sampler.get_contexts(left, right);
+    }
+    
+    cout << "Now do CCA (left size: " << left.size() << ", right size: " << right.size() << ")." << endl;
+    cout << "correlations: "<< trans(cca(left, right, Ltrans, Rtrans, num_correlations, 40, 5));
+    //print_true_correlations(left, right, Ltrans, Rtrans);
+}
 
-    random_subset_selector<sparse_vector_type> left_contexts, right_contexts;
-    left_contexts.set_max_size(num_contexts);
-    right_contexts.set_max_size(num_contexts);
+// ----------------------------------------------------------------------------------------
 
+class context_vector_accumulator
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object sums up the CCA projected context vectors of every window in a
+            corpus_cache, grouped by center word, using several threads.
+
+            Since a context vector is a sparse vector with a single 1 in each window
+            slot, its projection by trans(Ltrans) is just the sum of the rows of Ltrans
+            for the words in those slots.  That is, row s*(vocab_size+1)+w of Ltrans is
+            the precomputed projection of word w appearing in slot s.  So each window
+            costs a few row additions and no memory allocations.
+
+            The windows in the range given to set_window_range() are split into
+            contiguous shards.  Each shard accumulates into its own dense vocab_size by
+            (Ltrans.nc()+Rtrans.nc()) matrix, so the threads never touch the same
+            memory.  The shards are summed into the first one by sum_shards(), which
+            gives the totals for all the ranges accumulated so far.
+    !*/
+
+public:
+
+    context_vector_accumulator (
+        const unsigned long vocab_size_,
+        const unsigned long window_size_,
+        const corpus_cache& corpus_,
+        const matrix<float>& Ltrans_,
+        const matrix<float>& Rtrans_,
+        const unsigned long num_shards
+    ) : vocab_size(vocab_size_), window_size(window_size_), corpus(corpus_),
+        Ltrans(Ltrans_), Rtrans(Rtrans_), sums(num_shards), hits(num_shards)
+    {
+        for (unsigned long i = 0; i < num_shards; ++i)
+        {
+            sums[i].set_size(vocab_size, Ltrans.nc()+Rtrans.nc());
+            sums[i] = 0;
+            hits[i].assign(vocab_size, 0);
+        }
+        set_window_range(0, num_windows());
+    }
 
-    dlib::circular_buffer<std::string> buf;
-    buf.resize(window_size);
+    uint64 num_windows (
+    ) const { return corpus.size() >= window_size ? corpus.size()-window_size+1 : 0; }
+
+    void set_window_range (
+        uint64 begin,
+        uint64 end
+    )
+    /*!
+        requires
+            - begin <= end <= num_windows()
+        ensures
+            - the next calls to accumulate_shard() will add up the windows begin
+              through end-1.
+    !*/
+    {
+        shard_begin.clear();
+        for (unsigned long i = 0; i <= sums.size(); ++i)
+            shard_begin.push_back(begin + (end-begin)*i/sums.size());
+    }
 
-    sparse_vector_type left_vect, right_vect;
-    cout << "Sample " << num_contexts << " random context vectors" << endl;
+    const matrix<float>& get_sums (
+    ) const { return sums[0]; }
+
+    const std::vector<uint64>& get_hits (
+    ) const { return hits[0]; }
+
+    void set_totals (
+        const matrix<float>& sums_,
+        const std::vector<uint64>& hits_
+    )
+    /*!
+        requires
+            - sums_ and hits_ came from get_sums() and get_hits() of an accumulator with
+              the same arguments.
+        ensures
+            - continues from those totals, so the windows they include shouldn't be
+              accumulated again.
+    !*/
+    {
+        sums[0] = sums_;
+        hits[0] = hits_;
+    }
 
-    std::string token;
-    uint64 count = 0;
-    while (tok(token))
+    void accumulate_shard (
+        long idx
+    )
     {
-        buf.push_back(token);
-        // skip the rest of the loop if buf isn't full yet
-        ++count;
-        if (count < buf.size())
+        const long dl = Ltrans.nc();
+        const long dr = Rtrans.nc();
+        if (dl+dr == 0)
+            return;
+
+        matrix<float>& sum = sums[idx];
+        std::vector<uint64>& hit = hits[idx];
+        std::vector<float> temp(dl+dr);
+        for (uint64 i = shard_begin[idx]; i < shard_begin[idx+1]; ++i)
         {
-            continue;
+            const dlib::uint32* window = corpus.begin()+i;
+            const dlib::uint32 center_word = window[window_size/2];
+            // only consider words in the vocab
+            if (center_word >= vocab_size)
+                continue;
+
+            // Add up the window's context vector in temp before adding it into the
+            // running sum.  The sums for common words get very large so this loses a
+            // lot less precision than adding each row into them directly.
+            std::fill(temp.begin(), temp.end(), 0);
+            for (unsigned long s = 0; s < window_size/2; ++s)
+                add_row(&temp[0], Ltrans, s*(vocab_size+1) + get_word_id(vocab_size, window[s]));
+            unsigned long k = 0;
+            for (unsigned long s = window_size/2+1; s < window_size; ++s, ++k)
+                add_row(&temp[dl], Rtrans, k*(vocab_size+1) + get_word_id(vocab_size, window[s]));
+
+            float* out = &sum(center_word,0);
+            for (long j = 0; j < dl+dr; ++j)
+                out[j] += temp[j];
+            hit[center_word] += 1;
         }
+    }
 
-        if (left_contexts.next_add_accepts())
+    void sum_shards (
+        long row
+    )
+    /*!
+        ensures
+            - adds row of all the shard sums into the first shard and sets it to 0 in
+              the other shards.
+    !*/
+    {
+        for (unsigned long i = 1; i < sums.size(); ++i)
         {
-            get_left_and_right_context_vectors(vocab, buf, left_vect, right_vect);
-            left_contexts.add(left_vect);
-            right_contexts.add(right_vect);
+            set_rowm(sums[0],row) += rowm(sums[i],row);
+            set_rowm(sums[i],row) = 0;
+            hits[0][row] += hits[i][row];
+            hits[i][row] = 0;
         }
-        else
+    }
+
+    void get_word_vectors (
+        std::map<std::string, matrix<float,0,1> >& word_vectors
+    ) const
+    /*!
+        requires
+            - all the shards have been accumulated and then summed with sum_shards().
+        ensures
+            - #word_vectors == a map from each vocabulary word with at least one window
+              to the average of its projected context vectors.
+    !*/
+    {
+        word_vectors.clear();
+        const std::vector<std::string>& vocab = corpus.get_vocabulary();
+        for (unsigned long i = 0; i < vocab_size; ++i)
         {
-            left_contexts.add();
-            right_contexts.add();
+            if (hits[0][i] == 0)
+                continue;
+            word_vectors[vocab[i]] = trans(rowm(sums[0],i))/hits[0][i];
         }
     }
 
-    std::vector<sparse_vector_type> left(left_contexts.begin(), left_contexts.end());
-    std::vector<sparse_vector_type> right(right_contexts.begin(), right_contexts.end());
-    // free RAM
-    left_contexts.set_max_size(0);
-    right_contexts.set_max_size(0);
-    
-    cout << "Now do CCA (left size: " << left.size() << ", right size: " << right.size() << ")." << endl;
-    cout << "correlations: "<< trans(cca(left, right, Ltrans, Rtrans, num_correlations, 40, 5));
-    //print_true_correlations(left, right, Ltrans, Rtrans);
+private:
+
+    static void add_row (
+        float* out,
+        const matrix<float>& m,
+        const unsigned long row
+    )
+    {
+        const float* in = &m(row,0);
+        for (long j = 0; j < m.nc(); ++j)
+            out[j] += in[j];
+    }
+
+    const unsigned long vocab_size;
+    const unsigned long window_size;
+    const corpus_cache& corpus;
+    const matrix<float>& Ltrans;
+    const matrix<float>& Rtrans;
+    std::vector<uint64> shard_begin;
+    std::vector<matrix<float> > sums;
+    std::vector<std::vector<uint64> > hits;
+};
+
+// ----------------------------------------------------------------------------------------
+
+void save_word_vects_checkpoint (
+    const std::string& filename,
+    const std::string& problem,
+    const std::string& cca_hash,
+    const uint64 windows_done,
+    const matrix<float>& sums,
+    const std::vector<uint64>& hits
+)
+{
+    checkpoint_file_writer writer(filename);
+    serialize(std::string("wordrep::word_vects_checkpoint"), writer.stream());
+    serialize(1, writer.stream());
+    serialize(problem, writer.stream());
+    serialize(cca_hash, writer.stream());
+    serialize(windows_done, writer.stream());
+    serialize(sums, writer.stream());
+    serialize(hits, writer.stream());
+    writer.commit();
+}
+
+bool load_word_vects_checkpoint (
+    const std::string& filename,
+    const std::string& problem,
+    std::string& cca_hash,
+    uint64& windows_done,
+    matrix<float>& sums,
+    std::vector<uint64>& hits
+)
+/*!
+    ensures
+        - if (filename holds a checkpoint saved by save_word_vects_checkpoint() for the
+          same problem) then
+            - loads it into the other arguments.
+            - returns true
+        - else
+            - returns false
+!*/
+{
+    ifstream fin(filename.c_str(), ios::binary);
+    if (!fin)
+        return false;
+    try
+    {
+        std::string classname, saved_problem;
+        int version = 0;
+        deserialize(classname, fin);
+        deserialize(version, fin);
+        if (classname != "wordrep::word_vects_checkpoint" || version != 1)
+            return false;
+        deserialize(saved_problem, fin);
+        if (saved_problem != problem)
+            return false;
+        deserialize(cca_hash, fin);
+        deserialize(windows_done, fin);
+        deserialize(sums, fin);
+        deserialize(hits, fin);
+        return true;
+    }
+    catch (serialization_error&)
+    {
+        cout << "Ignoring unreadable " << filename << endl;
+        return false;
+    }
 }
 
 // ----------------------------------------------------------------------------------------
 
-template <typename tokenizer_type>
 void get_average_context_window_vector_per_word (
-    const std::map<std::string, unsigned long>& vocab,
+    const unsigned long vocab_size,
     const long window_size,
-    tokenizer_type& tok,
+    const unsigned long num_threads,
+    const corpus_cache& corpus,
     const matrix<float>& Ltrans,
     const matrix<float>& Rtrans,
+    const uint64 windows_per_checkpoint,
+    const std::string& checkpoint_file,
+    const std::string& problem,
+    const std::string& cca_hash,
+    uint64 windows_done,
+    matrix<float>& sums,
+    std::vector<uint64>& hits,
     std::map<std::string, matrix<float,0,1> >& word_vectors
 )
+/*!
+    requires
+        - windows_per_checkpoint > 0
+    ensures
+        - #word_vectors == the average projected context vector of each word.
+        - The windows before windows_done have already been added up in sums and hits.
+          Every windows_per_checkpoint windows after that the totals are saved with
+          save_word_vects_checkpoint().
+!*/
 {
-    tok.reset();
-    word_vectors.clear();
-
-    std::map<std::string,long> word_hits;
-    dlib::circular_buffer<std::string> buf;
-    buf.resize(window_size);
-
-    sparse_vector_type left_vect, right_vect;
-
-    std::string token;
-    unsigned long count = 1;
-    while (tok(token))
-    {
-        buf.push_back(token);
-        // skip the rest of the loop if buf isn't full yet
-        if (count < buf.size())
-        {
-            ++count;
-            continue;
-        }
-
-        const std::string& center_word = buf[buf.size()/2];
-        // only consider words in the vocab
-        if (vocab.count(center_word) == 0)
-            continue;
-
-        get_left_and_right_context_vectors(vocab, buf, left_vect, right_vect);
-        word_vectors[center_word] += join_cols(sparse_matrix_vector_multiply(trans(Ltrans), left_vect),
-                                               sparse_matrix_vector_multiply(trans(Rtrans), right_vect));
-        word_hits[center_word] += 1;
-    }
-
+    context_vector_accumulator acc(vocab_size, window_size, corpus, Ltrans, Rtrans, num_threads);
+    if (windows_done != 0)
+        acc.set_totals(sums, hits);
+    sums.set_size(0,0);
+    hits.clear();
 
-    // Divide all the word vectors by their hits so they are mean vectors
-    for (std::map<std::string,long>::iterator i = word_hits.begin(); i != word_hits.end(); ++i)
+    while (windows_done < acc.num_windows())
     {
-        if (i->second > 1)
+        const uint64 end = std::min(acc.num_windows(), windows_done + windows_per_checkpoint);
+        acc.set_window_range(windows_done, end);
+        parallel_for(num_threads, 0, num_threads, acc, &context_vector_accumulator::accumulate_shard, 1);
+        parallel_for(num_threads, 0, vocab_size, acc, &context_vector_accumulator::sum_shards);
+        windows_done = end;
+        if (windows_done < acc.num_windows())
         {
-            word_vectors[i->first] /= i->second;
+            save_word_vects_checkpoint(checkpoint_file, problem, cca_hash, windows_done, acc.get_sums(), acc.get_hits());
+            cout << "Averaged " << windows_done << " of " << acc.num_windows() << " windows, saved " << checkpoint_file << endl;
         }
     }
+    acc.get_word_vectors(word_vectors);
 }
 
 // ----------------------------------------------------------------------------------------
@@ -205,33 +546,122 @@ std::map<std::string, unsigned long> make_word_to_int_mapping (
 
 // ----------------------------------------------------------------------------------------
 
-void word_vects(const dlib::command_line_parser& parser)
+void save_word_vects_cca (
+    const std::string& filename,
+    const long window_size,
+    const std::vector<std::string>& vocab,
+    const matrix<float>& Ltrans,
+    const matrix<float>& Rtrans
+)
 {
-    const long vocab_size = 200000;
-    const long window_size = 9;
-    const long num_contexts = 50000000;
-    const long num_correlations = 90;
+    std::ofstream fout(filename.c_str(), ios::binary);
+    serialize(std::string("wordrep::word_vects_cca"), fout);
+    serialize(1, fout);
+    serialize(window_size, fout);
+    serialize(vocab, fout);
+    serialize(Ltrans, fout);
+    serialize(Rtrans, fout);
+}
 
-    ifstream fin("top_word_counts.dat", ios::binary);
-    std::map<std::string, unsigned long> words;
-    deserialize(words, fin);
+void load_word_vects_cca (
+    const std::string& filename,
+    long& window_size,
+    std::vector<std::string>& vocab,
+    matrix<float>& Ltrans,
+    matrix<float>& Rtrans
+)
+{
+    std::ifstream fin(filename.c_str(), ios::binary);
+    if (!fin)
+        throw serialization_error("Unable to open " + filename + ".  It is made by --word-vects.");
+    std::string classname;
+    int version = 0;
+    deserialize(classname, fin);
+    deserialize(version, fin);
+    if (classname != "wordrep::word_vects_cca" || version != 1)
+        throw serialization_error("Unexpected contents found in " + filename);
+    deserialize(window_size, fin);
+    deserialize(vocab, fin);
+    deserialize(Ltrans, fin);
+    deserialize(Rtrans, fin);
+}
 
-    words = make_word_to_int_mapping(words,vocab_size);
+// ----------------------------------------------------------------------------------------
 
-    std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
-    cout << "number of raw ASCII files found: " << files.size() << endl;
-    group_tokenizer<unigram_tokenizer> tok(files);
+void word_vects(const dlib::command_line_parser& parser)
+{
+    const unsigned long max_vocab_size = 200000;
+    const long window_size = 9;
+    const unsigned long default_num_contexts = 50000000;
+    const unsigned long num_contexts = get_option(parser, "cca-contexts", default_num_contexts);
+    const long num_correlations = 90;
 
+    // The corpus cache gives the top words the IDs 0, 1, 2, etc. so this restricts us
+    // to the max_vocab_size most common words.
+    corpus_cache corpus(parser);
+    const unsigned long vocab_size = std::min<unsigned long>(max_vocab_size, corpus.get_vocabulary().size());
+
+    const unsigned long num_threads = get_option(parser, "threads", 4);
+    // The corpus cache doesn't remember where one file ends and the next starts, so
+    // --checkpoint-every counts files' worth of windows, going by the average file.
+    const uint64 windows_per_file = std::max<uint64>(1, corpus.size()/std::max<uint64>(1, corpus.get_num_files()));
+    const uint64 windows_per_checkpoint = get_option(parser, "checkpoint-every", 1000)*windows_per_file;
+
+    const std::string cca_file = get_work_file(parser, "word_vects_cca.dat");
+    const std::string checkpoint_file = get_work_file(parser, "word_vects.checkpoint");
+    std::ostringstream sout;
+    sout << corpus.get_signature() << " " << corpus.size() << " " << vocab_size << " " << window_size << " "
+         << num_contexts << " " << num_correlations << " " << parser.option("stream-cca");
+    const std::string problem = sout.str();
+
+    // The checkpoint only records the hash of the CCA output, so it is only good as
+    // long as word_vects_cca.dat is unchanged.
     matrix<float> Ltrans, Rtrans;
-    do_cca_on_windows(words, window_size,  num_contexts, num_correlations, tok, Ltrans, Rtrans);
+    std::string cca_hash;
+    uint64 windows_done = 0;
+    matrix<float> sums;
+    std::vector<uint64> hits;
+    if (load_word_vects_checkpoint(checkpoint_file, problem, cca_hash, windows_done, sums, hits) &&
+        get_file_hash(cca_file) == cca_hash)
+    {
+        long saved_window_size;
+        std::vector<std::string> saved_vocab;
+        load_word_vects_cca(cca_file, saved_window_size, saved_vocab, Ltrans, Rtrans);
+        cout << "Resuming word vectors from " << checkpoint_file << " after " << windows_done << " windows" << endl;
+    }
+    else
+    {
+        windows_done = 0;
+        if (parser.option("stream-cca"))
+        {
+            const matrix<float,0,1> correlations = streaming_cca_on_windows(corpus, vocab_size, window_size, num_contexts,
+                                                                            num_correlations, num_threads, Ltrans, Rtrans,
+                                                                            get_work_file(parser, "streaming_cca.checkpoint"),
+                                                                            windows_per_checkpoint);
+            cout << "correlations: "<< trans(correlations);
+        }
+        else
+        {
+            do_cca_on_windows(vocab_size, window_size,  num_contexts, num_correlations, num_threads, corpus, Ltrans, Rtrans);
+        }
+        // Keep the projections so --extend-vocab can make vectors for new words later.
+        const std::vector<std::string> vocab(corpus.get_vocabulary().begin(), corpus.get_vocabulary().begin()+vocab_size);
+        save_word_vects_cca(cca_file, window_size, vocab, Ltrans, Rtrans);
+        cca_hash = get_file_hash(cca_file);
+        save_word_vects_checkpoint(checkpoint_file, problem, cca_hash, windows_done, sums, hits);
+    }
     cout << "CCA done, now build up average word vectors" << endl;
 
     std::map<std::string, matrix<float,0,1> > word_vectors;
-    get_average_context_window_vector_per_word(words, window_size, tok, Ltrans, Rtrans, word_vectors);
+    get_average_context_window_vector_per_word(vocab_size, window_size, num_threads, corpus, Ltrans, Rtrans,
+                                               windows_per_checkpoint, checkpoint_file, problem, cca_hash,
+                                               windows_done, sums, hits, word_vectors);
 
-    std::ofstream fout("word_vects.dat", ios::binary);
-    serialize(word_vectors, fout);
+    {
+        std::ofstream fout(get_work_file(parser, "word_vects.dat").c_str(), ios::binary);
+        serialize(word_vectors, fout);
+    }
+    std::remove(checkpoint_file.c_str());
 }
 
 // ----------------------------------------------------------------------------------------
-
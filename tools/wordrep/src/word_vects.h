@@ -5,9 +5,53 @@
 #define MIT_LL_WORD_VEcTS_H_
 
 #include <dlib/cmd_line_parser.h>
+#include <dlib/matrix.h>
+#include <map>
+#include <string>
+#include <vector>
 
 void word_vects(const dlib::command_line_parser& parser);
 
+std::map<std::string, unsigned long> make_word_to_int_mapping (
+    const std::map<std::string, unsigned long>& words,
+    unsigned long num
+);
+/*!
+    ensures
+        - returns a map from each of the num most common words in words to an integer
+          ID.  The most common word gets ID 0, the next most common ID 1, and so on.
+!*/
+
+void save_word_vects_cca (
+    const std::string& filename,
+    const long window_size,
+    const std::vector<std::string>& vocab,
+    const dlib::matrix<float>& Ltrans,
+    const dlib::matrix<float>& Rtrans
+);
+/*!
+    ensures
+        - saves the CCA projections made by word_vects() to the given file, along with
+          what is needed to turn a context window into the features they project.  That
+          is, vocab[i] is the word with ID i, all other words have ID vocab.size(), and a
+          word with ID w in slot s of the left (right) half of a window is feature
+          s*(vocab.size()+1)+w of the left (right) context vector.
+!*/
+
+void load_word_vects_cca (
+    const std::string& filename,
+    long& window_size,
+    std::vector<std::string>& vocab,
+    dlib::matrix<float>& Ltrans,
+    dlib::matrix<float>& Rtrans
+);
+/*!
+    ensures
+        - loads the data saved by save_word_vects_cca().
+        - throws dlib::serialization_error if filename isn't a file made by
+          save_word_vects_cca().
+!*/
+
 #endif // MIT_LL_WORD_VEcTS_H_
 
 